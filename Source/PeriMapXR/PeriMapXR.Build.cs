@@ -13,15 +13,28 @@ public class PeriMapXR : ModuleRules
             { 
                 "InputCore",
                 "HeadMountedDisplay", 
-                "EyeTracker", 
-                "PICOXREyeTracker", 
-                "PICOXRHMD", 
-                "PICOXRInput", 
-                "PICOXRMR", 
-                "PICOXRMotionTracking" 
+                "EyeTracker"
             }
         );
 
+        // The PICO plugins only ship for the headset and the Windows editor. A Linux build agent builds without
+        // them, which leaves ATestStimuli with no eye tracker: it runs in demo mode or headless (-PeriMapXRHeadless)
+        bool bWithPico = Target.Platform == UnrealTargetPlatform.Android || Target.Platform == UnrealTargetPlatform.Win64;
+        if (bWithPico)
+        {
+            PublicDependencyModuleNames.AddRange(
+                new string[]
+                {
+                    "PICOXREyeTracker",
+                    "PICOXRHMD",
+                    "PICOXRInput",
+                    "PICOXRMR",
+                    "PICOXRMotionTracking"
+                }
+            );
+        }
+        PublicDefinitions.Add("PERIMAPXR_WITH_PICO=" + (bWithPico ? "1" : "0"));
+
         PrivateDependencyModuleNames.AddRange(
             new string[] 
             {  
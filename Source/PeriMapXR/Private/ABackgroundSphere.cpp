@@ -10,8 +10,8 @@
 // Sets default values
 ABackgroundSphere::ABackgroundSphere()
 {
-    // Set actor to call Tick() every frame
-    PrimaryActorTick.bCanEverTick = true;
+    // No per-frame work: the test attaches the background to its head-locked rig
+    PrimaryActorTick.bCanEverTick = false;
 
     // Create and attach the static mesh component
     MeshComponent = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("MeshComponent"));
@@ -64,12 +64,6 @@ void ABackgroundSphere::BeginPlay()
     }
 }
 
-// Called every frame
-void ABackgroundSphere::Tick(float DeltaTime)
-{
-    Super::Tick(DeltaTime);
-}
-
 void ABackgroundSphere::SetScale(float Diameter)
 {
     if (MeshComponent)
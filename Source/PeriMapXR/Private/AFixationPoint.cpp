@@ -3,7 +3,6 @@
 #include "AFixationPoint.h"
 #include "Components/StaticMeshComponent.h"
 #include "Materials/MaterialInstanceDynamic.h"
-#include "GameFramework/PlayerController.h"
 #include "UObject/ConstructorHelpers.h"
 #include "Engine/StaticMesh.h"
 #include "Engine/World.h"
@@ -12,8 +11,8 @@
 // Sets default values
 AFixationPoint::AFixationPoint()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+    // No per-frame work: the test attaches the fixation point to its head-locked rig
+	PrimaryActorTick.bCanEverTick = false;
 
     // Create and set up the static mesh component
     MeshComponent = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("MeshComponent"));
@@ -61,34 +60,7 @@ void AFixationPoint::BeginPlay()
 {
     Super::BeginPlay();
 
-    // Initialize the position based on the player's view
-    if (APlayerController* PlayerController = GetWorld()->GetFirstPlayerController())
-    {
-        FVector PlayerViewLocation;
-        FRotator PlayerViewRotation;
-        PlayerController->GetPlayerViewPoint(PlayerViewLocation, PlayerViewRotation);
-
-        // Set the initial fixation point position in front of the player's view
-        FVector FixationPointPosition = PlayerViewLocation + PlayerViewRotation.Vector() * DistanceFromPlayer;
-        SetActorLocation(FixationPointPosition);
-    }
-}
-
-// Called every frame
-void AFixationPoint::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-
-    if (APlayerController* PlayerController = GetWorld()->GetFirstPlayerController())
-    {
-        FVector PlayerViewLocation;
-        FRotator PlayerViewRotation;
-        PlayerController->GetPlayerViewPoint(PlayerViewLocation, PlayerViewRotation);
-
-        // Set the fixation point position in front of the player's view
-        FVector FixationPointPosition = PlayerViewLocation + PlayerViewRotation.Vector() * DistanceFromPlayer;
-        SetActorLocation(FixationPointPosition);
-    }
+    // Placement is left to the test, which spawns the fixation point in front of the camera and locks it to the head
 }
 
 void AFixationPoint::SetScale(float DesiredDiameter)
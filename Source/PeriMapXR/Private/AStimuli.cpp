@@ -12,8 +12,8 @@
 // Sets default values
 AStimuli::AStimuli()
 {
-    // Set this actor to call Tick() every frame
-    PrimaryActorTick.bCanEverTick = true;
+    // No per-frame work: the test attaches stimuli to its head-locked rig
+    PrimaryActorTick.bCanEverTick = false;
 
     // Initialize max luminance and brightness values
     MaxLuminanceNits = 60.0f; // Max luminance of the Pico 4 in nits
@@ -77,12 +77,6 @@ void AStimuli::BeginPlay()
     }
 }
 
-// Called every frame
-void AStimuli::Tick(float DeltaTime)
-{
-    Super::Tick(DeltaTime);
-}
-
 // Function to set the scale of the visual stimulus
 void AStimuli::SetScale(float DesiredDiameter)
 {
@@ -2,19 +2,30 @@
 
 #include "ATestStimuli.h"
 #include "UThresholdEstimator.h"
-#include "AStimuli.h"
+#include "UStimulusFieldComponent.h"
+#include "FStimulusGridLibrary.h"
 #include "AFixationPoint.h"
 #include "ABackgroundSphere.h"
-#include "FTestResults.h"
 #include "Engine/World.h"
 #include "GameFramework/PlayerController.h"
+#include "GameFramework/WorldSettings.h"
 #include "Kismet/GameplayStatics.h"
 #include "TimerManager.h"
+#if PERIMAPXR_WITH_PICO
 #include "PXR_MotionTracking.h"
 #include "PXR_MotionTrackingTypes.h" 
 #include "PXR_HMDFunctionLibrary.h"
+#endif
 #include "EyeTrackerFunctionLibrary.h"
 #include "Camera/CameraComponent.h"
+#include "Components/SceneComponent.h"
+#include "Async/Async.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/Parse.h"
+#include "CoreGlobals.h"
+#include "HAL/PlatformTime.h"
 #include "FLogManager.h"
 
 // Constructor sets default values for properties and initializes eye tracking and test settings
@@ -25,14 +36,65 @@ ATestStimuli::ATestStimuli()
     TestState = ETestState::Idle;     // The test starts in the idle state, no stimuli presented initially
     StimuliDuration = 0.2f;           // Default duration of each stimulus, set to 200ms for visual threshold assessment
     TimeBetweenStimuli = 1.0f;        // Time between stimuli presentation to prevent overlap
+    ResponseWindowSeconds = 1.0f;     // Presses up to 1s after onset count as seen, covering slow reaction times
+    bAdvanceOnResponse = true;        // A press ends the response window at once rather than waiting it out
+    MinResponseSeconds = 0.15f;       // No window closes sooner than 150ms after onset
+    bAdaptResponseWindow = true;      // Fit the window to the participant once their reaction times are known
+    ResponseWindowPercentile = 0.95f; // Wait out 95% of the participant's reaction times...
+    ResponseWindowMarginSeconds = 0.15f;  // ...plus 150ms
+    MinAdaptiveResponseWindowSeconds = 0.5f;
+    MinReactionTimesForAdaptation = 10;
+    TrialPresentationIndex = INDEX_NONE;
     RetestCount = 3;                  // Number of retests for stimuli near threshold to ensure accuracy
     RetestProbability = 0.1f;         // Probability that a stimulus is retested
     bIsDemoMode = false;              // By default, the demo mode is disabled; real eye-tracking data is used
+    bHeadlessDriver = false;          // A participant in a headset runs the test unless -PeriMapXRHeadless says otherwise
+    HeadlessTimeDilation = 10.0f;     // A 0.2s stimulus still spans two headless frames
+    HeadlessSeed = 1;
+    bExitAfterHeadlessRun = true;
+    HeadlessStartWallSeconds = 0.0;
+    HeadlessStartWorldSeconds = 0.0;
+    HeadlessGameThreadCycles = 0;
+    HeadlessNumFrames = 0;
+    HeadlessFrameStartCycles = 0;
+    NumSessionTrials = 0;
     bIsLeftEye = true;                // Start with the left eye, as is standard in most vision tests
     ConsecutiveMisses = 0;            // Track missed stimuli to adjust the test dynamically
-    ConsistentResponsesCount = 0;     // Track consistent responses to adjust test speed
-    FalsePositiveCount = 0;           // Count of false positives to detect unreliable responses
     DetectedLatency = 0.0f;           // Initialize latency tracking to zero
+    bUserResponded = false;           // No response before the first stimulus
+    FixationActor = nullptr;          // The scene actors are spawned by the first SetupTest and reused after it
+    ConvergingLinesActor = nullptr;
+    BackgroundSphereActor = nullptr;
+    SessionActorCount = INDEX_NONE;
+    CurrentStimulusIntensityInDb = 0.0f;
+    StimulusOnsetSeconds = 0.0;
+    CurrentResponseWindowSeconds = 0.0f;
+    PreparedStimulusIndex = INDEX_NONE;  // Nothing prepared ahead of the first flash
+    PreparedStimulusIntensityInDb = 0.0f;
+    NumResponseWindows = 0;           // Response pipeline statistics, reported per eye
+    NumEarlyResponseWindows = 0;
+    ResponseSecondsSaved = 0.0;
+    SeenResponseWindowSeconds = 0.0;
+    NumSeenResponseWindows = 0;
+    NumInvalidatedTrials = 0;
+    NumInvalidatedCatchTrials = 0;
+    FixationToleranceDegrees = 10.0f;       // Gaze within 10 degrees of the fixation point counts as fixating
+    FalsePositiveCatchProbability = 0.1f;   // About one gap in ten checks for presses with nothing shown
+    FalseNegativeCatchProbability = 0.05f;  // About one gap in twenty re-shows a seen location well above threshold
+    FalseNegativeCatchOffsetInDb = 9.0f;    // 9 dB brighter than the dimmest intensity seen there
+    CatchTrialGuardSeconds = 0.3f;          // Late presses for the previous stimulus land before the catch trial opens
+    MaxFalsePositiveRate = 0.15f;           // Usual limits for a reliable field
+    MaxFalseNegativeRate = 0.33f;
+    MinCatchTrialsForReliability = 3;
+    bStopWhenUnreliable = false;            // Flag an unreliable eye and leave stopping it to the operator
+    ActiveCatchTrial = ECatchTrialType::None;
+    bCatchTrialResponded = false;
+    CatchStimulusIndex = INDEX_NONE;
+    CatchPresentationIndex = INDEX_NONE;
+    CatchTrialOpenCycles = 0;
+    CatchTrialOpenFrame = 0;
+    bEnableTrialJournal = true;             // Every presentation reaches disk within half a second of its outcome
+    TrialJournalSyncIntervalSeconds = 0.5f;
     bEnableConsoleMessages = true;    // Enable debug messages on the console
     bEnableOnScreenMessages = true;   // Enable debug messages to the screen
     bEnableSaveToLog = true;          // Enable debug messages to be saved to the logfile on the headset
@@ -44,6 +106,27 @@ ATestStimuli::ATestStimuli()
     // Predefine settings for different test types (e.g., 24-2 and 10-2), defining degrees and spacing between stimuli
     TestSettingsMap.Add(ETestType::TEST_10_2, FTestSettings(55.0f, 2.0f, 0.5f, 6.0f, 68, 15.0f, 15.0f));
     TestSettingsMap.Add(ETestType::TEST_24_2, FTestSettings(133.5f, 2.0f, 0.5f, 6.0f, 54, 24.0f, 24.0f));
+    TestSettingsMap.Add(ETestType::TEST_24_2C, FTestSettings(133.5f, 2.0f, 0.5f, 6.0f, 64, 24.0f, 24.0f));
+    TestSettingsMap.Add(ETestType::TEST_30_2, FTestSettings(133.5f, 2.0f, 0.5f, 6.0f, 76, 30.0f, 30.0f));
+    TestSettingsMap.Add(ETestType::TEST_CUSTOM, FTestSettings(133.5f, 2.0f, 0.5f, 6.0f, 0, 30.0f, 30.0f));
+    bSkipBlindSpotPoints = false;     // Test the blind-spot points like the standard patterns do
+    bScreeningMode = false;           // Threshold the whole grid unless a screening is asked for
+    PatientAgeInYears = 50.0f;
+    bThresholdScreeningDefects = false;
+
+    // Nothing in the test moves per frame: the rig follows the HMD camera it is attached to.
+    // The actor only ticks while a stimulus is on screen, to count the frames it is shown for
+    PrimaryActorTick.bCanEverTick = true;
+    PrimaryActorTick.bStartWithTickEnabled = false;
+    RefreshRate = 90.0f;              // Pico 4 display refresh rate; 0.2s stimuli are shown for 18 frames
+    RefreshRateTolerance = 0.1f;      // A 90 Hz display measured slower than 81 Hz or faster than 99 Hz is reported
+    MeasuredFrameSeconds = 0.0;
+    NumMeasuredFrames = 0;
+    ActivePresentationIndex = INDEX_NONE;
+    StimulusRig = CreateDefaultSubobject<USceneComponent>(TEXT("StimulusRig"));
+    RootComponent = StimulusRig;
+    StimulusField = CreateDefaultSubobject<UStimulusFieldComponent>(TEXT("StimulusField"));
+    StimulusField->SetupAttachment(StimulusRig);
 
     // Initialize ThresholdEstimator for tracking and managing threshold estimation
     ThresholdEstimator = CreateDefaultSubobject<UThresholdEstimator>(TEXT("ThresholdEstimator"));
@@ -60,67 +143,206 @@ void ATestStimuli::BeginPlay()
         InputComponent->BindAction("DetectStimulus", IE_Pressed, this, &ATestStimuli::OnStimulusDetected);
     }
 
+    // A headless run drives itself; it has no headset to take eye tracking from
+    if (FParse::Param(FCommandLine::Get(), TEXT("PeriMapXRHeadless")))
+    {
+        bHeadlessDriver = true;
+    }
+    if (bHeadlessDriver)
+    {
+        InitializeHeadlessDriver();
+    }
+
     // Ensure that the eye-tracking system is initialized before starting the test
-    if (!bIsDemoMode)
+    if (!bIsDemoMode && !bHeadlessDriver)
     {
         InitializeEyeTracking();
     }
 
-    // Set up the test parameters and environment (e.g., fixation point, stimuli locations) for the first eye
-    SetupTest(TestType);
-
-    // Initialize LastFixationPosition to the starting position of the fixation actor
-    if (FixationActor)
+    // Journal every presentation from the first one on, so a crash keeps the trials already run
+    if (bEnableTrialJournal)
     {
-        LastFixationPosition = FixationActor->GetActorLocation();
+        const FString JournalPath = FPaths::ProjectDir() + "/TrialJournal_" + FDateTime::Now().ToString() + ".bin";
+        if (TrialJournal.Open(JournalPath, TrialJournalSyncIntervalSeconds))
+        {
+            LogMessage = FString::Printf(TEXT("Journaling trials to %s"), *JournalPath);
+            LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+        }
     }
 
+    // Set up the test parameters and environment (e.g., fixation point, stimuli locations) for the first eye
+    SetupTest(TestType);
+
     // Initialize the threshold estimator
-    FTestSettings TestSettings = *TestSettingsMap.Find(TestType);
-    ThresholdEstimator->Initialize(TestSettings, TestType, bIsLeftEye);
+    ThresholdEstimator->Initialize(GetEyeTestSettings(), TestType, bIsLeftEye);
 
     // Start the test and monitor eye gaze to check if the participant is focused on the fixation point
     StartTest();
     GetWorld()->GetTimerManager().SetTimer(GazeCheckTimerHandle, [this]() { CheckGazeFocus(); }, 0.1f, true);
 }
 
-// Called every frame to update the position of dynamic elements such as the fixation point.
+// Called when the actor is removed from the world. Waits for any estimation task still in flight and syncs the trial journal.
+void ATestStimuli::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    AsyncEstimator.Flush();
+    TrialJournal.Close();
+    FCoreDelegates::OnBeginFrame.Remove(HeadlessBeginFrameHandle);
+    FCoreDelegates::OnEndFrame.Remove(HeadlessEndFrameHandle);
+
+    // The pooled scene lives for the session; it goes with the test
+    for (AActor* SceneActor : TArray<AActor*>{ FixationActor, BackgroundSphereActor, ConvergingLinesActor })
+    {
+        if (SceneActor)
+        {
+            SceneActor->Destroy();
+        }
+    }
+    FixationActor = nullptr;
+    BackgroundSphereActor = nullptr;
+    ConvergingLinesActor = nullptr;
+
+    Super::EndPlay(EndPlayReason);
+}
+
+// Called every frame while a stimulus is on screen. Hides it once it has been visible for its frames.
 void ATestStimuli::Tick(float DeltaTime)
 {
     Super::Tick(DeltaTime);
 
-    // Call MonitorLatency() to track any hardware or performance delays
-    MonitorLatency();
+    if (!StimulusPresentations.IsValidIndex(ActivePresentationIndex))
+    {
+        SetActorTickEnabled(false);
+        return;
+    }
 
-    // Ensure the test is running and the fixation actor is valid
-    if (TestState == ETestState::Running && FixationActor)
+    // The frames a stimulus is on screen are the ones its duration is counted in; their time checks RefreshRate
+    MeasuredFrameSeconds += DeltaTime;
+    NumMeasuredFrames++;
+
+    // Gate the flash on fixation: a gaze sample off the fixation point on any of its frames throws the trial away on that frame
+    bool bOnFixation = true;
+    float GazeErrorInDeg = -1.0f;
+    if (SampleGazeOnFixation(bOnFixation, GazeErrorInDeg))
     {
-        // Get the user's current camera location and rotation
-        AActor* PICOXRPawnActor = UGameplayStatics::GetActorOfClass(GetWorld(), PICOXRPawnClass);
-        if (PICOXRPawnActor)
+        FStimulusPresentation& SampledPresentation = StimulusPresentations[ActivePresentationIndex];
+        SampledPresentation.GazeErrorInDeg = FMath::Max(SampledPresentation.GazeErrorInDeg, GazeErrorInDeg);
+        if (!bOnFixation)
         {
-            UCameraComponent* CameraComponent = PICOXRPawnActor->FindComponentByClass<UCameraComponent>();
-            if (CameraComponent)
-            {
-                FVector CameraLocation = CameraComponent->GetComponentLocation();
-                FRotator CameraRotation = CameraComponent->GetComponentRotation();
+            InvalidateStimulusPresentation();
+            return;
+        }
+    }
 
-                // Update the fixation point location to stay a fixed distance from the user's camera
-                FVector NewFixationLocation = CameraLocation + CameraRotation.Vector() * 30.0f;  // 30cm ahead of the user
+    // Visible on frames OnsetFrame .. OnsetFrame + FramesRequested - 1; hidden on the next one
+    const FStimulusPresentation& Presentation = StimulusPresentations[ActivePresentationIndex];
+    if ((int64)GFrameCounter - Presentation.OnsetFrame >= Presentation.FramesRequested)
+    {
+        EndStimulusPresentation(false);
+    }
+}
 
-                // Set the updated location for the fixation actor
-                FixationActor->SetActorLocation(NewFixationLocation);
+// Hides the stimulus on screen, if any, and records the frames and time it was shown for
+void ATestStimuli::EndStimulusPresentation(bool bInterrupted)
+{
+    if (!StimulusPresentations.IsValidIndex(ActivePresentationIndex))
+    {
+        return;
+    }
 
-                // If the fixation point has moved update the stimuli positions accordingly
-                if (FixationActorMoved())
-                {
-                    // Update stimuli positions only when the fixation point has moved
-                    UpdateStimuliPositions();
+    const int32 EndedPresentationIndex = ActivePresentationIndex;
+    FStimulusPresentation& Presentation = StimulusPresentations[EndedPresentationIndex];
+    StimulusField->SetStimulusVisibility(Presentation.StimulusIndex, false);
+    Presentation.FramesShown = (int32)((int64)GFrameCounter - Presentation.OnsetFrame);
+    Presentation.ShownSeconds = (float)FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - (uint64)Presentation.OnsetCycles);
+    Presentation.bInterrupted = bInterrupted;
+    ActivePresentationIndex = INDEX_NONE;
+    SetActorTickEnabled(false);
 
-                    // Update the last known position to the current one
-                    LastFixationPosition = FixationActor->GetActorLocation();
-                }
-            }
+    LogMessage = FString::Printf(TEXT("Stimulus %d hidden after %d of %d frames (%.1f ms)."), Presentation.StimulusIndex, Presentation.FramesShown, Presentation.FramesRequested, Presentation.ShownSeconds * 1000.0f);
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+
+    // A press can close the response window while the flash is still on; the trial is journaled by whichever ends last
+    TryJournalPresentation(EndedPresentationIndex);
+}
+
+// Number of display frames a stimulus stays visible; a headless frame stands for HeadlessTimeDilation display frames
+int32 ATestStimuli::GetStimulusFrames() const
+{
+    return FMath::Max(1, FMath::RoundToInt(StimuliDuration / GetFrameSeconds()));
+}
+
+// Test time of one frame; the headless game clock runs HeadlessTimeDilation display frames per fixed step
+float ATestStimuli::GetFrameSeconds() const
+{
+    return (bHeadlessDriver ? HeadlessTimeDilation : 1.0f) / RefreshRate;
+}
+
+// Reads the display refresh rate from the HMD, so frame counts match the rate the headset actually runs at
+void ATestStimuli::QueryRefreshRate()
+{
+#if PERIMAPXR_WITH_PICO
+    float DisplayRefreshRate = 0.0f;
+    if (UPICOXRHMDFunctionLibrary::PXR_GetCurrentDisplayRefreshRate(DisplayRefreshRate) && DisplayRefreshRate > 0.0f)
+    {
+        if (!FMath::IsNearlyEqual(DisplayRefreshRate, RefreshRate))
+        {
+            LogMessage = FString::Printf(TEXT("HMD reports %.1f Hz; stimuli are timed at that rate instead of %.1f Hz."), DisplayRefreshRate, RefreshRate);
+            LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+        }
+        RefreshRate = DisplayRefreshRate;
+        return;
+    }
+#endif
+
+    LogMessage = FString::Printf(TEXT("The HMD did not report its refresh rate; stimuli are timed at the configured %.1f Hz."), RefreshRate);
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+}
+
+// Logs how consistently stimuli of the eye just tested were shown: frame counts and on-screen time against the target
+void ATestStimuli::ReportPresentationTiming()
+{
+    int32 NumPresentations = 0;
+    int32 NumExactFrames = 0;
+    int32 NumInterrupted = 0;
+    double SumSeconds = 0.0;
+    double SumSquaredSeconds = 0.0;
+    float MinSeconds = MAX_flt;
+    float MaxSeconds = 0.0f;
+    for (const FStimulusPresentation& Presentation : StimulusPresentations)
+    {
+        if (Presentation.bInterrupted)
+        {
+            NumInterrupted++;
+            continue;
+        }
+        NumPresentations++;
+        NumExactFrames += Presentation.FramesShown == Presentation.FramesRequested ? 1 : 0;
+        SumSeconds += Presentation.ShownSeconds;
+        SumSquaredSeconds += (double)Presentation.ShownSeconds * Presentation.ShownSeconds;
+        MinSeconds = FMath::Min(MinSeconds, Presentation.ShownSeconds);
+        MaxSeconds = FMath::Max(MaxSeconds, Presentation.ShownSeconds);
+    }
+    if (NumPresentations == 0)
+    {
+        return;
+    }
+
+    const double MeanSeconds = SumSeconds / NumPresentations;
+    const double JitterSeconds = FMath::Sqrt(FMath::Max(0.0, SumSquaredSeconds / NumPresentations - MeanSeconds * MeanSeconds));
+    LogMessage = FString::Printf(TEXT("Presentation timing (%s eye): %d stimuli at %d frames (%.1f ms at %.0f Hz), %d shown for exactly that; on screen %.2f ms mean, %.2f ms jitter (SD), %.2f-%.2f ms range; %d cut short by a pause or a loss of fixation."),
+        bIsLeftEye ? TEXT("left") : TEXT("right"), NumPresentations, GetStimulusFrames(), GetStimulusFrames() * GetFrameSeconds() * 1000.0f, RefreshRate, NumExactFrames,
+        MeanSeconds * 1000.0, JitterSeconds * 1000.0, MinSeconds * 1000.0f, MaxSeconds * 1000.0f, NumInterrupted);
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+
+    // A display running at another rate than RefreshRate shows every stimulus for the wrong time, however exact its frames
+    if (NumMeasuredFrames > 0)
+    {
+        const double MeanFrameSeconds = MeasuredFrameSeconds / NumMeasuredFrames;
+        if (FMath::Abs(MeanFrameSeconds / GetFrameSeconds() - 1.0) > RefreshRateTolerance)
+        {
+            LogMessage = FString::Printf(TEXT("Frames took %.2f ms on average while stimuli were on screen, not the %.2f ms RefreshRate (%.0f Hz) implies; stimulus durations are off by the same ratio."),
+                MeanFrameSeconds * 1000.0, GetFrameSeconds() * 1000.0f, RefreshRate);
+            LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
         }
     }
 }
@@ -128,6 +350,12 @@ void ATestStimuli::Tick(float DeltaTime)
 // Checks and configures the eye-tracking system for compatibility and activation
 void ATestStimuli::InitializeEyeTracking()
 {
+#if !PERIMAPXR_WITH_PICO
+    // Built without the PICO plugins, so there is no eye tracker to start
+    LogMessage = "Eye tracking is not available on this platform; running in demo mode.";
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+    bIsDemoMode = true;
+#else
     // Check if the device supports eye tracking. This ensures the test can proceed with valid data.
     bool bSupportSuccess = PICOXRMotionTracking::GetEyeTrackingSupported(bIsEyeTrackingSupported, SupportedModes);
     if (bSupportSuccess && bIsEyeTrackingSupported)
@@ -196,112 +424,132 @@ void ATestStimuli::InitializeEyeTracking()
         LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
         return;
     }
+#endif
 }
 
 // Configures the test environment for the specified test type (e.g., 24-2, 10-2)
 void ATestStimuli::SetupTest(ETestType NewTestType)
 {
     TestType = NewTestType;  // Set the test type to the provided value
+    const double SetupStartSeconds = FPlatformTime::Seconds();
 
     // Retrieve and apply test settings based on the test type selected
     if (TestSettingsMap.Contains(TestType))
     {
         FTestSettings Settings = *TestSettingsMap.Find(TestType);
 
-        // Find the camera in the PICOXRPawn actor (the user), so we can orient elements (e.g., fixation point) around it
+        // Find the camera in the PICOXRPawn actor (the user), so we can orient elements (e.g., fixation point) around it.
+        // A headless run has no HMD, so the scene is laid out in front of wherever the actor was placed
         AActor* PICOXRPawnActor = UGameplayStatics::GetActorOfClass(GetWorld(), PICOXRPawnClass);
-        if (PICOXRPawnActor)
+        UCameraComponent* CameraComponent = PICOXRPawnActor ? PICOXRPawnActor->FindComponentByClass<UCameraComponent>() : nullptr;
+        if (CameraComponent || bHeadlessDriver)
         {
-            UCameraComponent* CameraComponent = PICOXRPawnActor->FindComponentByClass<UCameraComponent>();
+            // Stimulus frame counts follow the headset's rate; a headless run keeps the rate its fixed step was set from
+            if (!bHeadlessDriver)
+            {
+                QueryRefreshRate();
+            }
+
+            FVector CameraLocation = CameraComponent ? CameraComponent->GetComponentLocation() : GetActorLocation();
+            FRotator CameraRotation = CameraComponent ? CameraComponent->GetComponentRotation() : GetActorRotation();
+
+            // Lock the rig to the head; everything spawned below is attached to it where it spawns, once per session.
+            // The second eye and restarts reuse those actors: being head-locked, they are already in place
             if (CameraComponent)
             {
-                FVector CameraLocation = CameraComponent->GetComponentLocation();
-                FRotator CameraRotation = CameraComponent->GetComponentRotation();
-
-                // Calculate fixation point's position 30cm in front of the users camera
-                FVector FixationLocation = CameraLocation + CameraRotation.Vector() * 30.0f;
-
-                // Spawn and scale the fixation point based on the test settings
-                if (FixationActorClass)
-                {
-                    FixationActor = GetWorld()->SpawnActor<AFixationPoint>(FixationActorClass, FixationLocation, FRotator::ZeroRotator);
-                    FixationActor->SetScale(Settings.FixationPointDiameter);
-                }
-                else
-                {
-                    LogMessage = "FixationActor is null.";
-                    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
-                }
-
-                // Spawn and scale the background sphere that encapsulates stimuli
-                if (BackgroundSphereActorClass)
-                {
-                    BackgroundSphereActor = GetWorld()->SpawnActor<ABackgroundSphere>(BackgroundSphereActorClass, CameraLocation, FRotator::ZeroRotator);
-                    float BackgroundSphereScale(Settings.StimuliRadius * 10);  // Ensure the sphere encompasses all stimuli
-                    BackgroundSphereActor->SetScale(BackgroundSphereScale);
-                    LogMessage = FString::Printf(TEXT("BackgroundSphere Scale: %s"), *BackgroundSphereActor->GetActorScale3D().ToString());
-                    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
-                }
-                else
-                {
-                    LogMessage = "BackgroundSphereActor is null.";
-                    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
-                }
-
-                // Spawn and orient the converging lines actor, ensuring it points toward the fixation point
-                if (ConvergingLinesActorClass)
-                {
-                    ConvergingLinesActor = GetWorld()->SpawnActor<AActor>(ConvergingLinesActorClass, FixationLocation, FRotator::ZeroRotator);
-                    FVector DirectionToFixation = FixationActor->GetActorLocation() - ConvergingLinesActor->GetActorLocation();
-                    ConvergingLinesActor->SetActorRotation(DirectionToFixation.Rotation());
-                    SetConvergingLinesScale();  // Scale the lines relative to the background sphere
-                }
-                else
-                {
-                    LogMessage = "ConvergingLinesActor is null.";
-                    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
-                }
-
-                // Prepare the locations for stimuli presentation, ensuring appropriate spacing and coverage
-                StimuliLocations.Empty();
-                StimuliActors.Empty();
-
-                for (int32 i = 0; i < Settings.NumStimuli; ++i)
-                {
-                    // Distribute stimuli evenly across the angular range
-                    float VerticalAngle = FMath::RandRange(-Settings.MaxVerticalAngle, Settings.MaxVerticalAngle);
-                    float HorizontalAngle = FMath::RandRange(-Settings.MaxHorizontalAngle, Settings.MaxHorizontalAngle);
-
-                    FVector RelativeLocation = PolarToCartesian(Settings.StimuliRadius, FMath::DegreesToRadians(VerticalAngle), FMath::DegreesToRadians(HorizontalAngle));
-                    StimuliLocations.Add(RelativeLocation);
-
-                    if (StimuliActorClass)
-                    {
-                        FActorSpawnParameters SpawnParams;
-                        AStimuli* NewStimulus = GetWorld()->SpawnActor<AStimuli>(StimuliActorClass, FixationLocation + RelativeLocation, FRotator::ZeroRotator, SpawnParams);
-                        if (NewStimulus)
-                        {
-                            NewStimulus->bEnableConsoleMessages = bEnableConsoleMessages;
-                            NewStimulus->bEnableOnScreenMessages = bEnableOnScreenMessages;
-                            NewStimulus->bEnableSaveToLog = bEnableSaveToLog;
-                            NewStimulus->SetVisibility(false);
-                            NewStimulus->SetScale(Settings.StimuliDiameter);
-                            StimuliActors.Add(NewStimulus);
-
-                            // Debug message for confirmation
-                            LogMessage = FString::Printf(TEXT("Stimulus %d spawned at location: %s"), i, *(FixationLocation + RelativeLocation).ToString());
-                            LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
-                        }
-                    }
-                    else
-                    {
-                        LogMessage = "StimuliActor is null.";
-                        LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
-                    }
-                }
+                AttachToComponent(CameraComponent, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+            }
+
+            // Calculate fixation point's position 30cm in front of the users camera
+            FVector FixationLocation = CameraLocation + CameraRotation.Vector() * 30.0f;
+
+            // Spawn and scale the fixation point based on the test settings
+            if (!FixationActor && FixationActorClass)
+            {
+                FixationActor = GetWorld()->SpawnActor<AFixationPoint>(FixationActorClass, FixationLocation, FRotator::ZeroRotator);
+                FixationActor->AttachToComponent(StimulusRig, FAttachmentTransformRules::KeepWorldTransform);
+            }
+            if (FixationActor)
+            {
+                FixationActor->SetScale(Settings.FixationPointDiameter);
+            }
+            else
+            {
+                LogMessage = "FixationActor is null.";
+                LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+            }
+
+            // Spawn and scale the background sphere that encapsulates stimuli
+            if (!BackgroundSphereActor && BackgroundSphereActorClass)
+            {
+                BackgroundSphereActor = GetWorld()->SpawnActor<ABackgroundSphere>(BackgroundSphereActorClass, CameraLocation, FRotator::ZeroRotator);
+                BackgroundSphereActor->AttachToComponent(StimulusRig, FAttachmentTransformRules::KeepWorldTransform);
+            }
+            if (BackgroundSphereActor)
+            {
+                float BackgroundSphereScale(Settings.StimuliRadius * 10);  // Ensure the sphere encompasses all stimuli
+                BackgroundSphereActor->SetScale(BackgroundSphereScale);
+                LogMessage = FString::Printf(TEXT("BackgroundSphere Scale: %s"), *BackgroundSphereActor->GetActorScale3D().ToString());
+                LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+            }
+            else
+            {
+                LogMessage = "BackgroundSphereActor is null.";
+                LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+            }
+
+            // Spawn and orient the converging lines actor, ensuring it points toward the fixation point
+            if (!ConvergingLinesActor && ConvergingLinesActorClass && FixationActor)
+            {
+                ConvergingLinesActor = GetWorld()->SpawnActor<AActor>(ConvergingLinesActorClass, FixationLocation, FRotator::ZeroRotator);
+                FVector DirectionToFixation = FixationActor->GetActorLocation() - ConvergingLinesActor->GetActorLocation();
+                ConvergingLinesActor->SetActorRotation(DirectionToFixation.Rotation());
+                ConvergingLinesActor->AttachToComponent(StimulusRig, FAttachmentTransformRules::KeepWorldTransform);
+            }
+            if (ConvergingLinesActor)
+            {
+                SetConvergingLinesScale();  // Scale the lines relative to the background sphere
+            }
+            else
+            {
+                LogMessage = "ConvergingLinesActor is null.";
+                LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+            }
+
+            // Take the test's grid for this eye; its positions are laid out once per session and cached
+            const FStimulusGridLayout& Layout = FStimulusGridLibrary::GetLayout(TestType, bIsLeftEye, Settings.StimuliRadius, bSkipBlindSpotPoints, CustomGridPath);
+            if (Layout.Num() == 0)
+            {
+                LogMessage = FString::Printf(TEXT("No stimulus grid for test type %d; check CustomGridPath."), (int32)TestType);
+                LogManager.LogMessage(LogMessage, ELogVerbosity::Error, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+            }
+            StimuliLocations = Layout.Locations;
+
+            // Each stimulus sits at its grid position from the fixation point, expressed in the field's space
+            TArray<FVector> FieldLocations;
+            FieldLocations.Reserve(StimuliLocations.Num());
+            for (const FVector& RelativeLocation : StimuliLocations)
+            {
+                FieldLocations.Add(StimulusField->GetComponentTransform().InverseTransformPosition(FixationLocation + RelativeLocation));
             }
+
+            // One hidden instance per location, moved in place when the field already has them; nothing is spawned
+            StimulusField->bEnableConsoleMessages = bEnableConsoleMessages;
+            StimulusField->bEnableOnScreenMessages = bEnableOnScreenMessages;
+            StimulusField->bEnableSaveToLog = bEnableSaveToLog;
+            StimulusField->InitializeField(FieldLocations, Settings.StimuliDiameter);
         }
     }
+
+    // The scene is pooled, so every setup after the first should neither hitch nor add actors
+    const int32 LiveActorCount = GetWorld()->GetActorCount();
+    if (SessionActorCount == INDEX_NONE)
+    {
+        SessionActorCount = LiveActorCount;
+    }
+    LogMessage = FString::Printf(TEXT("Scene set up for the %s eye in %.2f ms with %d live actors (%+d since the first setup)."),
+        bIsLeftEye ? TEXT("left") : TEXT("right"), (FPlatformTime::Seconds() - SetupStartSeconds) * 1000.0, LiveActorCount, LiveActorCount - SessionActorCount);
+    LogManager.LogMessage(LogMessage, LiveActorCount > SessionActorCount ? ELogVerbosity::Error : ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
 }
 
 // Initiates the visual stimuli test by generating the stimuli pattern and starting the timer.
@@ -321,11 +569,56 @@ void ATestStimuli::StartTest()
     // Set the test state to running, which triggers stimuli generation
     TestState = ETestState::Running;
 
-    // Initialize threshold estimator for the current eye
+    // Initialize threshold estimator for the current eye; it must be back on the game thread first
+    AsyncEstimator.Flush();
     if (ThresholdEstimator)
     {
-        FTestSettings TestSettings = *TestSettingsMap.Find(TestType);
-        ThresholdEstimator->Initialize(TestSettings, TestType, bIsLeftEye);
+        ThresholdEstimator->Initialize(GetEyeTestSettings(), TestType, bIsLeftEye);
+        ThresholdEstimator->PatientAgeInYears = PatientAgeInYears;
+        ThresholdEstimator->bThresholdScreeningDefects = bThresholdScreeningDefects;
+
+        // A missed stimulus waits out its window and the gap; a seen one closes on the press when advancing on responses,
+        // so it costs the window measured on the previous eye (the full window until one has been measured)
+        const float MissedWindowSeconds = FMath::Max(GetResponseWindowSeconds(), FMath::Clamp(StimuliDuration + DetectedLatency, MinStimuliDuration, MaxStimuliDuration));
+        const float SeenWindowSeconds = bAdvanceOnResponse && NumSeenResponseWindows > 0 ? (float)(SeenResponseWindowSeconds / NumSeenResponseWindows) : MissedWindowSeconds;
+        ThresholdEstimator->SeenPresentationSeconds = SeenWindowSeconds + TimeBetweenStimuli;
+        ThresholdEstimator->MissedPresentationSeconds = MissedWindowSeconds + TimeBetweenStimuli;
+
+        // Register the stimulus locations so each one is addressed by its index from here on
+        ThresholdEstimator->RegisterLocations(StimuliLocations);
+
+        // Hand the estimator to the task graph until StopTest; it prepares the first trial (a primary seed when spatial priors are on)
+        AsyncEstimator.Begin(ThresholdEstimator);
+    }
+
+    // Start the response pipeline and presentation statistics for this eye
+    StimulusPresentations.Reset();
+    MeasuredFrameSeconds = 0.0;
+    NumMeasuredFrames = 0;
+    ActivePresentationIndex = INDEX_NONE;
+    TrialPresentationIndex = INDEX_NONE;
+    PreparedStimulusIndex = INDEX_NONE;
+    NumResponseWindows = 0;
+    NumEarlyResponseWindows = 0;
+    ResponseSecondsSaved = 0.0;
+    SeenResponseWindowSeconds = 0.0;
+    NumSeenResponseWindows = 0;
+    NumInvalidatedTrials = 0;
+    NumInvalidatedCatchTrials = 0;
+
+    // Reliability is judged per eye, from its own catch trials
+    Reliability = FReliabilityIndices();
+    ActiveCatchTrial = ECatchTrialType::None;
+    CatchStimulusIndex = INDEX_NONE;
+    CatchPresentationIndex = INDEX_NONE;
+    SeenIntensityInDb.Init(-1.0f, StimuliLocations.Num());
+    SeenStimulusIndices.Reset();
+    LivePosteriorMoments.Init(FPosteriorMoments(), StimuliLocations.Num());
+
+    // The scripted participant gets a field for this eye's layout, repeatable from the run's seed
+    if (bHeadlessDriver)
+    {
+        ScriptedResponder.Initialize(StimuliLocations, HeadlessSeed + (bIsLeftEye ? 0 : 1));
     }
 
     // Generate the stimuli pattern and start presenting them to the user
@@ -342,12 +635,37 @@ void ATestStimuli::StopTest()
         return;
     }
 
-    // Stop stimuli presentation and clear timers
+    // Stop stimuli presentation and clear timers; a catch trial still open is dropped unscored
     GetWorld()->GetTimerManager().ClearTimer(StimuliPresentationTimerHandle);
+    GetWorld()->GetTimerManager().ClearTimer(CatchTrialTimerHandle);
+    GetWorld()->GetTimerManager().ClearTimer(ScriptedPressTimerHandle);
+    ActiveCatchTrial = ECatchTrialType::None;
+
+    // Take the estimator back from the task graph before reading its results
+    AsyncEstimator.Flush();
 
     // Clean up all spawned stimuli
     CleanupStimuli();
 
+    // Journal what the eye left unfinished, so its record of presentations is complete
+    for (FStimulusPresentation& Presentation : StimulusPresentations)
+    {
+        if (!Presentation.bJournaled)
+        {
+            Presentation.bJournaled = true;
+            AppendJournalRecord(Presentation);
+        }
+    }
+
+    // Calculate the eye's final thresholds and sensitivities and save them for later review. This has to happen
+    // before SwitchEye, which reinitializes the estimator for the other eye and hands it back to the task graph
+    if (ThresholdEstimator)
+    {
+        ThresholdEstimator->CalculateFinalThresholds();
+        ThresholdEstimator->CalculateFinalSensitivities();
+    }
+    SaveResultsToFile();
+
     // Check if the test needs to switch to the other eye
     if (bIsLeftEye)
     {
@@ -362,17 +680,12 @@ void ATestStimuli::StopTest()
         TestState = ETestState::Completed;
         LogMessage = "Test completed for both eyes.";
         LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
-
-        // Calculate final thresholds and sensitivities
-        if (ThresholdEstimator)
-        {
-            ThresholdEstimator->CalculateFinalThresholds();
-            ThresholdEstimator->CalculateFinalSensitivities();
-        }
     }
 
-    // Save the test results to a file for later review
-    SaveResultsToFile();
+    if (bHeadlessDriver && TestState == ETestState::Completed)
+    {
+        FinishHeadlessRun();
+    }
 }
 
 // Temporarily halts the stimuli presentation and test progression
@@ -383,14 +696,9 @@ void ATestStimuli::PauseTest()
     GetWorld()->GetTimerManager().PauseTimer(StimulusResponseTimerHandle);
     GetWorld()->GetTimerManager().PauseTimer(CatchTrialTimerHandle);
 
-    // Hide any visible stimuli using SetVisibility
-    for (AStimuli* Stimulus : StimuliActors)
-    {
-        if (Stimulus)
-        {
-            Stimulus->SetVisibility(false);
-        }
-    }
+    // Hide any visible stimuli
+    EndStimulusPresentation(true);
+    StimulusField->HideAllStimuli();
     LogMessage = "Test paused.";
     LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
 }
@@ -420,21 +728,43 @@ void ATestStimuli::RunTest()
         return;
     }
 
+    // The gap is over, and with it any catch trial it hosted
+    CloseCatchTrial();
+    if (Reliability.bIsUnreliable && bStopWhenUnreliable)
+    {
+        LogMessage = FString::Printf(TEXT("Ending the %s eye early: its responses are unreliable."), bIsLeftEye ? TEXT("left") : TEXT("right"));
+        LogManager.LogMessage(LogMessage, ELogVerbosity::Error, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+        ReportResponsePipeline();
+        ReportPresentationTiming();
+        ReportReliability();
+        StopTest();
+        return;
+    }
+
+    // Take the trial the estimation task prepared; if it is still being prepared, try again next frame
+    float StimulusIntensityInDb = 20.0f;
+    if (ThresholdEstimator)
+    {
+        FPreparedTrial NextTrial;
+        if (!TakePreparedTrial(NextTrial))
+        {
+            GetWorld()->GetTimerManager().SetTimerForNextTick(this, &ATestStimuli::RunTest);
+            return;
+        }
+        CurrentStimulusIndex = NextTrial.LocationIndex;
+        StimulusIntensityInDb = NextTrial.StimulusIntensityInDb;
+    }
+
     // Check if all stimuli have been processed for the current eye
-    if (CurrentStimulusIndex >= StimuliLocations.Num())
+    if (CurrentStimulusIndex == INDEX_NONE || CurrentStimulusIndex >= StimuliLocations.Num())
     {
         LogMessage = "All stimuli processed for current eye.";
         LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
-        // If testing for the left eye is complete, switch to the right eye or end the test
-        if (bIsLeftEye)
-        {
-            SwitchEye();
-            RunTest();  // Start testing for the right eye
-        }
-        else
-        {
-            StopTest();  // Both eyes have been tested, stop the test
-        }
+        ReportResponsePipeline();
+        ReportPresentationTiming();
+        ReportReliability();
+        // Saves the eye's results, then switches to the right eye or ends the test
+        StopTest();
         return;
     }
 
@@ -447,89 +777,241 @@ void ATestStimuli::RunTest()
         return;
     }
 
-    FVector Location = StimuliLocations[CurrentStimulusIndex];
-
-    // Get the next stimulus intensity from the threshold estimator
-    float StimulusIntensityInDb = ThresholdEstimator ? ThresholdEstimator->GetNextStimulusIntensityInDb(Location) : 20.0f;
-
-    // Debugging: Log the intensity returned by ThresholdEstimator
-    LogMessage = FString::Printf(TEXT("ThresholdEstimator returned intensity %f dB for location %s"), StimulusIntensityInDb, *Location.ToString());
-    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
-
+    // Hold the onset while the gaze is off the fixation point; the trial is shown on the first frame it is back
+    bool bOnFixation = true;
+    float OnsetGazeErrorInDeg = -1.0f;
+    if (SampleGazeOnFixation(bOnFixation, OnsetGazeErrorInDeg) && !bOnFixation)
+    {
+        GetWorld()->GetTimerManager().SetTimerForNextTick(this, &ATestStimuli::RunTest);
+        return;
+    }
 
-    // Adjust StimuliDuration and TimeBetweenStimuli for latency
+    // Sample the frame latency for this trial, then adjust StimuliDuration for it; the response window, fitted to the
+    // participant's reaction times so far, never closes before the stimulus has been shown in full
+    MonitorLatency();
     float AdjustedStimuliDuration = FMath::Clamp(StimuliDuration + DetectedLatency, MinStimuliDuration, MaxStimuliDuration);
+    CurrentResponseWindowSeconds = FMath::Max(GetResponseWindowSeconds(), AdjustedStimuliDuration);
 
-    // Flash the stimulus at the current index with the calculated intensity
+    // Flash the stimulus at the current index with the calculated intensity; presses are timed from its onset
     FlashStimuli(CurrentStimulusIndex, StimulusIntensityInDb);
+    TrialPresentationIndex = ActivePresentationIndex;
+    if (StimulusPresentations.IsValidIndex(TrialPresentationIndex))
+    {
+        StimulusPresentations[TrialPresentationIndex].GazeErrorInDeg = OnsetGazeErrorInDeg;
+    }
+    CurrentStimulusIntensityInDb = StimulusIntensityInDb;
+    StimulusOnsetSeconds = GetWorld()->GetTimeSeconds();
 
-    // Set the state to waiting for input
+    // Set the state to waiting for input; a press stale from the previous gap does not count
+    bUserResponded = false;
     TestState = ETestState::WaitingForInput;
 
-    // Set a timer to handle the user's response after the stimulus presentation
-    GetWorld()->GetTimerManager().SetTimer(StimulusResponseTimerHandle, [this, Location]()
+    // Set a timer to handle the user's response once the window has run out; a press may close it earlier
+    GetWorld()->GetTimerManager().SetTimer(StimulusResponseTimerHandle, this, &ATestStimuli::HandleStimulusResponse, CurrentResponseWindowSeconds, false);
+}
+
+// Closes the response window of the current stimulus, either when it runs out or early on a press
+void ATestStimuli::HandleStimulusResponse()
+{
+    LogMessage = FString::Printf(TEXT("Response handler called for stimulus %d."), CurrentStimulusIndex);
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+
+    // Ensure that the test is still waiting for input
+    if (TestState != ETestState::WaitingForInput || bIsTestPaused)
     {
-        LogMessage = FString::Printf(TEXT("Response handling lambda called for stimulus at location: %s"), *Location.ToString());
+        LogMessage = FString::Printf(TEXT("Exiting response handler: TestState=%d, bIsTestPaused=%d"), (int32)TestState, bIsTestPaused);
         LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+        return;
+    }
+    GetWorld()->GetTimerManager().ClearTimer(StimulusResponseTimerHandle);
 
-        // Ensure that the test is still waiting for input
-        if (TestState != ETestState::WaitingForInput || bIsTestPaused)
-        {
-            LogMessage = FString::Printf(TEXT("Exiting response handler: TestState=%d, bIsTestPaused=%d"), (int32)TestState, bIsTestPaused);
-            LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
-            return;
-        }
+    // Check if the stimulus was detected
+    bool bStimulusDetected = WasStimulusDetected();
+    LogMessage = FString::Printf(TEXT("Stimulus detected: %s"), bStimulusDetected ? TEXT("Yes") : TEXT("No"));
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
 
-        // Check if the stimulus was detected
-        bool bStimulusDetected = WasStimulusDetected();
-        LogMessage = FString::Printf(TEXT("Stimulus detected: %s"), bStimulusDetected ? TEXT("Yes") : TEXT("No"));
-        LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+    // Time the window actually stayed open against the fixed window, which the adapted window and a press both shorten
+    const float FixedWindowSeconds = FMath::Max(ResponseWindowSeconds, FMath::Clamp(StimuliDuration + DetectedLatency, MinStimuliDuration, MaxStimuliDuration));
+    const float WindowSeconds = FMath::Min((float)(GetWorld()->GetTimeSeconds() - StimulusOnsetSeconds), CurrentResponseWindowSeconds);
+    NumResponseWindows++;
+    if (CurrentResponseWindowSeconds - WindowSeconds > KINDA_SMALL_NUMBER)
+    {
+        NumEarlyResponseWindows++;
+    }
+    ResponseSecondsSaved += FMath::Max(FixedWindowSeconds - WindowSeconds, 0.0f);
+
+    // A press sooner than MinResponseSeconds after onset is too fast to be a reaction to the stimulus. It is not posted
+    // as seen: like a loss of fixation, it discards the trial and puts its location back among the locations to test
+    const float ReactionTimeSeconds = StimulusPresentations.IsValidIndex(TrialPresentationIndex) ? StimulusPresentations[TrialPresentationIndex].ReactionTimeSeconds : -1.0f;
+    if (bStimulusDetected && ReactionTimeSeconds >= 0.0f && ReactionTimeSeconds < MinResponseSeconds)
+    {
+        DiscardAnticipatoryResponse(ReactionTimeSeconds);
+        return;
+    }
+    if (bStimulusDetected)
+    {
+        ReactionTimes.Add(ReactionTimeSeconds);
+    }
 
-        // Record the result with the threshold estimator
-        if (ThresholdEstimator)
+    // The trial's outcome is final now
+    const int32 AnsweredPresentationIndex = TrialPresentationIndex;
+    if (StimulusPresentations.IsValidIndex(AnsweredPresentationIndex))
+    {
+        StimulusPresentations[AnsweredPresentationIndex].bSeen = bStimulusDetected;
+        StimulusPresentations[AnsweredPresentationIndex].bOutcomeKnown = true;
+    }
+    TrialPresentationIndex = INDEX_NONE;
+    TryJournalPresentation(AnsweredPresentationIndex);
+    NumSessionTrials++;
+
+    if (bStimulusDetected)
+    {
+        NumSeenResponseWindows++;
+        SeenResponseWindowSeconds += WindowSeconds;
+
+        // Remember the dimmest intensity seen here; false-negative catch trials come back well above it
+        if (SeenIntensityInDb.IsValidIndex(CurrentStimulusIndex))
         {
-            ThresholdEstimator->UpdateWithResponse(Location, ThresholdEstimator->GetThresholdEstimateInDb(Location), bStimulusDetected);
+            if (SeenIntensityInDb[CurrentStimulusIndex] < 0.0f)
+            {
+                SeenStimulusIndices.Add(CurrentStimulusIndex);
+            }
+            SeenIntensityInDb[CurrentStimulusIndex] = FMath::Max(SeenIntensityInDb[CurrentStimulusIndex], CurrentStimulusIntensityInDb);
         }
+    }
 
-        // Move to the next stimulus
+    // Post the result, with the intensity that was actually presented, to the estimation task;
+    // it also picks the next location (INDEX_NONE once every location is complete) and its intensity
+    if (ThresholdEstimator)
+    {
+        AsyncEstimator.PostResponse(CurrentStimulusIndex, CurrentStimulusIntensityInDb, bStimulusDetected);
+    }
+    else
+    {
         CurrentStimulusIndex++;
+    }
 
-        // Reset test state
-        TestState = ETestState::Running;
+    // Reset test state
+    TestState = ETestState::Running;
 
-        // Schedule the next RunTest() call after TimeBetweenStimuli
-        GetWorld()->GetTimerManager().SetTimer(StimuliPresentationTimerHandle, this, &ATestStimuli::RunTest, TimeBetweenStimuli, false);
+    // Start the gap to the next stimulus now, and get that stimulus ready as soon as its trial is
+    GetWorld()->GetTimerManager().SetTimer(StimuliPresentationTimerHandle, this, &ATestStimuli::RunTest, TimeBetweenStimuli, false);
+    PreparedStimulusIndex = INDEX_NONE;
+    if (ThresholdEstimator)
+    {
+        GetWorld()->GetTimerManager().SetTimerForNextTick(this, &ATestStimuli::PrepareNextStimulus);
+    }
 
-    }, AdjustedStimuliDuration, false);
+    // The gap would otherwise sit idle, so it may host a catch trial
+    ScheduleCatchTrial();
 }
 
-// Update stimuli positions, used when the user moves their head position.
-void ATestStimuli::UpdateStimuliPositions()
+// Sets the next stimulus's intensity while it is still hidden, polling each frame until the estimation task has prepared it
+void ATestStimuli::PrepareNextStimulus()
 {
-    if (FixationActor)
+    // Nothing to do once the gap has ended or the test has stopped
+    if (TestState != ETestState::Running || !GetWorld()->GetTimerManager().IsTimerActive(StimuliPresentationTimerHandle))
+    {
+        return;
+    }
+
+    FPreparedTrial NextTrial;
+    if (!TakePreparedTrial(NextTrial))
+    {
+        GetWorld()->GetTimerManager().SetTimerForNextTick(this, &ATestStimuli::PrepareNextStimulus);
+        return;
+    }
+
+    // The stimulus just shown or a catch stimulus may still be visible, so a repeat of either is left to FlashStimuli
+    if (NextTrial.LocationIndex == CurrentStimulusIndex || NextTrial.LocationIndex == CatchStimulusIndex || NextTrial.LocationIndex < 0 || NextTrial.LocationIndex >= StimulusField->GetNumStimuli())
     {
-        FVector FixationLocation = FixationActor->GetActorLocation();
-        for (int32 i = 0; i < StimuliActors.Num(); ++i)
+        return;
+    }
+
+    // Stimuli already sit at their locations, so the intensity is all that is left to apply
+    StimulusField->SetBrightnessFromDb(NextTrial.LocationIndex, NextTrial.StimulusIntensityInDb);
+    PreparedStimulusIndex = NextTrial.LocationIndex;
+    PreparedStimulusIntensityInDb = NextTrial.StimulusIntensityInDb;
+}
+
+// Takes the trial the estimation task prepared. The posterior updates published with it are applied here on the game
+// thread, where completions are logged, since the task itself never logs
+bool ATestStimuli::TakePreparedTrial(FPreparedTrial& OutTrial)
+{
+    if (!AsyncEstimator.TryGetNextTrial(OutTrial))
+    {
+        return false;
+    }
+
+    for (const FLocationUpdate& Update : OutTrial.LocationUpdates)
+    {
+        if (!LivePosteriorMoments.IsValidIndex(Update.LocationIndex))
         {
-            if (StimuliActors[i])
-            {
-                // Update each stimulus' position relative to the fixation point
-                StimuliActors[i]->SetActorLocation(FixationLocation + StimuliLocations[i]);
-            }
+            continue;
+        }
+        LivePosteriorMoments[Update.LocationIndex] = Update.Moments;
+
+        if (Update.StoppingRule != EStoppingRule::None)
+        {
+            LogMessage = FString::Printf(TEXT("Threshold estimation complete for location %s by %s. Estimated threshold: %f dB"),
+                *StimuliLocations[Update.LocationIndex].ToString(), *UEnum::GetValueAsString(Update.StoppingRule), Update.ThresholdInDb);
+            LogManager.LogMessage(LogMessage, ELogVerbosity::Log, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
         }
     }
+    return true;
+}
+
+// Posterior summary of a stimulus of the current eye as of the last trial taken from the estimation task
+FPosteriorMoments ATestStimuli::GetLivePosteriorMoments(int32 StimulusIndex) const
+{
+    return LivePosteriorMoments.IsValidIndex(StimulusIndex) ? LivePosteriorMoments[StimulusIndex] : FPosteriorMoments();
 }
 
-// Compares the current position of the fixation actor to the last stored position.
-bool ATestStimuli::FixationActorMoved() const
+// Logs the time saved by closing response windows on a press for the eye just tested
+void ATestStimuli::ReportResponsePipeline()
 {
-    if (FixationActor)
+    if (NumResponseWindows == 0)
     {
-        // Compare the current position of the fixation actor with the last known position
-        FVector CurrentPosition = FixationActor->GetActorLocation();
-        return !CurrentPosition.Equals(LastFixationPosition, 0.01f);  // Allow small tolerance to prevent floating point errors
+        return;
     }
-    return false;
+
+    const float FixedWindowSeconds = FMath::Max(ResponseWindowSeconds, FMath::Clamp(StimuliDuration + DetectedLatency, MinStimuliDuration, MaxStimuliDuration));
+    LogMessage = FString::Printf(TEXT("Response pipeline (%s eye): %d of %d windows closed early, %.3f s saved per trial (%.1f s in total, %.1f%% of the fixed %.2f s windows); %d trials and %d catch trials discarded for lost fixation."),
+        bIsLeftEye ? TEXT("left") : TEXT("right"), NumEarlyResponseWindows, NumResponseWindows,
+        ResponseSecondsSaved / NumResponseWindows, ResponseSecondsSaved, 100.0 * ResponseSecondsSaved / (NumResponseWindows * FixedWindowSeconds), FixedWindowSeconds,
+        NumInvalidatedTrials, NumInvalidatedCatchTrials);
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+
+    LogMessage = FString::Printf(TEXT("Reaction times (session so far): %d, mean %.0f ms, median %.0f ms, %.0fth percentile %.0f ms; response window now %.0f ms (configured %.0f ms)."),
+        ReactionTimes.Num(), ReactionTimes.GetMean() * 1000.0f, ReactionTimes.GetPercentile(0.5f) * 1000.0f,
+        ResponseWindowPercentile * 100.0f, ReactionTimes.GetPercentile(ResponseWindowPercentile) * 1000.0f, GetResponseWindowSeconds() * 1000.0f, ResponseWindowSeconds * 1000.0f);
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+}
+
+// Response window for the next stimulus: the configured window until enough of the participant's reaction times are
+// in, then a high percentile of them plus a margin, so fast responders are not kept waiting on the stimuli they miss
+float ATestStimuli::GetResponseWindowSeconds() const
+{
+    if (!bAdaptResponseWindow || ReactionTimes.Num() < MinReactionTimesForAdaptation)
+    {
+        return ResponseWindowSeconds;
+    }
+
+    // Reaction times are only seen inside the configured window, so the adapted one never grows past it
+    const float AdaptedSeconds = ReactionTimes.GetPercentile(ResponseWindowPercentile) + ResponseWindowMarginSeconds;
+    return FMath::Clamp(AdaptedSeconds, FMath::Min(MinAdaptiveResponseWindowSeconds, ResponseWindowSeconds), ResponseWindowSeconds);
+}
+
+// Settings of the current test type; a screening runs the same grid and pipeline with only the strategy swapped,
+// so its results are saved in the same format with the stopping rule telling passed locations from defects
+FTestSettings ATestStimuli::GetEyeTestSettings() const
+{
+    FTestSettings Settings = *TestSettingsMap.Find(TestType);
+    if (bScreeningMode)
+    {
+        Settings.ThresholdStrategy = EThresholdStrategy::SuprathresholdScreening;
+    }
+    return Settings;
 }
 
 // Handles the visibility logic for a specific stimulus
@@ -537,7 +1019,7 @@ void ATestStimuli::FlashStimuli(int32 StimulusIndex, float StimulusIntensityInDb
 {
     // Exit if demo mode is active, or the test is paused, or the index is invalid
     /*
-    if (bIsDemoMode || bIsTestPaused || !StimuliActors.IsValidIndex(StimulusIndex))
+    if (bIsDemoMode || bIsTestPaused || StimulusIndex >= StimulusField->GetNumStimuli())
     {
         LogMessage = "Stimuli flashing is paused due to demo mode or test pause.";
         LogManager.LogMessage(LogMessage, ELogVerbosity::Error, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
@@ -545,127 +1027,287 @@ void ATestStimuli::FlashStimuli(int32 StimulusIndex, float StimulusIntensityInDb
     }
     */
 
-    // Get the stimulus actor for the current index
-    AStimuli* StimulusActor = StimuliActors[StimulusIndex];
-    if (StimulusActor)
+    // Flash the stimulus for the current index if the field has it
+    if (StimulusIndex >= 0 && StimulusIndex < StimulusField->GetNumStimuli())
     {
-        // Set the brightness of the stimulus based on the intensity in decibels
-        StimulusActor->SetBrightnessFromDb(StimulusIntensityInDb);
-        LogMessage = FString::Printf(TEXT("SetBrightnessFromDb called on StimulusActor at index %d with intensity %f dB."), StimulusIndex, StimulusIntensityInDb);
+        // Set the brightness of the stimulus based on the intensity in decibels, unless it was set during the gap
+        if (StimulusIndex != PreparedStimulusIndex || StimulusIntensityInDb != PreparedStimulusIntensityInDb)
+        {
+            StimulusField->SetBrightnessFromDb(StimulusIndex, StimulusIntensityInDb);
+        }
+        PreparedStimulusIndex = INDEX_NONE;
+
+        // Make the stimulus visible from this frame on, and record the onset
+        EndStimulusPresentation(true);
+        StimulusField->SetStimulusVisibility(StimulusIndex, true);
+        FStimulusPresentation& Presentation = StimulusPresentations.AddDefaulted_GetRef();
+        Presentation.StimulusIndex = StimulusIndex;
+        Presentation.IntensityInDb = StimulusIntensityInDb;
+        Presentation.OnsetFrame = (int64)GFrameCounter;
+        Presentation.OnsetCycles = (int64)FPlatformTime::Cycles64();
+        Presentation.FramesRequested = GetStimulusFrames();
+        ActivePresentationIndex = StimulusPresentations.Num() - 1;
+        LogMessage = FString::Printf(TEXT("Stimulus %d shown on frame %lld for %d frames."), StimulusIndex, Presentation.OnsetFrame, Presentation.FramesRequested);
         LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
 
-        // Make the stimulus visible using the SetVisibility function
-        StimulusActor->SetVisibility(true);
-        LogMessage = FString::Printf(TEXT("SetVisibility(true) called on StimulusActor at index %d."), StimulusIndex);
-        LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+        // Tick counts the frames and hides the stimulus on the frame its presentation ends
+        SetActorTickEnabled(true);
 
-        // Hide the stimulus after the specified duration using SetVisibility(false)
-        FTimerHandle HideStimuliTimerHandle;
-        GetWorld()->GetTimerManager().SetTimer(HideStimuliTimerHandle, [this, StimulusIndex, StimulusActor]()
+        if (bHeadlessDriver)
         {
-            StimulusActor->SetVisibility(false);  // Hide the stimulus after the flash
-            LogMessage = FString::Printf(TEXT("Stimulus %d hidden after duration."), StimulusIndex);
-            LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
-
-        }, StimuliDuration, false);
+            ScheduleScriptedResponse(StimulusIndex, StimulusIntensityInDb);
+        }
     }
     else
     {
-        LogMessage = FString::Printf(TEXT("StimulusActor is null at index %d."), StimulusIndex);
+        LogMessage = FString::Printf(TEXT("No stimulus at index %d."), StimulusIndex);
         LogManager.LogMessage(LogMessage, ELogVerbosity::Error, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
     }
 }
 
-// Removes and destroys all existing stimuli actors from the world.
+// Hides the current eye's stimuli; the field keeps its instances for the next eye or a restart.
 void ATestStimuli::CleanupStimuli()
 {
-    // Iterate through each spawned stimulus actor and destroy it
-    for (AActor* StimulusActor : StimuliActors)
-    {
-        if (StimulusActor)
-        {
-            StimulusActor->Destroy();
-        }
-    }
-
-    // Clear the array of actors after they are destroyed
-    StimuliActors.Empty();
+    EndStimulusPresentation(true);
+    StimulusField->HideAllStimuli();
 }
 
-// Saves the test results to a file for later analysis and review.
+// Saves the test results to a file for later analysis and review. The file is written on the thread pool; every
+// presentation behind the results is already in the trial journal, so the game thread never waits on the disk
 void ATestStimuli::SaveResultsToFile()
 {
-    FString SavePath = FPaths::ProjectDir() + "/TestResults.csv";
-    FString ResultsString = "LocationX,LocationY,Threshold,Sensitivity\n";
+    // The estimator must be back from the task graph; StopTest flushes it first
+    check(!AsyncEstimator.IsActive());
+
+    // One file per eye, so the right eye's results do not overwrite the left eye's
+    const TCHAR* EyeName = bIsLeftEye ? TEXT("Left") : TEXT("Right");
+    FString SavePath = FPaths::ProjectDir() + FString::Printf(TEXT("/TestResults_%s.csv"), EyeName);
+    FString ResultsString = "LocationX,LocationY,Threshold,Sensitivity,StoppingRule\n";
 
     const TMap<FVector, float>& FinalThresholds = ThresholdEstimator->GetFinalThresholdsInDb();
+    ResultsString.Reserve(ResultsString.Len() + FinalThresholds.Num() * 96);
     for (const auto& Pair : FinalThresholds)
     {
         FVector Location = Pair.Key;
         float Threshold = Pair.Value;
         float Sensitivity = 1.0f / Threshold;
-        ResultsString += FString::Printf(TEXT("%f,%f,%f,%f\n"), Location.X, Location.Y, Threshold, Sensitivity);
+        FString StoppingRule = UEnum::GetValueAsString(ThresholdEstimator->GetStoppingRule(Location));
+        ResultsString.Appendf(TEXT("%f,%f,%f,%f,%s\n"), Location.X, Location.Y, Threshold, Sensitivity, *StoppingRule);
     }
 
-    FFileHelper::SaveStringToFile(ResultsString, *SavePath);
-    LogMessage = FString::Printf(TEXT("Test results saved to %s"), *SavePath);
+    Async(EAsyncExecution::ThreadPool, [ResultsString = MoveTemp(ResultsString), SavePath]()
+    {
+        if (!FFileHelper::SaveStringToFile(ResultsString, *SavePath))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Failed to write test results to %s"), *SavePath);
+        }
+    });
+    LogMessage = FString::Printf(TEXT("Test results saving to %s"), *SavePath);
     LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+
+    // Write the binary posterior trace alongside; decode it with scripts/trace/decode_posterior_trace.py
+    FString TracePath = FPaths::ProjectDir() + "/PosteriorTrace.bin";
+    if (ThresholdEstimator->DumpPosteriorTrace(TracePath))
+    {
+        LogMessage = FString::Printf(TEXT("Posterior trace saving to %s"), *TracePath);
+        LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+    }
 }
 
-bool ATestStimuli::CheckForFalsePositives()
+// Journals a presentation once it is off screen and its outcome is final, and only once
+void ATestStimuli::TryJournalPresentation(int32 PresentationIndex)
 {
-    // Determine if a catch trial should occur
-    bool bIsCatchTrial = FMath::RandRange(0, 9) == 0;  // 10% chance
+    if (!StimulusPresentations.IsValidIndex(PresentationIndex) || PresentationIndex == ActivePresentationIndex)
+    {
+        return;
+    }
 
-    if (bIsCatchTrial)
+    FStimulusPresentation& Presentation = StimulusPresentations[PresentationIndex];
+    if (Presentation.bOutcomeKnown && !Presentation.bJournaled)
     {
-        LogMessage = "Catch trial initiated";
-        LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+        Presentation.bJournaled = true;
+        AppendJournalRecord(Presentation);
+    }
+}
+
+// Queues a presentation's record on the trial journal; the disk write happens on the journal's thread
+void ATestStimuli::AppendJournalRecord(const FStimulusPresentation& Presentation)
+{
+    if (!TrialJournal.IsOpen())
+    {
+        return;
+    }
+
+    FTrialJournalRecord Record;
+    FMemory::Memzero(Record);
+    Record.StimulusIndex = Presentation.StimulusIndex;
+    Record.IntensityInDb = Presentation.IntensityInDb;
+    Record.ReactionTimeSeconds = Presentation.ReactionTimeSeconds;
+    Record.GazeErrorInDeg = Presentation.GazeErrorInDeg;
+    Record.ShownSeconds = Presentation.ShownSeconds;
+    Record.OnsetCycles = Presentation.OnsetCycles;
+    Record.ResponseCycles = Presentation.ResponseCycles;
+    Record.OnsetFrame = Presentation.OnsetFrame;
+    Record.FramesRequested = Presentation.FramesRequested;
+    Record.FramesShown = Presentation.FramesShown;
+    Record.bSeen = Presentation.bSeen;
+    Record.bLeftEye = bIsLeftEye;
+    Record.bCatchTrial = Presentation.bCatchTrial;
+    Record.bFixationLost = Presentation.bFixationLost;
+    Record.bInterrupted = Presentation.bInterrupted;
+    Record.bAnticipatory = Presentation.bAnticipatory;
+    TrialJournal.Append(Record);
+}
+
+// Lets the gap just started host a catch trial, opening it once late presses for the previous stimulus are over
+void ATestStimuli::ScheduleCatchTrial()
+{
+    // The catch trial runs from the guard to the end of the gap, which has to leave room for a response
+    const float CatchWindowSeconds = TimeBetweenStimuli - CatchTrialGuardSeconds;
+    if (CatchWindowSeconds < FMath::Max(StimuliDuration, MinResponseSeconds))
+    {
+        return;
+    }
 
-        // Set the test state to waiting for input
-        TestState = ETestState::WaitingForInput;
+    // A false-negative catch trial needs a location that has already been seen
+    ECatchTrialType CatchTrialType = ECatchTrialType::None;
+    const float Roll = FMath::FRand();
+    if (Roll < FalsePositiveCatchProbability)
+    {
+        CatchTrialType = ECatchTrialType::FalsePositive;
+    }
+    else if (Roll < FalsePositiveCatchProbability + FalseNegativeCatchProbability && SeenStimulusIndices.Num() > 0)
+    {
+        CatchTrialType = ECatchTrialType::FalseNegative;
+    }
 
-        // Adjusted timings
-        float AdjustedStimuliDuration = StimuliDuration + DetectedLatency;
-        float AdjustedTimeBetweenStimuli = TimeBetweenStimuli + DetectedLatency;
+    if (CatchTrialType != ECatchTrialType::None)
+    {
+        GetWorld()->GetTimerManager().SetTimer(CatchTrialTimerHandle, FTimerDelegate::CreateUObject(this, &ATestStimuli::OpenCatchTrial, CatchTrialType), CatchTrialGuardSeconds, false);
+    }
+}
 
-        // Clamp adjusted times
-        AdjustedStimuliDuration = FMath::Clamp(AdjustedStimuliDuration, MinStimuliDuration, MaxStimuliDuration);
-        AdjustedTimeBetweenStimuli = FMath::Clamp(AdjustedTimeBetweenStimuli, MinTimeBetweenStimuli, MaxTimeBetweenStimuli);
+// Opens a catch trial in the current gap; it stays open until the gap ends
+void ATestStimuli::OpenCatchTrial(ECatchTrialType CatchTrialType)
+{
+    // The gap may have ended or the test stopped since the catch trial was scheduled
+    if (TestState != ETestState::Running || !GetWorld()->GetTimerManager().IsTimerActive(StimuliPresentationTimerHandle))
+    {
+        return;
+    }
 
-        // Schedule the timer to handle the user's response
-        GetWorld()->GetTimerManager().SetTimer(CatchTrialTimerHandle, [this, AdjustedTimeBetweenStimuli]()
+    if (CatchTrialType == ECatchTrialType::FalseNegative)
+    {
+        // Any seen location other than the one just shown and the one prepared for the next trial
+        const int32 FirstCandidate = FMath::RandRange(0, SeenStimulusIndices.Num() - 1);
+        int32 StimulusIndex = INDEX_NONE;
+        for (int32 Attempt = 0; Attempt < FMath::Min(SeenStimulusIndices.Num(), 3) && StimulusIndex == INDEX_NONE; ++Attempt)
+        {
+            const int32 Candidate = SeenStimulusIndices[(FirstCandidate + Attempt) % SeenStimulusIndices.Num()];
+            if (Candidate != CurrentStimulusIndex && Candidate != PreparedStimulusIndex)
             {
-                // Ensure that the test is still running and waiting for input
-                if (TestState != ETestState::WaitingForInput || bIsTestPaused)
-                {
-                    return;
-                }
+                StimulusIndex = Candidate;
+            }
+        }
+        if (StimulusIndex == INDEX_NONE)
+        {
+            return;
+        }
 
-                // Check if the user responded during the catch trial
-                bool bStimulusDetected = WasStimulusDetected();
+        // Flash it like a test stimulus, well above the dimmest intensity seen there; the next
+        // test stimulus is a different one, so its prepared intensity stays valid
+        const int32 KeptPreparedStimulusIndex = PreparedStimulusIndex;
+        const float KeptPreparedIntensityInDb = PreparedStimulusIntensityInDb;
+        FlashStimuli(StimulusIndex, FMath::Max(0.0f, SeenIntensityInDb[StimulusIndex] - FalseNegativeCatchOffsetInDb));
+        PreparedStimulusIndex = KeptPreparedStimulusIndex;
+        PreparedStimulusIntensityInDb = KeptPreparedIntensityInDb;
+        if (StimulusPresentations.IsValidIndex(ActivePresentationIndex))
+        {
+            StimulusPresentations[ActivePresentationIndex].bCatchTrial = true;
+        }
+        CatchStimulusIndex = StimulusIndex;
+        CatchPresentationIndex = ActivePresentationIndex;
+    }
 
-                if (bStimulusDetected)
-                {
-                    // User responded when no stimulus was presented (false positive)
-                    FalsePositiveCount++;
-                    LogMessage = "False positive detected during catch trial.";
-                    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+    ActiveCatchTrial = CatchTrialType;
+    bCatchTrialResponded = false;
+    CatchTrialOpenCycles = (int64)FPlatformTime::Cycles64();
+    CatchTrialOpenFrame = (int64)GFrameCounter;
 
-                    // Optionally adjust test parameters due to unreliable responses
-                    TimeBetweenStimuli = FMath::Clamp(TimeBetweenStimuli + 0.2f, MinTimeBetweenStimuli, MaxTimeBetweenStimuli);  // Slow down the test
-                }
+    // A false-negative catch stimulus was answered as it was flashed; the empty gap gets the responder's guess
+    if (bHeadlessDriver && CatchTrialType == ECatchTrialType::FalsePositive)
+    {
+        ScheduleScriptedResponse(INDEX_NONE, 0.0f);
+    }
+}
 
-                // Reset test state and proceed to the next stimulus
-                TestState = ETestState::Running;
+// Scores the catch trial hosted by the gap that just ended, updating the reliability indices in place
+void ATestStimuli::CloseCatchTrial()
+{
+    GetWorld()->GetTimerManager().ClearTimer(CatchTrialTimerHandle);
+    if (ActiveCatchTrial == ECatchTrialType::None)
+    {
+        return;
+    }
 
-                // Schedule the next RunTest() call using adjusted time
-                GetWorld()->GetTimerManager().SetTimer(StimuliPresentationTimerHandle, this, &ATestStimuli::RunTest, AdjustedTimeBetweenStimuli, false);
+    // A press is an error on a false-positive catch trial, and the lack of one on a false-negative one
+    const bool bFalsePositiveTrial = ActiveCatchTrial == ECatchTrialType::FalsePositive;
+    if (bFalsePositiveTrial)
+    {
+        Reliability.AddFalsePositiveTrial(bCatchTrialResponded);
+        SessionReliability.AddFalsePositiveTrial(bCatchTrialResponded);
+
+        // Nothing was shown, so the journal gets a record of the empty gap instead of a presentation
+        FStimulusPresentation EmptyGap;
+        EmptyGap.OnsetFrame = CatchTrialOpenFrame;
+        EmptyGap.OnsetCycles = CatchTrialOpenCycles;
+        EmptyGap.bCatchTrial = true;
+        EmptyGap.bSeen = bCatchTrialResponded;
+        AppendJournalRecord(EmptyGap);
+    }
+    else
+    {
+        Reliability.AddFalseNegativeTrial(bCatchTrialResponded);
+        SessionReliability.AddFalseNegativeTrial(bCatchTrialResponded);
+        if (StimulusPresentations.IsValidIndex(CatchPresentationIndex))
+        {
+            StimulusPresentations[CatchPresentationIndex].bSeen = bCatchTrialResponded;
+            StimulusPresentations[CatchPresentationIndex].bOutcomeKnown = true;
+            TryJournalPresentation(CatchPresentationIndex);
+        }
+    }
+    ActiveCatchTrial = ECatchTrialType::None;
+    CatchStimulusIndex = INDEX_NONE;
+    CatchPresentationIndex = INDEX_NONE;
+
+    const bool bWasUnreliable = Reliability.bIsUnreliable;
+    Reliability.bIsUnreliable = (Reliability.NumFalsePositiveTrials >= MinCatchTrialsForReliability && Reliability.FalsePositiveRate > MaxFalsePositiveRate)
+        || (Reliability.NumFalseNegativeTrials >= MinCatchTrialsForReliability && Reliability.FalseNegativeRate > MaxFalseNegativeRate);
+
+    LogMessage = FString::Printf(TEXT("%s catch trial %s. False positives %d/%d (%.0f%%), false negatives %d/%d (%.0f%%)."),
+        bFalsePositiveTrial ? TEXT("False-positive") : TEXT("False-negative"), bCatchTrialResponded ? TEXT("answered") : TEXT("not answered"),
+        Reliability.NumFalsePositives, Reliability.NumFalsePositiveTrials, Reliability.FalsePositiveRate * 100.0f,
+        Reliability.NumFalseNegatives, Reliability.NumFalseNegativeTrials, Reliability.FalseNegativeRate * 100.0f);
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
 
-            }, AdjustedStimuliDuration + AdjustedTimeBetweenStimuli, false);
+    if (Reliability.bIsUnreliable && !bWasUnreliable)
+    {
+        LogMessage = FString::Printf(TEXT("Responses of the %s eye are unreliable (limits %.0f%% false positives, %.0f%% false negatives)."),
+            bIsLeftEye ? TEXT("left") : TEXT("right"), MaxFalsePositiveRate * 100.0f, MaxFalseNegativeRate * 100.0f);
+        LogManager.LogMessage(LogMessage, ELogVerbosity::Error, 10.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
     }
+}
 
-    return bIsCatchTrial;
+// Logs the reliability indices of the eye just tested
+void ATestStimuli::ReportReliability()
+{
+    LogMessage = FString::Printf(TEXT("Reliability (%s eye): false positives %d/%d (%.0f%%), false negatives %d/%d (%.0f%%), %d anticipatory presses discarded, %s."),
+        bIsLeftEye ? TEXT("left") : TEXT("right"),
+        Reliability.NumFalsePositives, Reliability.NumFalsePositiveTrials, Reliability.FalsePositiveRate * 100.0f,
+        Reliability.NumFalseNegatives, Reliability.NumFalseNegativeTrials, Reliability.FalseNegativeRate * 100.0f,
+        Reliability.NumAnticipatoryResponses,
+        Reliability.bIsUnreliable ? TEXT("unreliable") : TEXT("reliable"));
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
 }
 
 // Tracks whether the user is failing to focus and adjusts the test speed accordingly.
@@ -690,43 +1332,78 @@ void ATestStimuli::TrackAttentionLapses(bool bSeen)
     }
 }
 
-// Computes the ratio of correct responses to total stimuli presented to gauge test reliability.
+// Computes the share of catch trials answered correctly to gauge test reliability.
 float ATestStimuli::CalculateResponseReliability()
 {
-    int32 TotalStimuliPresented = TestResultsArray.Num();
-    int32 TotalSeen = TestResultsArray.FilterByPredicate([](const FTestResults& Result) { return Result.bSeen; }).Num();
-    return TotalSeen / static_cast<float>(TotalStimuliPresented);  // Calculate response reliability ratio
+    const int32 NumCatchTrials = Reliability.GetNumTrials();
+    return NumCatchTrials > 0 ? 1.0f - Reliability.GetNumErrors() / static_cast<float>(NumCatchTrials) : 1.0f;
 }
 
-// Determines if the user detected the stimulus based on eye gaze and user input.
+// Determines if the user detected the stimulus from their input. Fixation was checked on every frame of the flash,
+// and a trial that lost it never gets here; the gaze may leave the fixation point once the stimulus is gone.
 bool ATestStimuli::WasStimulusDetected()
 {
-    // Check if the user's gaze was focused on the fixation point during stimulus presentation and key pressed
-    if (CheckGazeFocus() && bUserResponded)
+    if (bUserResponded)
     {
         bUserResponded = false;  // Reset the flag for the next stimulus
         return true;
     }
-    else
-    {
-        LogMessage = "Gaze left the fixation point during stimulus presentation.";
-        LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
-        return false;
-    }
+    return false;
 }
 
-// Function to set a flag indicating the stimulus was detected
+// Function to set a flag indicating the stimulus was detected, and to time the press from the stimulus's onset
 void ATestStimuli::OnStimulusDetected()
 {
+    // Stamp the press before anything else runs
+    const uint64 PressCycles = FPlatformTime::Cycles64();
+
+    // Between stimuli, a press only counts toward the catch trial open in the gap
+    if (TestState == ETestState::Running && ActiveCatchTrial != ECatchTrialType::None)
+    {
+        bCatchTrialResponded = true;
+        return;
+    }
+
     if (TestState == ETestState::WaitingForInput)
     {
         bUserResponded = true;
+
+        // The first press of the trial is its reaction time
+        if (StimulusPresentations.IsValidIndex(TrialPresentationIndex) && StimulusPresentations[TrialPresentationIndex].ReactionTimeSeconds < 0.0f)
+        {
+            // A headless run is timed on the game clock, which runs ahead of the wall clock
+            FStimulusPresentation& Presentation = StimulusPresentations[TrialPresentationIndex];
+            Presentation.ResponseCycles = (int64)PressCycles;
+            Presentation.ReactionTimeSeconds = bHeadlessDriver ? (float)(GetWorld()->GetTimeSeconds() - StimulusOnsetSeconds) : (float)FPlatformTime::ToSeconds64(PressCycles - (uint64)Presentation.OnsetCycles);
+        }
+
+        // Close the stimulus's response window without waiting it out, but no sooner than MinResponseSeconds after onset
+        FTimerManager& TimerManager = GetWorld()->GetTimerManager();
+        if (bAdvanceOnResponse && TimerManager.IsTimerActive(StimulusResponseTimerHandle))
+        {
+            const float SecondsSinceOnset = (float)(GetWorld()->GetTimeSeconds() - StimulusOnsetSeconds);
+            if (SecondsSinceOnset >= MinResponseSeconds)
+            {
+                HandleStimulusResponse();
+            }
+            else
+            {
+                TimerManager.SetTimer(StimulusResponseTimerHandle, this, &ATestStimuli::HandleStimulusResponse, MinResponseSeconds - SecondsSinceOnset, false);
+            }
+        }
     }
 }
 
-// Monitors the user's eye gaze to verify that they are focusing on the fixation point.
+// Monitors the user's eye gaze and cues it back to the fixation point. Trials are gated on fixation frame by
+// frame while their stimulus is shown (see SampleGazeOnFixation), so looking away only brings up the converging lines.
 bool ATestStimuli::CheckGazeFocus()
 {
+    // The scripted responder's gaze is sampled where it gates trials
+    if (bHeadlessDriver)
+    {
+        return true;
+    }
+
     if (bIsDemoMode)
     {
         // If demo mode is active, pause the test and return early without checking eye-tracking data.
@@ -737,6 +1414,9 @@ bool ATestStimuli::CheckGazeFocus()
         return true;
     }
 
+#if !PERIMAPXR_WITH_PICO
+    return false;
+#else
     // Retrieve eye-tracking data to check if the user's gaze is focused on the fixation point
     if (PICOXRMotionTracking::GetEyeTrackingData(0.0f, GetInfo, EyeTrackingData))
     {
@@ -760,76 +1440,189 @@ bool ATestStimuli::CheckGazeFocus()
             return false;
         }
 
-        // Retrieve the current position and orientation of the HMD (head-mounted display)
-        FQuat HMDOrientation = UPICOXRHMDFunctionLibrary::PXR_GetCurrentOrientation();
-        FVector HMDPosition = UPICOXRHMDFunctionLibrary::PXR_GetCurrentPosition();
-
-        // Rotate the gaze direction according to the HMD's current orientation
-        FVector WorldGazeDirection = HMDOrientation.RotateVector(GazeDirection);
-
-        // Calculate the vector pointing to the fixation point and normalize it
-        FVector FixationLocation = FixationActor->GetActorLocation();
-        FVector ToFixation = (FixationLocation - HMDPosition).GetSafeNormal();
-
-        // Check if the gaze is within a certain angular threshold of the fixation point
-        float GazeToleranceDegrees = 10.0f;  // Define as needed
-        bool bIsGazingAtFixation = FVector::DotProduct(WorldGazeDirection, ToFixation) > FMath::Cos(FMath::DegreesToRadians(GazeToleranceDegrees));
-
-        if (bIsGazingAtFixation)
-        {
-            // If the user is gazing at the fixation point, hide the converging lines and resume the test
-            if (ConvergingLinesActor)
-            {
-                ConvergingLinesActor->SetActorHiddenInGame(true);
-            }
-            if (TestState == ETestState::Paused)
-            {
-                ResumeTest();
-            }
-            return true;
-        }
-        else
+        // Show the converging lines while the user is not focused on the fixation point, and hide them once they are
+        bool bIsGazingAtFixation = IsGazeDirectionOnFixation(GazeDirection);
+        if (ConvergingLinesActor)
         {
-            // If the user is not focused on the fixation point, show the converging lines and pause the test
-            if (ConvergingLinesActor)
-            {
-                ConvergingLinesActor->SetActorHiddenInGame(false);
-            }
-            if (TestState != ETestState::Paused)
-            {
-                PauseTest();
-            }
-            return false;
+            ConvergingLinesActor->SetActorHiddenInGame(bIsGazingAtFixation);
         }
+        return bIsGazingAtFixation;
     }
     else
     {
         // Log an error if the eye-tracking data retrieval fails
         LogMessage = "Failed to retrieve eye tracking data.";
         LogManager.LogMessage(LogMessage, ELogVerbosity::Error, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
-        if (TestState != ETestState::Paused)
-        {
-            PauseTest();
-        }
         return false;
     }
+#endif
 }
 
-// Dynamically adjusts the timing of stimulus presentation based on user consistency.
-void ATestStimuli::AdjustTimingBasedOnResponses()
+// Whether a gaze direction in HMD space points at the fixation point, within FixationToleranceDegrees
+bool ATestStimuli::IsGazeDirectionOnFixation(const FVector& GazeDirection) const
 {
-    if (ConsistentResponsesCount > 5)
+    return GetGazeErrorInDeg(GazeDirection) <= FixationToleranceDegrees;
+}
+
+// Angle between a gaze direction in HMD space and the direction of the fixation point; 180 degrees without one
+float ATestStimuli::GetGazeErrorInDeg(const FVector& GazeDirection) const
+{
+    if (!FixationActor)
     {
-        // Speed up the test if the participant is responding consistently
-        TimeBetweenStimuli = FMath::Clamp(TimeBetweenStimuli - 0.1f, 0.5f, 1.0f);
+        return 180.0f;
     }
-    else
+
+    // Retrieve the current position and orientation of the HMD (head-mounted display)
+#if PERIMAPXR_WITH_PICO
+    FQuat HMDOrientation = UPICOXRHMDFunctionLibrary::PXR_GetCurrentOrientation();
+    FVector HMDPosition = UPICOXRHMDFunctionLibrary::PXR_GetCurrentPosition();
+#else
+    FQuat HMDOrientation = FQuat::Identity;
+    FVector HMDPosition = FVector::ZeroVector;
+#endif
+
+    // Rotate the gaze direction according to the HMD's current orientation
+    FVector WorldGazeDirection = HMDOrientation.RotateVector(GazeDirection);
+
+    // Calculate the vector pointing to the fixation point and normalize it
+    FVector ToFixation = (FixationActor->GetActorLocation() - HMDPosition).GetSafeNormal();
+
+    // Angle between the gaze and the fixation point
+    return FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(FVector::DotProduct(WorldGazeDirection.GetSafeNormal(), ToFixation), -1.0f, 1.0f)));
+}
+
+// Reads the newest gaze sample of the tested eye, unsmoothed so a saccade shows on the frame it is sampled.
+// False when there is no valid sample this frame, in which case the outputs are left as they were
+bool ATestStimuli::SampleGazeOnFixation(bool& bOutOnFixation, float& OutGazeErrorInDeg)
+{
+    if (bHeadlessDriver)
+    {
+        OutGazeErrorInDeg = ScriptedResponder.DrawGazeErrorInDeg(GetWorld()->GetDeltaSeconds());
+        bOutOnFixation = OutGazeErrorInDeg <= FixationToleranceDegrees;
+        return true;
+    }
+
+    if (bIsDemoMode)
+    {
+        OutGazeErrorInDeg = 0.0f;
+        bOutOnFixation = true;
+        return true;
+    }
+
+#if !PERIMAPXR_WITH_PICO
+    return false;
+#else
+    FPXREyeTrackingData GateSample;
+    if (!PICOXRMotionTracking::GetEyeTrackingData(0.0f, GetInfo, GateSample))
+    {
+        return false;
+    }
+
+    const FPXRPerEyeData& EyeData = bIsLeftEye ? GateSample.PerEyeDatas[0] : GateSample.PerEyeDatas[1];
+    if (!EyeData.bIsPoseValid)
+    {
+        return false;
+    }
+
+    OutGazeErrorInDeg = GetGazeErrorInDeg(EyeData.Orientation.Vector());
+    bOutOnFixation = OutGazeErrorInDeg <= FixationToleranceDegrees;
+    return true;
+#endif
+}
+
+// Throws away the trial waiting for a response because it was pressed for too soon after onset. Its response is never
+// posted and its location is requeued, as for a loss of fixation; the press counts against the eye's reliability
+void ATestStimuli::DiscardAnticipatoryResponse(float ReactionTimeSeconds)
+{
+    // Discarded is an outcome too: it is journaled as not seen, with the press marked anticipatory
+    const int32 AnsweredPresentationIndex = TrialPresentationIndex;
+    if (StimulusPresentations.IsValidIndex(AnsweredPresentationIndex))
+    {
+        StimulusPresentations[AnsweredPresentationIndex].bAnticipatory = true;
+        StimulusPresentations[AnsweredPresentationIndex].bSeen = false;
+        StimulusPresentations[AnsweredPresentationIndex].bOutcomeKnown = true;
+    }
+    TrialPresentationIndex = INDEX_NONE;
+    TryJournalPresentation(AnsweredPresentationIndex);
+    bUserResponded = false;
+
+    Reliability.AddAnticipatoryResponse();
+    SessionReliability.AddAnticipatoryResponse();
+    LogMessage = FString::Printf(TEXT("Press %.0f ms after the onset of stimulus %d is too fast to be a response; trial discarded and location requeued."), ReactionTimeSeconds * 1000.0f, CurrentStimulusIndex);
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Log, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+
+    if (ThresholdEstimator)
     {
-        // Slow down the test if responses are inconsistent
-        TimeBetweenStimuli = FMath::Clamp(TimeBetweenStimuli + 0.1f, 1.0f, 2.0f);
+        AsyncEstimator.RequeueTrial(CurrentStimulusIndex);
+    }
+    TestState = ETestState::Running;
+
+    // Start the gap to the next stimulus as after a response, without hosting a catch trial
+    GetWorld()->GetTimerManager().SetTimer(StimuliPresentationTimerHandle, this, &ATestStimuli::RunTest, TimeBetweenStimuli, false);
+    PreparedStimulusIndex = INDEX_NONE;
+    if (ThresholdEstimator)
+    {
+        GetWorld()->GetTimerManager().SetTimerForNextTick(this, &ATestStimuli::PrepareNextStimulus);
     }
 }
 
+// Throws away the trial on screen because fixation was off during its flash. A test trial's response is never
+// posted, so its location's posterior is untouched and the estimator puts it back among the locations to test;
+// a catch trial is dropped unscored. The test carries on with the next gap
+void ATestStimuli::InvalidateStimulusPresentation()
+{
+    if (!StimulusPresentations.IsValidIndex(ActivePresentationIndex))
+    {
+        return;
+    }
+
+    // Discarded is an outcome too: it is journaled as not seen, with fixation lost
+    StimulusPresentations[ActivePresentationIndex].bFixationLost = true;
+    StimulusPresentations[ActivePresentationIndex].bOutcomeKnown = true;
+    const bool bCatchTrial = StimulusPresentations[ActivePresentationIndex].bCatchTrial;
+    const int32 StimulusIndex = StimulusPresentations[ActivePresentationIndex].StimulusIndex;
+    EndStimulusPresentation(true);
+
+    if (bCatchTrial)
+    {
+        ActiveCatchTrial = ECatchTrialType::None;
+        CatchStimulusIndex = INDEX_NONE;
+        CatchPresentationIndex = INDEX_NONE;
+        NumInvalidatedCatchTrials++;
+        LogMessage = FString::Printf(TEXT("Fixation lost during catch stimulus %d; catch trial dropped."), StimulusIndex);
+        LogManager.LogMessage(LogMessage, ELogVerbosity::Log, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+        return;
+    }
+
+    if (TestState != ETestState::WaitingForInput)
+    {
+        return;
+    }
+
+    // Close the response window unscored; a press it gets from here on falls in the gap and counts for nothing
+    GetWorld()->GetTimerManager().ClearTimer(StimulusResponseTimerHandle);
+    bUserResponded = false;
+    TrialPresentationIndex = INDEX_NONE;
+    NumInvalidatedTrials++;
+    LogMessage = FString::Printf(TEXT("Fixation lost during stimulus %d; trial discarded and location requeued."), StimulusIndex);
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Log, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+
+    if (ThresholdEstimator)
+    {
+        AsyncEstimator.RequeueTrial(CurrentStimulusIndex);
+    }
+    TestState = ETestState::Running;
+
+    // Start the gap to the next stimulus as after a response, without hosting a catch trial
+    GetWorld()->GetTimerManager().SetTimer(StimuliPresentationTimerHandle, this, &ATestStimuli::RunTest, TimeBetweenStimuli, false);
+    PreparedStimulusIndex = INDEX_NONE;
+    if (ThresholdEstimator)
+    {
+        GetWorld()->GetTimerManager().SetTimerForNextTick(this, &ATestStimuli::PrepareNextStimulus);
+    }
+}
+
+#if PERIMAPXR_WITH_PICO
 // Function to add data to the buffer and keep it within the BufferSize limit
 void ATestStimuli::AddEyeTrackingDataToBuffer(const FPXREyeTrackingData& NewData)
 {
@@ -842,10 +1635,14 @@ void ATestStimuli::AddEyeTrackingDataToBuffer(const FPXREyeTrackingData& NewData
         EyeTrackingDataBuffer.RemoveAt(BufferSize);  // Remove the oldest data
     }
 }
+#endif
 
 // Function to compute a smoothed gaze direction by averaging the buffered data
 FVector ATestStimuli::GetSmoothedGazeDirection()
 {
+#if !PERIMAPXR_WITH_PICO
+    return FVector::ZeroVector;
+#else
     if (EyeTrackingDataBuffer.Num() == 0) return FVector::ZeroVector;
 
     FVector SmoothedGazeDirection = FVector::ZeroVector;
@@ -869,6 +1666,7 @@ FVector ATestStimuli::GetSmoothedGazeDirection()
     // Normalize the resulting gaze direction vector
     SmoothedGazeDirection /= EyeTrackingDataBuffer.Num();
     return SmoothedGazeDirection;
+#endif
 }
 
 // Function to predict the user's gaze based on the angular velocity
@@ -876,6 +1674,7 @@ FVector ATestStimuli::PredictGazeDirection(float PredictionTime)
 {
     FVector PredictedGazeDirection = FVector::ZeroVector;
 
+#if PERIMAPXR_WITH_PICO
     if (EyeTrackingDataBuffer.Num() > 0)
     {
         // Get the most recent eye-tracking data
@@ -888,6 +1687,7 @@ FVector ATestStimuli::PredictGazeDirection(float PredictionTime)
         // Predict the next gaze direction based on current angular velocity
         PredictedGazeDirection = CurrentGazeDirection + AngularVelocity * PredictionTime;
     }
+#endif
 
     // Return the predicted direction, normalized
     return PredictedGazeDirection.GetSafeNormal();
@@ -903,6 +1703,7 @@ FVector ATestStimuli::InterpolateGazeDirection(float DeltaTime, float Interpolat
     FVector LastGazePosition = SmoothedGazeDirection;
     FVector CurrentGazePosition = FVector::ZeroVector;  // Placeholder for actual gaze direction
 
+#if PERIMAPXR_WITH_PICO
     if (EyeTrackingDataBuffer.Num() > 0)
     {
         // Retrieve the most recent gaze direction
@@ -915,6 +1716,7 @@ FVector ATestStimuli::InterpolateGazeDirection(float DeltaTime, float Interpolat
         FVector PredictedGaze = PredictGazeDirection(0.05f);  // Predict 50ms ahead
         CurrentGazePosition = FMath::VInterpTo(LastGazePosition, PredictedGaze, DeltaTime, InterpolationSpeed);
     }
+#endif
 
     return CurrentGazePosition.GetSafeNormal();
 }
@@ -930,8 +1732,9 @@ void ATestStimuli::SwitchEye()
     CurrentStimulusIndex = 0;
     CleanupStimuli();
 
-    // Reconfigure the test for the newly selected eye and start the test
+    // Reconfigure the test for the newly selected eye and start the test; StartTest only runs from Idle
     SetupTest(TestType);
+    TestState = ETestState::Idle;
     StartTest();
 }
 
@@ -960,14 +1763,8 @@ FVector ATestStimuli::PolarToCartesian(float Radius, float VerticalAngle, float
 // Monitors the latency between frames to detect performance spikes.
 void ATestStimuli::MonitorLatency()
 {
-    static float LastFrameTime = FPlatformTime::Seconds();  // Keep track of the previous frame time
-    float CurrentTime = FPlatformTime::Seconds();           // Get the current time
-
-    // Calculate the time difference between the current frame and the last frame
-    float FrameLatency = CurrentTime - LastFrameTime;
-
-    // Update the last frame time to the current time
-    LastFrameTime = CurrentTime;
+    // Real time between the current frame and the last frame, whenever this is sampled
+    float FrameLatency = FApp::GetDeltaTime();
 
     // Initialize DetectedLatency if it's the first frame
     if (DetectedLatency == 0.0f)
@@ -990,4 +1787,84 @@ void ATestStimuli::MonitorLatency()
         LogMessage = FString::Printf(TEXT("Latency spike detected: %f seconds."), DetectedLatency);
         LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
     }
+}
+
+// Sets up a headless run. Frames advance on a fixed step of one display frame without waiting on the wall clock, and
+// the game clock is dilated on top of that, so the test runs as fast as the game thread can take it; the scripted
+// responder stands in for the participant and the eye tracker
+void ATestStimuli::InitializeHeadlessDriver()
+{
+    FParse::Value(FCommandLine::Get(), TEXT("HeadlessTimeDilation="), HeadlessTimeDilation);
+    FParse::Value(FCommandLine::Get(), TEXT("HeadlessSeed="), HeadlessSeed);
+    HeadlessTimeDilation = FMath::Max(HeadlessTimeDilation, 1.0f);
+
+    FApp::SetUseFixedTimeStep(true);
+    FApp::SetFixedDeltaTime(1.0 / RefreshRate);
+    AWorldSettings* WorldSettings = GetWorld()->GetWorldSettings();
+    WorldSettings->MaxGlobalTimeDilation = FMath::Max(WorldSettings->MaxGlobalTimeDilation, HeadlessTimeDilation);
+    UGameplayStatics::SetGlobalTimeDilation(this, HeadlessTimeDilation);
+
+    // Time every game-thread frame of the run, not just the ones the actor ticks on
+    HeadlessBeginFrameHandle = FCoreDelegates::OnBeginFrame.AddWeakLambda(this, [this]()
+    {
+        HeadlessFrameStartCycles = FPlatformTime::Cycles64();
+    });
+    HeadlessEndFrameHandle = FCoreDelegates::OnEndFrame.AddWeakLambda(this, [this]()
+    {
+        if (HeadlessFrameStartCycles != 0)
+        {
+            HeadlessGameThreadCycles += FPlatformTime::Cycles64() - HeadlessFrameStartCycles;
+            HeadlessNumFrames++;
+        }
+    });
+
+    HeadlessStartWallSeconds = FPlatformTime::Seconds();
+    HeadlessStartWorldSeconds = GetWorld()->GetTimeSeconds();
+    HeadlessGameThreadCycles = 0;
+    HeadlessNumFrames = 0;
+    NumSessionTrials = 0;
+
+    LogMessage = FString::Printf(TEXT("Headless run: game clock at %.1fx on a fixed %.0f Hz step, responder seed %d."), HeadlessTimeDilation, RefreshRate, HeadlessSeed);
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+}
+
+// Has the scripted responder press for a stimulus it sees, after its reaction time on the game clock
+void ATestStimuli::ScheduleScriptedResponse(int32 StimulusIndex, float StimulusIntensityInDb)
+{
+    if (ScriptedResponder.DrawSeen(StimulusIndex, StimulusIntensityInDb))
+    {
+        GetWorld()->GetTimerManager().SetTimer(ScriptedPressTimerHandle, this, &ATestStimuli::OnStimulusDetected, ScriptedResponder.DrawReactionTimeSeconds(), false);
+    }
+}
+
+// Logs the throughput of the run that just tested both eyes: trials per wall-clock second, game-thread time per
+// trial and the test time it stood for
+void ATestStimuli::FinishHeadlessRun()
+{
+    FCoreDelegates::OnBeginFrame.Remove(HeadlessBeginFrameHandle);
+    FCoreDelegates::OnEndFrame.Remove(HeadlessEndFrameHandle);
+
+    const double WallSeconds = FMath::Max(FPlatformTime::Seconds() - HeadlessStartWallSeconds, KINDA_SMALL_NUMBER);
+    const double SimulatedSeconds = GetWorld()->GetTimeSeconds() - HeadlessStartWorldSeconds;
+    const double GameThreadSeconds = FPlatformTime::ToSeconds64(HeadlessGameThreadCycles);
+    const int32 NumTrials = FMath::Max(NumSessionTrials, 1);
+    LogMessage = FString::Printf(TEXT("Headless run finished: %d trials in %.2f s wall clock (%.1f trials/s); game thread %.3f ms per trial, %.3f ms per frame over %d frames; %.1f s of test time (%.1fx real time)."),
+        NumSessionTrials, WallSeconds, NumSessionTrials / WallSeconds, GameThreadSeconds * 1000.0 / NumTrials, GameThreadSeconds * 1000.0 / FMath::Max(HeadlessNumFrames, 1), HeadlessNumFrames,
+        SimulatedSeconds, SimulatedSeconds / WallSeconds);
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Warning, 10.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+
+    // The scripted responder guesses and lapses at known rates, and a false-negative catch stimulus is well above its threshold,
+    // so catch trials over the reliability limits mean the catch trials or the responder are broken rather than the participant
+    const bool bFalsePositivesSane = SessionReliability.NumFalsePositiveTrials < MinCatchTrialsForReliability || SessionReliability.FalsePositiveRate <= MaxFalsePositiveRate;
+    const bool bFalseNegativesSane = SessionReliability.NumFalseNegativeTrials < MinCatchTrialsForReliability || SessionReliability.FalseNegativeRate <= MaxFalseNegativeRate;
+    LogMessage = FString::Printf(TEXT("Headless catch trials: false positives %d/%d (%.0f%%, responder %.0f%%), false negatives %d/%d (%.0f%%, responder %.0f%%)%s."),
+        SessionReliability.NumFalsePositives, SessionReliability.NumFalsePositiveTrials, SessionReliability.FalsePositiveRate * 100.0f, ScriptedResponder.Params.GuessRate * 100.0f,
+        SessionReliability.NumFalseNegatives, SessionReliability.NumFalseNegativeTrials, SessionReliability.FalseNegativeRate * 100.0f, ScriptedResponder.Params.LapseRate * 100.0f,
+        bFalsePositivesSane && bFalseNegativesSane ? TEXT("") : TEXT(": over the reliability limits, check failed"));
+    LogManager.LogMessage(LogMessage, bFalsePositivesSane && bFalseNegativesSane ? ELogVerbosity::Warning : ELogVerbosity::Error, 10.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+
+    if (bExitAfterHeadlessRun)
+    {
+        FPlatformMisc::RequestExitWithStatus(false, bFalsePositivesSane && bFalseNegativesSane ? 0 : 1);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,140 @@
+// FAsyncThresholdEstimator.cpp
+
+#include "FAsyncThresholdEstimator.h"
+#include "UThresholdEstimator.h"
+
+// Constructor
+FAsyncThresholdEstimator::FAsyncThresholdEstimator()
+    : Estimator(nullptr)
+{
+}
+
+// Destructor; no task may outlive the facade
+FAsyncThresholdEstimator::~FAsyncThresholdEstimator()
+{
+    Flush();
+}
+
+// Hands an initialized estimator to the task chain and starts preparing the first trial
+void FAsyncThresholdEstimator::Begin(UThresholdEstimator* InEstimator)
+{
+    check(IsInGameThread());
+    Flush();
+
+    Estimator = InEstimator;
+    PreparedTrial = FPreparedTrial();
+    if (Estimator)
+    {
+        Estimator->SetOwnedByTaskGraph(true);
+        Dispatch([this]() { PrepareTrial(INDEX_NONE, INDEX_NONE); });
+    }
+}
+
+// Posts the response to the trial just presented; the next trial is prepared from the updated posterior
+void FAsyncThresholdEstimator::PostResponse(int32 LocationIndex, float StimulusIntensityInDb, bool bSeen)
+{
+    check(IsInGameThread());
+    if (!Estimator)
+    {
+        return;
+    }
+
+    Dispatch([this, LocationIndex, StimulusIntensityInDb, bSeen]()
+    {
+        Estimator->UpdateWithResponseAtIndex(LocationIndex, StimulusIntensityInDb, bSeen);
+        PrepareTrial(LocationIndex, LocationIndex);
+    });
+}
+
+// Puts back a trial that was thrown away without a response. Its location is still incomplete, so it stays among
+// the locations to test; preparing from it as the previous one moves the next trial to another quadrant first
+void FAsyncThresholdEstimator::RequeueTrial(int32 LocationIndex)
+{
+    check(IsInGameThread());
+    if (!Estimator)
+    {
+        return;
+    }
+
+    Dispatch([this, LocationIndex]() { PrepareTrial(LocationIndex, INDEX_NONE); });
+}
+
+// Whether every posted task has finished, so the prepared trial can be read
+bool FAsyncThresholdEstimator::IsTrialReady() const
+{
+    return !LastTask.IsValid() || LastTask->IsComplete();
+}
+
+// Copies the prepared trial into OutTrial and hands over its location updates; false while it is still being prepared
+bool FAsyncThresholdEstimator::TryGetNextTrial(FPreparedTrial& OutTrial)
+{
+    check(IsInGameThread());
+    if (!IsTrialReady())
+    {
+        return false;
+    }
+
+    OutTrial = PreparedTrial;
+    PreparedTrial.LocationUpdates.Reset();
+    return true;
+}
+
+// Waits for every posted task and returns the estimator to the game thread
+void FAsyncThresholdEstimator::Flush()
+{
+    if (LastTask.IsValid())
+    {
+        FTaskGraphInterface::Get().WaitUntilTaskCompletes(LastTask);
+        LastTask = nullptr;
+    }
+    if (Estimator)
+    {
+        Estimator->SetOwnedByTaskGraph(false);
+    }
+    Estimator = nullptr;
+}
+
+// Queues Work after the previous task on a background worker
+void FAsyncThresholdEstimator::Dispatch(TUniqueFunction<void()>&& Work)
+{
+    FGraphEventArray Prerequisites;
+    if (LastTask.IsValid())
+    {
+        Prerequisites.Add(LastTask);
+    }
+    LastTask = FFunctionGraphTask::CreateAndDispatchWhenReady(MoveTemp(Work), TStatId(), &Prerequisites, ENamedThreads::AnyBackgroundThreadNormalTask);
+}
+
+// Prepares the trial that follows PreviousIndex, publishing UpdatedIndex and the locations completed with it; runs on a worker thread
+void FAsyncThresholdEstimator::PrepareTrial(int32 PreviousIndex, int32 UpdatedIndex)
+{
+    // Updates the game thread has not taken yet are kept, so none is lost when tasks run back to back
+    FPreparedTrial Trial;
+    Trial.LocationUpdates = MoveTemp(PreparedTrial.LocationUpdates);
+
+    TArray<int32, TInlineAllocator<8>> UpdatedIndices;
+    if (UpdatedIndex != INDEX_NONE)
+    {
+        UpdatedIndices.Add(UpdatedIndex);
+    }
+    TArray<int32> CompletedIndices;
+    Estimator->TakeCompletedLocationIndices(CompletedIndices);
+    for (const int32 CompletedIndex : CompletedIndices)
+    {
+        UpdatedIndices.AddUnique(CompletedIndex);
+    }
+
+    for (const int32 Index : UpdatedIndices)
+    {
+        FLocationUpdate& Update = Trial.LocationUpdates.AddDefaulted_GetRef();
+        Update.LocationIndex = Index;
+        Update.Moments = Estimator->GetPosteriorMomentsAtIndex(Index);
+        Update.StoppingRule = Estimator->GetStoppingRuleAtIndex(Index);
+        Update.ThresholdInDb = Estimator->GetThresholdEstimateInDbAtIndex(Index);
+    }
+
+    Trial.LocationIndex = Estimator->GetNextLocationIndex(PreviousIndex);
+    Trial.StimulusIntensityInDb = Trial.LocationIndex != INDEX_NONE ? Estimator->GetNextStimulusIntensityInDbAtIndex(Trial.LocationIndex) : 0.0f;
+    Trial.ResponsesApplied = Estimator->GetTotalPresentations();
+    PreparedTrial = MoveTemp(Trial);
+}
@@ -0,0 +1,108 @@
+// FExpectedEntropySelector.cpp
+
+#include "FExpectedEntropySelector.h"
+#include "FThresholdPosteriorStore.h"
+#include "FPsychometricLikelihoodTable.h"
+#include "Math/UnrealMathUtility.h"
+
+// Posteriors up to this many levels are expanded on the stack
+typedef TArray<float, TInlineAllocator<128>> FPosteriorScratch;
+
+// Binary entropy (in nats) of an outcome with the given probability
+static float GetBinaryEntropy(float Probability)
+{
+    float Entropy = 0.0f;
+    if (Probability > 0.0f)
+    {
+        Entropy -= Probability * FMath::Loge(Probability);
+    }
+    if (Probability < 1.0f)
+    {
+        Entropy -= (1.0f - Probability) * FMath::Loge(1.0f - Probability);
+    }
+    return Entropy;
+}
+
+// Candidate intensity (in dB) that minimizes the expected posterior entropy at a location
+float FExpectedEntropySelector::SelectIntensityInDb(const FThresholdPosteriorStore& Store, const FPsychometricLikelihoodTable& Table, int32 LocationIndex)
+{
+    const int32 NumLevels = Store.GetNumLevels();
+    const int32 LevelOffset = Table.GetLevelOffset(Store.GetLevelOriginInDb(LocationIndex));
+
+    FPosteriorScratch Posterior;
+    Posterior.SetNumUninitialized(NumLevels);
+    Store.GetPosterior(LocationIndex, Posterior.GetData());
+
+    // The current entropy is the same for every candidate, so maximizing the information gain is enough
+    int32 BestBin = Table.GetIntensityBin(Store.GetLevelInDb(LocationIndex, 0));
+    float BestGain = -MAX_flt;
+    for (int32 Candidate = 0; Candidate < NumLevels; ++Candidate)
+    {
+        const int32 Bin = Table.GetIntensityBin(Store.GetLevelInDb(LocationIndex, Candidate));
+        const float Gain = GetInformationGain(Posterior.GetData(), NumLevels, Table, Bin, LevelOffset);
+        if (Gain > BestGain)
+        {
+            BestGain = Gain;
+            BestBin = Bin;
+        }
+    }
+
+    return Table.GetBinIntensityInDb(BestBin);
+}
+
+// Expected posterior entropy (in nats, on the store's EntropyStepInDb bins) at a location after presenting the stimulus in the given intensity bin
+float FExpectedEntropySelector::GetExpectedEntropy(const FThresholdPosteriorStore& Store, const FPsychometricLikelihoodTable& Table, int32 LocationIndex, int32 Bin)
+{
+    const int32 NumLevels = Store.GetNumLevels();
+    const float* LogPosterior = Store.GetLogPosterior(LocationIndex);
+    const float LogNormalizer = Store.GetLogNormalizer(LocationIndex);
+
+    FPosteriorScratch Posterior;
+    Posterior.SetNumUninitialized(NumLevels);
+
+    float Entropy = 0.0f;
+    for (int32 i = 0; i < NumLevels; ++i)
+    {
+        const float LogProbability = LogPosterior[i] - LogNormalizer;
+        Posterior[i] = FMath::Exp(LogProbability);
+        Entropy -= Posterior[i] * LogProbability;
+    }
+
+    // Measured on the same common bins as the cached moments; the information gain does not depend on the bin width
+    Entropy += Store.GetEntropyOffset(LocationIndex);
+    return Entropy - GetInformationGain(Posterior.GetData(), NumLevels, Table, Bin, Table.GetLevelOffset(Store.GetLevelOriginInDb(LocationIndex)));
+}
+
+// Expected information gain (in nats) at a location from presenting the stimulus in the given intensity bin; optionally also the probability it is seen
+float FExpectedEntropySelector::GetExpectedInformationGain(const FThresholdPosteriorStore& Store, const FPsychometricLikelihoodTable& Table, int32 LocationIndex, int32 Bin, float* OutProbabilityOfSeeing)
+{
+    const int32 NumLevels = Store.GetNumLevels();
+
+    FPosteriorScratch Posterior;
+    Posterior.SetNumUninitialized(NumLevels);
+    Store.GetPosterior(LocationIndex, Posterior.GetData());
+
+    return GetInformationGain(Posterior.GetData(), NumLevels, Table, Bin, Table.GetLevelOffset(Store.GetLevelOriginInDb(LocationIndex)), OutProbabilityOfSeeing);
+}
+
+// Mutual information between threshold and response for one bin, given a normalized posterior
+float FExpectedEntropySelector::GetInformationGain(const float* Posterior, int32 NumLevels, const FPsychometricLikelihoodTable& Table, int32 Bin, int32 LevelOffset, float* OutProbabilityOfSeeing)
+{
+    const float* SeenRow = Table.GetLikelihoodRow(Bin, true, LevelOffset);
+    const float* EntropyRow = Table.GetResponseEntropyRow(Bin, LevelOffset);
+
+    float ProbabilityOfSeeing = 0.0f;
+    float ConditionalEntropy = 0.0f;
+    for (int32 i = 0; i < NumLevels; ++i)
+    {
+        ProbabilityOfSeeing += Posterior[i] * SeenRow[i];
+        ConditionalEntropy += Posterior[i] * EntropyRow[i];
+    }
+
+    ProbabilityOfSeeing = FMath::Clamp(ProbabilityOfSeeing, 0.0f, 1.0f);
+    if (OutProbabilityOfSeeing)
+    {
+        *OutProbabilityOfSeeing = ProbabilityOfSeeing;
+    }
+    return GetBinaryEntropy(ProbabilityOfSeeing) - ConditionalEntropy;
+}
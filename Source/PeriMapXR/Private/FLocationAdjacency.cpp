@@ -0,0 +1,93 @@
+// FLocationAdjacency.cpp
+
+#include "FLocationAdjacency.h"
+#include "Math/UnrealMathUtility.h"
+
+// Constructor
+FLocationAdjacency::FLocationAdjacency()
+    : NeighbourRadiusInDeg(0.0f)
+{
+    NeighbourOffsets.Add(0);
+}
+
+// Rebuilds the table for the given stimulus locations
+void FLocationAdjacency::Build(const TArray<FVector>& Locations, float InNeighbourRadiusInDeg)
+{
+    NeighbourRadiusInDeg = InNeighbourRadiusInDeg;
+    const int32 NumLocations = Locations.Num();
+
+    AngularPositions.SetNumUninitialized(NumLocations);
+    for (int32 i = 0; i < NumLocations; ++i)
+    {
+        AngularPositions[i] = ToAngularPosition(Locations[i]);
+    }
+
+    NeighbourOffsets.SetNumUninitialized(NumLocations + 1);
+    Neighbours.Reset();
+
+    // Grids have at most a few dozen points, so the all-pairs pass is cheap and only runs once per grid
+    for (int32 i = 0; i < NumLocations; ++i)
+    {
+        NeighbourOffsets[i] = Neighbours.Num();
+        for (int32 j = 0; j < NumLocations; ++j)
+        {
+            if (i == j)
+            {
+                continue;
+            }
+
+            const float DistanceInDeg = GetAngularDistanceInDeg(Locations[i], Locations[j]);
+            if (DistanceInDeg <= NeighbourRadiusInDeg)
+            {
+                Neighbours.Add({ j, DistanceInDeg });
+            }
+        }
+
+        // Nearest first, so callers can stop early
+        TArrayView<FLocationNeighbour> Slice(Neighbours.GetData() + NeighbourOffsets[i], Neighbours.Num() - NeighbourOffsets[i]);
+        Slice.Sort([](const FLocationNeighbour& A, const FLocationNeighbour& B) { return A.DistanceInDeg < B.DistanceInDeg; });
+    }
+    NeighbourOffsets[NumLocations] = Neighbours.Num();
+}
+
+// Drops every location
+void FLocationAdjacency::Reset()
+{
+    AngularPositions.Reset();
+    Neighbours.Reset();
+    NeighbourOffsets.Reset();
+    NeighbourOffsets.Add(0);
+}
+
+// Index of the location nearest to an angular position
+int32 FLocationAdjacency::FindNearestLocation(const FVector2D& AngularPositionInDeg) const
+{
+    int32 NearestIndex = INDEX_NONE;
+    float NearestDistanceSquared = MAX_flt;
+    for (int32 i = 0; i < AngularPositions.Num(); ++i)
+    {
+        const float DistanceSquared = FVector2D::DistSquared(AngularPositions[i], AngularPositionInDeg);
+        if (DistanceSquared < NearestDistanceSquared)
+        {
+            NearestDistanceSquared = DistanceSquared;
+            NearestIndex = i;
+        }
+    }
+    return NearestIndex;
+}
+
+// Angular separation between two stimulus locations (in degrees)
+float FLocationAdjacency::GetAngularDistanceInDeg(const FVector& LocationA, const FVector& LocationB)
+{
+    const float CosAngle = FVector::DotProduct(LocationA.GetSafeNormal(), LocationB.GetSafeNormal());
+    return FMath::RadiansToDegrees(FMath::Acos(FMath::Clamp(CosAngle, -1.0f, 1.0f)));
+}
+
+// Angular position of a stimulus location, inverting ATestStimuli::PolarToCartesian
+FVector2D FLocationAdjacency::ToAngularPosition(const FVector& Location)
+{
+    const FVector Direction = Location.GetSafeNormal();
+    const float VerticalAngle = FMath::Asin(FMath::Clamp((float)Direction.Y, -1.0f, 1.0f));
+    const float HorizontalAngle = FMath::Atan2((float)Direction.X, (float)Direction.Z);
+    return FVector2D(FMath::RadiansToDegrees(HorizontalAngle), FMath::RadiansToDegrees(VerticalAngle));
+}
@@ -0,0 +1,159 @@
+// FLocationScheduler.cpp
+
+#include "FLocationScheduler.h"
+
+// Constructor
+FLocationScheduler::FLocationScheduler()
+    : NumActive(0)
+{
+}
+
+// Sizes the scheduler for the given quadrant of each stimulus index; every location starts inactive
+void FLocationScheduler::Initialize(const TArray<int32>& InQuadrants)
+{
+    Reset();
+
+    Quadrants = InQuadrants;
+    Priorities.Init(0.0f, Quadrants.Num());
+    HeapPositions.Init(INDEX_NONE, Quadrants.Num());
+    for (TArray<int32>& Heap : Heaps)
+    {
+        Heap.Reserve(Quadrants.Num());
+    }
+}
+
+// Drops every location
+void FLocationScheduler::Reset()
+{
+    for (TArray<int32>& Heap : Heaps)
+    {
+        Heap.Reset();
+    }
+    Priorities.Reset();
+    HeapPositions.Reset();
+    Quadrants.Reset();
+    NumActive = 0;
+}
+
+// Activates a location or changes its priority
+void FLocationScheduler::Update(int32 LocationIndex, float Priority)
+{
+    check(Quadrants.IsValidIndex(LocationIndex));
+    TArray<int32>& Heap = Heaps[Quadrants[LocationIndex]];
+
+    if (HeapPositions[LocationIndex] == INDEX_NONE)
+    {
+        Priorities[LocationIndex] = Priority;
+        HeapPositions[LocationIndex] = Heap.Add(LocationIndex);
+        NumActive++;
+        SiftUp(Heap, HeapPositions[LocationIndex]);
+        return;
+    }
+
+    const float PreviousPriority = Priorities[LocationIndex];
+    Priorities[LocationIndex] = Priority;
+    if (Priority > PreviousPriority)
+    {
+        SiftUp(Heap, HeapPositions[LocationIndex]);
+    }
+    else
+    {
+        SiftDown(Heap, HeapPositions[LocationIndex]);
+    }
+}
+
+// Deactivates a location; does nothing if it is not active
+void FLocationScheduler::Remove(int32 LocationIndex)
+{
+    if (!IsActive(LocationIndex))
+    {
+        return;
+    }
+
+    TArray<int32>& Heap = Heaps[Quadrants[LocationIndex]];
+    const int32 Position = HeapPositions[LocationIndex];
+    const int32 Last = Heap.Pop(false);
+    HeapPositions[LocationIndex] = INDEX_NONE;
+    NumActive--;
+
+    // Move the last entry into the hole and restore the heap in whichever direction it needs
+    if (Last != LocationIndex)
+    {
+        Heap[Position] = Last;
+        HeapPositions[Last] = Position;
+        SiftUp(Heap, Position);
+        SiftDown(Heap, HeapPositions[Last]);
+    }
+}
+
+// Highest-priority active location outside ExcludedQuadrant; from ExcludedQuadrant only if no other quadrant has one
+int32 FLocationScheduler::GetBest(int32 ExcludedQuadrant) const
+{
+    const int32 Best = GetBestOutside(ExcludedQuadrant);
+    if (Best == INDEX_NONE && ExcludedQuadrant >= 0 && ExcludedQuadrant < NumQuadrants && Heaps[ExcludedQuadrant].Num() > 0)
+    {
+        return Heaps[ExcludedQuadrant][0];
+    }
+    return Best;
+}
+
+// Highest-priority active location outside ExcludedQuadrant, or INDEX_NONE if every active location is in it
+int32 FLocationScheduler::GetBestOutside(int32 ExcludedQuadrant) const
+{
+    int32 Best = INDEX_NONE;
+    for (int32 Quadrant = 0; Quadrant < NumQuadrants; ++Quadrant)
+    {
+        if (Quadrant != ExcludedQuadrant && Heaps[Quadrant].Num() > 0 && (Best == INDEX_NONE || IsHigher(Heaps[Quadrant][0], Best)))
+        {
+            Best = Heaps[Quadrant][0];
+        }
+    }
+    return Best;
+}
+
+// Moves the entry at Position up until its parent is higher
+void FLocationScheduler::SiftUp(TArray<int32>& Heap, int32 Position)
+{
+    const int32 Entry = Heap[Position];
+    while (Position > 0)
+    {
+        const int32 Parent = (Position - 1) / 2;
+        if (!IsHigher(Entry, Heap[Parent]))
+        {
+            break;
+        }
+        Heap[Position] = Heap[Parent];
+        HeapPositions[Heap[Position]] = Position;
+        Position = Parent;
+    }
+    Heap[Position] = Entry;
+    HeapPositions[Entry] = Position;
+}
+
+// Moves the entry at Position down until both children are lower
+void FLocationScheduler::SiftDown(TArray<int32>& Heap, int32 Position)
+{
+    const int32 Entry = Heap[Position];
+    const int32 Count = Heap.Num();
+    for (;;)
+    {
+        int32 Child = 2 * Position + 1;
+        if (Child >= Count)
+        {
+            break;
+        }
+        if (Child + 1 < Count && IsHigher(Heap[Child + 1], Heap[Child]))
+        {
+            Child++;
+        }
+        if (!IsHigher(Heap[Child], Entry))
+        {
+            break;
+        }
+        Heap[Position] = Heap[Child];
+        HeapPositions[Heap[Position]] = Position;
+        Position = Child;
+    }
+    Heap[Position] = Entry;
+    HeapPositions[Entry] = Position;
+}
@@ -0,0 +1,109 @@
+// FPosteriorTrace.cpp
+
+#include "FPosteriorTrace.h"
+#include "Async/Async.h"
+#include "Misc/FileHelper.h"
+
+static_assert(sizeof(FPosteriorTraceRecordHeader) == 24, "Trace record header layout is part of the file format");
+static_assert(sizeof(FPosteriorTraceFileHeader) == 32, "Trace file header layout is part of the file format");
+
+// Constructor
+FPosteriorTrace::FPosteriorTrace()
+    : Capacity(0)
+    , NumLevels(0)
+    , RecordSize(0)
+    , MinThresholdInDb(0.0f)
+    , ThresholdStepSizeInDb(0.0f)
+    , TotalRecorded(0)
+{
+}
+
+// Preallocates room for InCapacity records; drops recorded data only if the layout changes
+void FPosteriorTrace::Initialize(int32 InCapacity, int32 InNumLevels, float InMinThresholdInDb, float InThresholdStepSizeInDb)
+{
+    check(InCapacity > 0 && InNumLevels > 0);
+
+    if (Capacity == InCapacity && NumLevels == InNumLevels && MinThresholdInDb == InMinThresholdInDb && ThresholdStepSizeInDb == InThresholdStepSizeInDb)
+    {
+        return;
+    }
+
+    Capacity = InCapacity;
+    NumLevels = InNumLevels;
+    MinThresholdInDb = InMinThresholdInDb;
+    ThresholdStepSizeInDb = InThresholdStepSizeInDb;
+    RecordSize = sizeof(FPosteriorTraceRecordHeader) + NumLevels * sizeof(float);
+
+    Buffer.SetNumUninitialized(Capacity * RecordSize);
+    Reset();
+}
+
+// Drops every record while keeping the allocation
+void FPosteriorTrace::Reset()
+{
+    TotalRecorded = 0;
+}
+
+// Appends a record, overwriting the oldest one once the buffer is full
+void FPosteriorTrace::Record(int32 LocationIndex, int32 TrialNumber, float StimulusIntensityInDb, bool bSeen, bool bLeftEye, float LevelOriginInDb, float LevelStepInDb, const float* LogPosterior)
+{
+    if (Capacity == 0)
+    {
+        return;
+    }
+
+    uint8* Slot = Buffer.GetData() + (TotalRecorded % Capacity) * RecordSize;
+
+    FPosteriorTraceRecordHeader Header;
+    Header.LocationIndex = LocationIndex;
+    Header.TrialNumber = TrialNumber;
+    Header.StimulusIntensityInDb = StimulusIntensityInDb;
+    Header.bSeen = bSeen ? 1 : 0;
+    Header.bLeftEye = bLeftEye ? 1 : 0;
+    Header.Padding[0] = Header.Padding[1] = 0;
+    Header.LevelOriginInDb = LevelOriginInDb;
+    Header.LevelStepInDb = LevelStepInDb;
+
+    FMemory::Memcpy(Slot, &Header, sizeof(Header));
+    FMemory::Memcpy(Slot + sizeof(Header), LogPosterior, NumLevels * sizeof(float));
+    TotalRecorded++;
+}
+
+// Snapshots the buffered records, oldest first, and writes them to FilePath on a background thread
+bool FPosteriorTrace::DumpAsync(const FString& FilePath) const
+{
+    const int32 NumRecords = GetNumRecords();
+    if (NumRecords == 0)
+    {
+        return false;
+    }
+
+    FPosteriorTraceFileHeader FileHeader;
+    FileHeader.Magic = FileMagic;
+    FileHeader.Version = FileVersion;
+    FileHeader.NumLevels = NumLevels;
+    FileHeader.NumRecords = NumRecords;
+    FileHeader.MinThresholdInDb = MinThresholdInDb;
+    FileHeader.ThresholdStepSizeInDb = ThresholdStepSizeInDb;
+    FileHeader.NumDropped = GetNumDropped();
+
+    // The snapshot is two memcpys at most: from the oldest slot to the end, then from the start
+    TArray<uint8> Data;
+    Data.SetNumUninitialized(sizeof(FileHeader) + NumRecords * RecordSize);
+    FMemory::Memcpy(Data.GetData(), &FileHeader, sizeof(FileHeader));
+
+    const int32 OldestSlot = TotalRecorded > Capacity ? (int32)(TotalRecorded % Capacity) : 0;
+    const int32 TailRecords = NumRecords - OldestSlot;
+    uint8* Destination = Data.GetData() + sizeof(FileHeader);
+    FMemory::Memcpy(Destination, Buffer.GetData() + OldestSlot * RecordSize, TailRecords * RecordSize);
+    FMemory::Memcpy(Destination + TailRecords * RecordSize, Buffer.GetData(), OldestSlot * RecordSize);
+
+    Async(EAsyncExecution::ThreadPool, [Data = MoveTemp(Data), FilePath]()
+    {
+        if (!FFileHelper::SaveArrayToFile(Data, *FilePath))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Failed to write posterior trace to %s"), *FilePath);
+        }
+    });
+    return true;
+}
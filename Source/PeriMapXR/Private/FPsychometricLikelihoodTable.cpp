@@ -0,0 +1,103 @@
+// FPsychometricLikelihoodTable.cpp
+
+#include "FPsychometricLikelihoodTable.h"
+#include "Math/UnrealMathUtility.h"
+#include <cmath>
+
+// Constructor
+FPsychometricLikelihoodTable::FPsychometricLikelihoodTable()
+    : MinThresholdInDb(0.0f)
+    , ThresholdStepSizeInDb(0.0f)
+    , IntensityBinSizeInDb(0.0f)
+    , NumLevels(0)
+    , Stride(0)
+    , NumBins(0)
+    , bIsBuilt(false)
+{
+}
+
+// Psychometric function (cumulative Gaussian); intensities are attenuations, so a stimulus below the threshold is seen
+float FPsychometricLikelihoodTable::Evaluate(const FPsychometricParameters& InParams, float StimulusIntensity, float ThresholdLevel)
+{
+    return InParams.GuessRate + (1.0f - InParams.GuessRate - InParams.LapseRate) * 0.5f * (1.0f + std::erf((ThresholdLevel - StimulusIntensity) / (InParams.Slope * FMath::Sqrt(2.0f))));
+}
+
+// Rebuilds the table if the parameters or threshold grid differ from the ones it was built for
+bool FPsychometricLikelihoodTable::EnsureBuilt(const FPsychometricParameters& InParams, float InMinThresholdInDb, float InThresholdStepSizeInDb, int32 InNumLevels, int32 InStride, float InIntensityBinSizeInDb)
+{
+    if (bIsBuilt
+        && Params == InParams
+        && MinThresholdInDb == InMinThresholdInDb
+        && ThresholdStepSizeInDb == InThresholdStepSizeInDb
+        && NumLevels == InNumLevels
+        && Stride == InStride
+        && IntensityBinSizeInDb == InIntensityBinSizeInDb)
+    {
+        return false;
+    }
+
+    check(InNumLevels > 0 && InStride >= InNumLevels && InIntensityBinSizeInDb > 0.0f);
+
+    Params = InParams;
+    MinThresholdInDb = InMinThresholdInDb;
+    ThresholdStepSizeInDb = InThresholdStepSizeInDb;
+    NumLevels = InNumLevels;
+    Stride = InStride;
+    IntensityBinSizeInDb = InIntensityBinSizeInDb;
+
+    Build();
+    return true;
+}
+
+// Index of the intensity bin nearest to a presented intensity, clamped to the table range
+int32 FPsychometricLikelihoodTable::GetIntensityBin(float StimulusIntensityInDb) const
+{
+    const int32 Bin = FMath::RoundToInt((StimulusIntensityInDb - MinThresholdInDb) / IntensityBinSizeInDb);
+    return FMath::Clamp(Bin, 0, NumBins - 1);
+}
+
+// Fills every table for the current parameters and grid
+void FPsychometricLikelihoodTable::Build()
+{
+    // Presented intensities span the same range as the threshold grid
+    const float RangeInDb = (NumLevels - 1) * ThresholdStepSizeInDb;
+    NumBins = FMath::FloorToInt(RangeInDb / IntensityBinSizeInDb + KINDA_SMALL_NUMBER) + 1;
+
+    SeenLikelihoods.SetNumUninitialized(NumBins * Stride);
+    NotSeenLikelihoods.SetNumUninitialized(NumBins * Stride);
+    SeenLogLikelihoods.SetNumUninitialized(NumBins * Stride);
+    NotSeenLogLikelihoods.SetNumUninitialized(NumBins * Stride);
+    ResponseEntropies.SetNumUninitialized(NumBins * Stride);
+
+    for (int32 Bin = 0; Bin < NumBins; ++Bin)
+    {
+        const float StimulusIntensity = GetBinIntensityInDb(Bin);
+        float* SeenRow = SeenLikelihoods.GetData() + Bin * Stride;
+        float* NotSeenRow = NotSeenLikelihoods.GetData() + Bin * Stride;
+        float* SeenLogRow = SeenLogLikelihoods.GetData() + Bin * Stride;
+        float* NotSeenLogRow = NotSeenLogLikelihoods.GetData() + Bin * Stride;
+        float* EntropyRow = ResponseEntropies.GetData() + Bin * Stride;
+
+        for (int32 i = 0; i < NumLevels; ++i)
+        {
+            const float ProbabilityOfSeeing = Evaluate(Params, StimulusIntensity, MinThresholdInDb + i * ThresholdStepSizeInDb);
+            SeenRow[i] = ProbabilityOfSeeing;
+            NotSeenRow[i] = 1.0f - ProbabilityOfSeeing;
+
+            // Guess and lapse rates keep both probabilities away from zero, so the logs stay finite
+            SeenLogRow[i] = FMath::Loge(SeenRow[i]);
+            NotSeenLogRow[i] = FMath::Loge(NotSeenRow[i]);
+            EntropyRow[i] = -(SeenRow[i] * SeenLogRow[i] + NotSeenRow[i] * NotSeenLogRow[i]);
+        }
+        for (int32 i = NumLevels; i < Stride; ++i)
+        {
+            SeenRow[i] = 1.0f;
+            NotSeenRow[i] = 1.0f;
+            SeenLogRow[i] = 0.0f;
+            NotSeenLogRow[i] = 0.0f;
+            EntropyRow[i] = 0.0f;
+        }
+    }
+
+    bIsBuilt = true;
+}
@@ -0,0 +1,48 @@
+// FReactionTimeDistribution.cpp
+
+#include "FReactionTimeDistribution.h"
+
+// Constructor
+FReactionTimeDistribution::FReactionTimeDistribution()
+    : NumReactionTimes(0), SumSeconds(0.0)
+{
+    BinCounts.Init(0, NumBins);
+}
+
+// Drops every reaction time
+void FReactionTimeDistribution::Reset()
+{
+    BinCounts.Init(0, NumBins);
+    NumReactionTimes = 0;
+    SumSeconds = 0.0;
+}
+
+// Adds a reaction time to its bin
+void FReactionTimeDistribution::Add(float ReactionTimeSeconds)
+{
+    const int32 Bin = FMath::Clamp(FMath::FloorToInt(ReactionTimeSeconds / BinSeconds), 0, NumBins - 1);
+    BinCounts[Bin]++;
+    NumReactionTimes++;
+    SumSeconds += ReactionTimeSeconds;
+}
+
+// Walks the bins until the requested share of reaction times is covered
+float FReactionTimeDistribution::GetPercentile(float Fraction) const
+{
+    if (NumReactionTimes == 0)
+    {
+        return 0.0f;
+    }
+
+    const int32 Rank = FMath::Clamp(FMath::CeilToInt(FMath::Clamp(Fraction, 0.0f, 1.0f) * NumReactionTimes), 1, NumReactionTimes);
+    int32 Covered = 0;
+    for (int32 Bin = 0; Bin < NumBins; ++Bin)
+    {
+        Covered += BinCounts[Bin];
+        if (Covered >= Rank)
+        {
+            return (Bin + 1) * BinSeconds;
+        }
+    }
+    return NumBins * BinSeconds;
+}
@@ -0,0 +1,48 @@
+// FScriptedResponder.cpp
+
+#include "FScriptedResponder.h"
+#include "FLocationAdjacency.h"
+
+// Constructor: a reliable participant with typical reaction times who rarely looks away
+FScriptedResponder::FScriptedResponder()
+    : Params(3.0f, 0.03f, 0.03f), MeanReactionTimeSeconds(0.45f), ReactionTimeDeviationSeconds(0.08f), MinReactionTimeSeconds(0.18f), FixationLossesPerSecond(0.05f), FixationJitterInDeg(1.0f), FixationLossErrorInDeg(15.0f)
+{
+}
+
+// Normal field thresholds, the same as the simulation commandlet draws for an eye without a defect
+void FScriptedResponder::Initialize(const TArray<FVector>& Locations, int32 Seed)
+{
+    Stream.Initialize(Seed);
+    TrueThresholdsInDb.SetNumUninitialized(Locations.Num());
+    for (int32 LocationIndex = 0; LocationIndex < Locations.Num(); ++LocationIndex)
+    {
+        const float Eccentricity = FLocationAdjacency::ToAngularPosition(Locations[LocationIndex]).Size();
+        TrueThresholdsInDb[LocationIndex] = 31.0f - 0.12f * Eccentricity + Stream.FRandRange(-1.5f, 1.5f);
+    }
+}
+
+// Seen with the psychometric probability at the location's true threshold; a press in an empty gap is a guess
+bool FScriptedResponder::DrawSeen(int32 LocationIndex, float StimulusIntensityInDb)
+{
+    if (!TrueThresholdsInDb.IsValidIndex(LocationIndex))
+    {
+        return Stream.FRand() < Params.GuessRate;
+    }
+    return Stream.FRand() < FPsychometricLikelihoodTable::Evaluate(Params, StimulusIntensityInDb, TrueThresholdsInDb[LocationIndex]);
+}
+
+// Gaussian reaction time from two uniform draws (Box-Muller)
+float FScriptedResponder::DrawReactionTimeSeconds()
+{
+    const float Radius = FMath::Sqrt(-2.0f * FMath::Loge(FMath::Max(Stream.FRand(), KINDA_SMALL_NUMBER)));
+    const float Normal = Radius * FMath::Cos(2.0f * PI * Stream.FRand());
+    return FMath::Max(MeanReactionTimeSeconds + ReactionTimeDeviationSeconds * Normal, MinReactionTimeSeconds);
+}
+
+// Losses of fixation arrive as a Poisson process, so the chance per sample follows the time since the last one;
+// otherwise the gaze sits within FixationJitterInDeg of the fixation point
+float FScriptedResponder::DrawGazeErrorInDeg(float DeltaSeconds)
+{
+    const bool bLost = Stream.FRand() < 1.0f - FMath::Exp(-FixationLossesPerSecond * FMath::Max(DeltaSeconds, 0.0f));
+    return bLost ? FixationLossErrorInDeg : Stream.FRand() * FixationJitterInDeg;
+}
@@ -0,0 +1,208 @@
+// FStimulusGridLibrary.cpp
+
+#include "FStimulusGridLibrary.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+// 10-2: 68 points on a 2 degree lattice offset 1 degree from both meridians, within the central 10 degrees
+static const FStimulusGridPoint Grid10_2[] =
+{
+    {-1, 9}, {1, 9},
+    {-5, 7}, {-3, 7}, {-1, 7}, {1, 7}, {3, 7}, {5, 7},
+    {-7, 5}, {-5, 5}, {-3, 5}, {-1, 5}, {1, 5}, {3, 5}, {5, 5}, {7, 5},
+    {-7, 3}, {-5, 3}, {-3, 3}, {-1, 3}, {1, 3}, {3, 3}, {5, 3}, {7, 3},
+    {-9, 1}, {-7, 1}, {-5, 1}, {-3, 1}, {-1, 1}, {1, 1}, {3, 1}, {5, 1}, {7, 1}, {9, 1},
+    {-9, -1}, {-7, -1}, {-5, -1}, {-3, -1}, {-1, -1}, {1, -1}, {3, -1}, {5, -1}, {7, -1}, {9, -1},
+    {-7, -3}, {-5, -3}, {-3, -3}, {-1, -3}, {1, -3}, {3, -3}, {5, -3}, {7, -3},
+    {-7, -5}, {-5, -5}, {-3, -5}, {-1, -5}, {1, -5}, {3, -5}, {5, -5}, {7, -5},
+    {-5, -7}, {-3, -7}, {-1, -7}, {1, -7}, {3, -7}, {5, -7},
+    {-1, -9}, {1, -9},
+};
+
+// 24-2: 54 points on a 6 degree lattice offset 3 degrees from both meridians, with the two nasal-step points at 27 degrees
+static const FStimulusGridPoint Grid24_2[] =
+{
+    {-9, 21}, {-3, 21}, {3, 21}, {9, 21},
+    {-15, 15}, {-9, 15}, {-3, 15}, {3, 15}, {9, 15}, {15, 15},
+    {-21, 9}, {-15, 9}, {-9, 9}, {-3, 9}, {3, 9}, {9, 9}, {15, 9}, {21, 9},
+    {-27, 3}, {-21, 3}, {-15, 3}, {-9, 3}, {-3, 3}, {3, 3}, {9, 3}, {15, 3}, {21, 3},
+    {-27, -3}, {-21, -3}, {-15, -3}, {-9, -3}, {-3, -3}, {3, -3}, {9, -3}, {15, -3}, {21, -3},
+    {-21, -9}, {-15, -9}, {-9, -9}, {-3, -9}, {3, -9}, {9, -9}, {15, -9}, {21, -9},
+    {-15, -15}, {-9, -15}, {-3, -15}, {3, -15}, {9, -15}, {15, -15},
+    {-9, -21}, {-3, -21}, {3, -21}, {9, -21},
+};
+
+// 24-2C: the 24-2 followed by ten 10-2 points around the macula, four superior and six inferior,
+// where early glaucomatous macular damage concentrates. The 24-2 points keep their indices
+static const FStimulusGridPoint Grid24_2C[] =
+{
+    {-9, 21}, {-3, 21}, {3, 21}, {9, 21},
+    {-15, 15}, {-9, 15}, {-3, 15}, {3, 15}, {9, 15}, {15, 15},
+    {-21, 9}, {-15, 9}, {-9, 9}, {-3, 9}, {3, 9}, {9, 9}, {15, 9}, {21, 9},
+    {-27, 3}, {-21, 3}, {-15, 3}, {-9, 3}, {-3, 3}, {3, 3}, {9, 3}, {15, 3}, {21, 3},
+    {-27, -3}, {-21, -3}, {-15, -3}, {-9, -3}, {-3, -3}, {3, -3}, {9, -3}, {15, -3}, {21, -3},
+    {-21, -9}, {-15, -9}, {-9, -9}, {-3, -9}, {3, -9}, {9, -9}, {15, -9}, {21, -9},
+    {-15, -15}, {-9, -15}, {-3, -15}, {3, -15}, {9, -15}, {15, -15},
+    {-9, -21}, {-3, -21}, {3, -21}, {9, -21},
+    {-5, 5}, {-1, 5}, {1, 5}, {5, 5},
+    {-5, -5}, {-1, -5}, {1, -5}, {5, -5}, {-3, -7}, {3, -7},
+};
+
+// 30-2: 76 points on the 24-2 lattice out to 27 degrees
+static const FStimulusGridPoint Grid30_2[] =
+{
+    {-9, 27}, {-3, 27}, {3, 27}, {9, 27},
+    {-15, 21}, {-9, 21}, {-3, 21}, {3, 21}, {9, 21}, {15, 21},
+    {-21, 15}, {-15, 15}, {-9, 15}, {-3, 15}, {3, 15}, {9, 15}, {15, 15}, {21, 15},
+    {-27, 9}, {-21, 9}, {-15, 9}, {-9, 9}, {-3, 9}, {3, 9}, {9, 9}, {15, 9}, {21, 9}, {27, 9},
+    {-27, 3}, {-21, 3}, {-15, 3}, {-9, 3}, {-3, 3}, {3, 3}, {9, 3}, {15, 3}, {21, 3}, {27, 3},
+    {-27, -3}, {-21, -3}, {-15, -3}, {-9, -3}, {-3, -3}, {3, -3}, {9, -3}, {15, -3}, {21, -3}, {27, -3},
+    {-27, -9}, {-21, -9}, {-15, -9}, {-9, -9}, {-3, -9}, {3, -9}, {9, -9}, {15, -9}, {21, -9}, {27, -9},
+    {-21, -15}, {-15, -15}, {-9, -15}, {-3, -15}, {3, -15}, {9, -15}, {15, -15}, {21, -15},
+    {-15, -21}, {-9, -21}, {-3, -21}, {3, -21}, {9, -21}, {15, -21},
+    {-9, -27}, {-3, -27}, {3, -27}, {9, -27},
+};
+
+static_assert(UE_ARRAY_COUNT(Grid10_2) == 68, "10-2 has 68 points");
+static_assert(UE_ARRAY_COUNT(Grid24_2) == 54, "24-2 has 54 points");
+static_assert(UE_ARRAY_COUNT(Grid24_2C) == 64, "24-2C has 64 points");
+static_assert(UE_ARRAY_COUNT(Grid30_2) == 76, "30-2 has 76 points");
+
+// Laid-out grids by test type, eye, viewing distance, blind-spot handling and custom file. Held by pointer so
+// references handed out stay valid as the map grows
+static TMap<FString, TUniquePtr<FStimulusGridLayout>> CachedLayouts;
+
+// Points of a standard pattern in right-eye orientation
+TArrayView<const FStimulusGridPoint> FStimulusGridLibrary::GetStandardPattern(ETestType TestType)
+{
+    switch (TestType)
+    {
+    case ETestType::TEST_10_2:
+        return TArrayView<const FStimulusGridPoint>(Grid10_2, UE_ARRAY_COUNT(Grid10_2));
+    case ETestType::TEST_24_2:
+        return TArrayView<const FStimulusGridPoint>(Grid24_2, UE_ARRAY_COUNT(Grid24_2));
+    case ETestType::TEST_24_2C:
+        return TArrayView<const FStimulusGridPoint>(Grid24_2C, UE_ARRAY_COUNT(Grid24_2C));
+    case ETestType::TEST_30_2:
+        return TArrayView<const FStimulusGridPoint>(Grid30_2, UE_ARRAY_COUNT(Grid30_2));
+    default:
+        return TArrayView<const FStimulusGridPoint>();
+    }
+}
+
+// Lays out a grid for an eye at a viewing distance the first time it is asked for, then returns the cached layout
+const FStimulusGridLayout& FStimulusGridLibrary::GetLayout(ETestType TestType, bool bLeftEye, float ViewingDistance, bool bSkipBlindSpotPoints, const FString& CustomGridPath)
+{
+    check(IsInGameThread());
+
+    const bool bCustom = TestType == ETestType::TEST_CUSTOM;
+    const FString Key = FString::Printf(TEXT("%d|%d|%.3f|%d|%s"), (int32)TestType, bLeftEye ? 1 : 0, ViewingDistance, bSkipBlindSpotPoints ? 1 : 0, bCustom ? *CustomGridPath : TEXT(""));
+    if (const TUniquePtr<FStimulusGridLayout>* CachedLayout = CachedLayouts.Find(Key))
+    {
+        return **CachedLayout;
+    }
+
+    // Right-eye points of the pattern
+    TArray<FVector2D> RightEyePoints;
+    if (bCustom)
+    {
+        FString Error;
+        if (!LoadCustomPattern(CustomGridPath, RightEyePoints, Error))
+        {
+            // Not cached, so a corrected file is picked up on the next attempt
+            UE_LOG(LogTemp, Error, TEXT("FStimulusGridLibrary: %s"), *Error);
+            static const FStimulusGridLayout EmptyLayout;
+            return EmptyLayout;
+        }
+    }
+    else
+    {
+        for (const FStimulusGridPoint& Point : GetStandardPattern(TestType))
+        {
+            RightEyePoints.Add(FVector2D(Point.HorizontalInDeg, Point.VerticalInDeg));
+        }
+    }
+
+    TUniquePtr<FStimulusGridLayout> Layout = MakeUnique<FStimulusGridLayout>();
+    Layout->AngularPositions.Reserve(RightEyePoints.Num());
+    Layout->Locations.Reserve(RightEyePoints.Num());
+    for (const FVector2D& RightEyePoint : RightEyePoints)
+    {
+        const FVector2D AngularPosition = MirrorForEye(RightEyePoint, bLeftEye);
+        const bool bInBlindSpot = IsInBlindSpot(AngularPosition, bLeftEye);
+        if (bInBlindSpot && bSkipBlindSpotPoints)
+        {
+            continue;
+        }
+        Layout->AngularPositions.Add(AngularPosition);
+        Layout->Locations.Add(ToCartesian(AngularPosition, ViewingDistance));
+        Layout->BlindSpotPoints.Add(bInBlindSpot);
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("FStimulusGridLibrary: laid out %d points for the %s eye at %.1f."), Layout->Num(), bLeftEye ? TEXT("left") : TEXT("right"), ViewingDistance);
+    return *CachedLayouts.Add(Key, MoveTemp(Layout));
+}
+
+// Reads "Horizontal,Vertical" points in degrees, one per line
+bool FStimulusGridLibrary::LoadCustomPattern(const FString& Path, TArray<FVector2D>& OutPoints, FString& OutError)
+{
+    OutPoints.Reset();
+
+    TArray<FString> Lines;
+    if (Path.IsEmpty() || !FFileHelper::LoadFileToStringArray(Lines, *Path))
+    {
+        OutError = FString::Printf(TEXT("could not read custom grid file '%s'."), *Path);
+        return false;
+    }
+
+    for (int32 LineIndex = 0; LineIndex < Lines.Num(); ++LineIndex)
+    {
+        const FString Line = Lines[LineIndex].TrimStartAndEnd();
+        if (Line.IsEmpty() || Line.StartsWith(TEXT("#")))
+        {
+            continue;
+        }
+
+        TArray<FString> Fields;
+        Line.ParseIntoArray(Fields, TEXT(","));
+        if (Fields.Num() != 2 || !Fields[0].TrimStartAndEnd().IsNumeric() || !Fields[1].TrimStartAndEnd().IsNumeric())
+        {
+            OutError = FString::Printf(TEXT("line %d of '%s' is not \"Horizontal,Vertical\": %s"), LineIndex + 1, *Path, *Line);
+            return false;
+        }
+        OutPoints.Add(FVector2D(FCString::Atof(*Fields[0].TrimStartAndEnd()), FCString::Atof(*Fields[1].TrimStartAndEnd())));
+    }
+
+    if (OutPoints.Num() == 0)
+    {
+        OutError = FString::Printf(TEXT("custom grid file '%s' holds no points."), *Path);
+        return false;
+    }
+    return true;
+}
+
+// Whether an angular position of the tested eye falls inside the blind spot ellipse
+bool FStimulusGridLibrary::IsInBlindSpot(const FVector2D& AngularPositionInDeg, bool bLeftEye)
+{
+    const FVector2D Centre = MirrorForEye(FVector2D(BlindSpotHorizontalInDeg, BlindSpotVerticalInDeg), bLeftEye);
+    return FMath::Square((AngularPositionInDeg.X - Centre.X) / BlindSpotHalfWidthInDeg) + FMath::Square((AngularPositionInDeg.Y - Centre.Y) / BlindSpotHalfHeightInDeg) <= 1.0f;
+}
+
+// Position of an angular position at a viewing distance, with the axes of ATestStimuli::PolarToCartesian
+FVector FStimulusGridLibrary::ToCartesian(const FVector2D& AngularPositionInDeg, float ViewingDistance)
+{
+    const float HorizontalAngle = FMath::DegreesToRadians((float)AngularPositionInDeg.X);
+    const float VerticalAngle = FMath::DegreesToRadians((float)AngularPositionInDeg.Y);
+    FVector Cartesian;
+    Cartesian.X = ViewingDistance * FMath::Cos(VerticalAngle) * FMath::Sin(HorizontalAngle);
+    Cartesian.Y = ViewingDistance * FMath::Sin(VerticalAngle);
+    Cartesian.Z = ViewingDistance * FMath::Cos(VerticalAngle) * FMath::Cos(HorizontalAngle);
+    return Cartesian;
+}
+
+// Drops every cached layout
+void FStimulusGridLibrary::ClearCache()
+{
+    check(IsInGameThread());
+    CachedLayouts.Empty();
+}
@@ -0,0 +1,276 @@
+// FThresholdPosteriorStore.cpp
+
+#include "FThresholdPosteriorStore.h"
+#include "Math/UnrealMathUtility.h"
+#include "Math/VectorRegister.h"
+
+// Log value held in the padding lanes so they never win the running max or add probability mass
+static const float PaddingLogValue = -MAX_flt;
+
+// Constructor
+FThresholdPosteriorStore::FThresholdPosteriorStore()
+    : NumLocations(0)
+    , NumLevels(0)
+    , Stride(0)
+    , MinThresholdInDb(0.0f)
+    , ThresholdStepSizeInDb(0.0f)
+{
+}
+
+// Lays out the threshold grid and allocates a uniform prior for each location
+void FThresholdPosteriorStore::Initialize(int32 InNumLocations, float InMinThresholdInDb, float InMaxThresholdInDb, float InThresholdStepSizeInDb)
+{
+    check(InThresholdStepSizeInDb > 0.0f && InMaxThresholdInDb >= InMinThresholdInDb);
+
+    MinThresholdInDb = InMinThresholdInDb;
+    ThresholdStepSizeInDb = InThresholdStepSizeInDb;
+    NumLevels = FMath::FloorToInt((InMaxThresholdInDb - InMinThresholdInDb) / InThresholdStepSizeInDb + KINDA_SMALL_NUMBER) + 1;
+    Stride = Align(NumLevels, RowAlignment);
+
+    // Padding levels stay at zero so they never contribute to a moment
+    ThresholdLevelsInDb.SetNumZeroed(Stride);
+    for (int32 i = 0; i < NumLevels; ++i)
+    {
+        ThresholdLevelsInDb[i] = InMinThresholdInDb + i * InThresholdStepSizeInDb;
+    }
+
+    Reset();
+
+    LogPosteriors.Reserve(InNumLocations * Stride);
+    for (int32 i = 0; i < InNumLocations; ++i)
+    {
+        AddLocation();
+    }
+}
+
+// Releases every location while keeping the threshold grid
+void FThresholdPosteriorStore::Reset()
+{
+    NumLocations = 0;
+    LogPosteriors.Reset();
+    RunningMax.Reset();
+    LevelOrigins.Reset();
+    LevelSteps.Reset();
+    Moments.Reset();
+    LogNormalizers.Reset();
+    ConsistentResponsesCount.Reset();
+    TrialCounts.Reset();
+    bEstimationComplete.Reset();
+}
+
+// Appends a new location with a uniform prior and returns its index
+int32 FThresholdPosteriorStore::AddLocation()
+{
+    const int32 LocationIndex = NumLocations++;
+
+    LogPosteriors.AddUninitialized(Stride);
+    RunningMax.Add(0.0f);
+    LevelOrigins.Add(MinThresholdInDb);
+    LevelSteps.Add(ThresholdStepSizeInDb);
+    Moments.AddDefaulted();
+    LogNormalizers.Add(0.0f);
+    ConsistentResponsesCount.Add(0);
+    TrialCounts.Add(0);
+    bEstimationComplete.Add(false);
+
+    SetUniformPrior(LocationIndex);
+    return LocationIndex;
+}
+
+// Resets a single location to the uniform prior on the initial grid and clears its bookkeeping
+void FThresholdPosteriorStore::ResetLocation(int32 LocationIndex)
+{
+    check(IsValidIndex(LocationIndex));
+
+    LevelOrigins[LocationIndex] = MinThresholdInDb;
+    LevelSteps[LocationIndex] = ThresholdStepSizeInDb;
+
+    ConsistentResponsesCount[LocationIndex] = 0;
+    TrialCounts[LocationIndex] = 0;
+    bEstimationComplete[LocationIndex] = false;
+
+    SetUniformPrior(LocationIndex);
+}
+
+// Replaces a location's posterior with the given prior
+void FThresholdPosteriorStore::SetPrior(int32 LocationIndex, const float* Probabilities)
+{
+    check(IsValidIndex(LocationIndex));
+
+    float* LogPosterior = GetLogPosterior(LocationIndex);
+    float Max = PaddingLogValue;
+    for (int32 i = 0; i < NumLevels; ++i)
+    {
+        LogPosterior[i] = Probabilities[i] > 0.0f ? FMath::Loge(Probabilities[i]) : PaddingLogValue;
+        Max = FMath::Max(Max, LogPosterior[i]);
+    }
+    for (int32 i = NumLevels; i < Stride; ++i)
+    {
+        LogPosterior[i] = PaddingLogValue;
+    }
+    RunningMax[LocationIndex] = Max;
+
+    UpdateMoments(LocationIndex);
+}
+
+// Resamples a location's posterior onto a new grid of NumLevels levels
+void FThresholdPosteriorStore::Rebin(int32 LocationIndex, float NewOriginInDb, float NewStepInDb)
+{
+    check(IsValidIndex(LocationIndex) && NewStepInDb > 0.0f && NumLevels >= 3);
+
+    float* LogPosterior = GetLogPosterior(LocationIndex);
+    const float OldOrigin = LevelOrigins[LocationIndex];
+    const float OldStep = LevelSteps[LocationIndex];
+
+    // Values this far below the peak are zero in float anyway; the floor keeps zero-prior levels out of the arithmetic
+    const float LogFloor = RunningMax[LocationIndex] - 100.0f;
+    TArray<float, TInlineAllocator<128>> OldRow;
+    OldRow.SetNumUninitialized(NumLevels);
+    for (int32 i = 0; i < NumLevels; ++i)
+    {
+        OldRow[i] = FMath::Max(LogPosterior[i], LogFloor);
+    }
+
+    // Outside the old grid the tails continue with the edge slope, but are never allowed to rise
+    const float LeftSlope = FMath::Max(OldRow[1] - OldRow[0], 0.0f);
+    const float RightSlope = FMath::Min(OldRow[NumLevels - 1] - OldRow[NumLevels - 2], 0.0f);
+
+    float Max = PaddingLogValue;
+    for (int32 i = 0; i < NumLevels; ++i)
+    {
+        const float Position = (NewOriginInDb + i * NewStepInDb - OldOrigin) / OldStep;
+        float Value;
+        if (Position <= 0.0f)
+        {
+            Value = OldRow[0] + Position * LeftSlope;
+        }
+        else if (Position >= NumLevels - 1)
+        {
+            Value = OldRow[NumLevels - 1] + (Position - (NumLevels - 1)) * RightSlope;
+        }
+        else
+        {
+            // Quadratic through the three nearest levels; exact wherever the log posterior is locally Gaussian
+            const int32 Center = FMath::Clamp(FMath::RoundToInt(Position), 1, NumLevels - 2);
+            const float T = Position - Center;
+            const float Below = OldRow[Center - 1];
+            const float At = OldRow[Center];
+            const float Above = OldRow[Center + 1];
+            Value = At + 0.5f * T * (Above - Below) + 0.5f * T * T * (Above - 2.0f * At + Below);
+        }
+        LogPosterior[i] = Value;
+        Max = FMath::Max(Max, Value);
+    }
+
+    LevelOrigins[LocationIndex] = NewOriginInDb;
+    LevelSteps[LocationIndex] = NewStepInDb;
+    RunningMax[LocationIndex] = Max;
+
+    UpdateMoments(LocationIndex);
+}
+
+// Adds a log-likelihood row to a location's log posterior in one SIMD pass
+void FThresholdPosteriorStore::ApplyLogLikelihood(int32 LocationIndex, const float* LogLikelihood)
+{
+    check(IsValidIndex(LocationIndex));
+    checkSlow(IsAligned(LogLikelihood, 16));
+
+    float* LogPosterior = GetLogPosterior(LocationIndex);
+
+    // Subtracting the previous max keeps the row's peak near zero, so no separate renormalization pass is needed
+    const VectorRegister4Float Rebase = VectorSetFloat1(RunningMax[LocationIndex]);
+    VectorRegister4Float Max = VectorSetFloat1(PaddingLogValue);
+
+    for (int32 i = 0; i < Stride; i += RowAlignment)
+    {
+        const VectorRegister4Float Row = VectorAdd(VectorLoadAligned(LogPosterior + i), VectorSubtract(VectorLoadAligned(LogLikelihood + i), Rebase));
+        VectorStoreAligned(Row, LogPosterior + i);
+        Max = VectorMax(Max, Row);
+    }
+
+    alignas(16) float Lanes[4];
+    VectorStoreAligned(Max, Lanes);
+    RunningMax[LocationIndex] = FMath::Max(FMath::Max(Lanes[0], Lanes[1]), FMath::Max(Lanes[2], Lanes[3]));
+
+    TrialCounts[LocationIndex]++;
+
+    UpdateMoments(LocationIndex);
+}
+
+// Writes a location's normalized posterior probabilities into OutProbabilities
+void FThresholdPosteriorStore::GetPosterior(int32 LocationIndex, float* OutProbabilities) const
+{
+    const float* LogPosterior = GetLogPosterior(LocationIndex);
+    const float LogNormalizer = LogNormalizers[LocationIndex];
+
+    for (int32 i = 0; i < NumLevels; ++i)
+    {
+        OutProbabilities[i] = FMath::Exp(LogPosterior[i] - LogNormalizer);
+    }
+}
+
+// Writes the uniform prior into a location's row
+void FThresholdPosteriorStore::SetUniformPrior(int32 LocationIndex)
+{
+    float* LogPosterior = GetLogPosterior(LocationIndex);
+    for (int32 i = 0; i < NumLevels; ++i)
+    {
+        LogPosterior[i] = 0.0f;
+    }
+    for (int32 i = NumLevels; i < Stride; ++i)
+    {
+        LogPosterior[i] = PaddingLogValue;
+    }
+    RunningMax[LocationIndex] = 0.0f;
+
+    UpdateMoments(LocationIndex);
+}
+
+// Recomputes a location's cached moments and log normalizer in one pass over its row
+void FThresholdPosteriorStore::UpdateMoments(int32 LocationIndex)
+{
+    const float* LogPosterior = GetLogPosterior(LocationIndex);
+    const float Origin = LevelOrigins[LocationIndex];
+    const float Step = LevelSteps[LocationIndex];
+    const float Max = RunningMax[LocationIndex];
+
+    // Moments are taken over level indices and scaled to decibels afterwards
+    // The peak contributes exp(0) = 1, so the sum can never collapse to zero
+    float Sum = 0.0f;
+    float WeightedSum = 0.0f;
+    float WeightedSquareSum = 0.0f;
+    float WeightedLogSum = 0.0f;
+    int32 ModeLevel = 0;
+    for (int32 i = 0; i < NumLevels; ++i)
+    {
+        const float LogWeight = LogPosterior[i] - Max;
+        const float Weight = FMath::Exp(LogWeight);
+        Sum += Weight;
+        WeightedSum += i * Weight;
+        WeightedSquareSum += i * i * Weight;
+
+        // Levels with zero prior mass hold a huge negative log value and add nothing to the entropy
+        WeightedLogSum += Weight > 0.0f ? Weight * LogWeight : 0.0f;
+
+        if (LogPosterior[i] > LogPosterior[ModeLevel])
+        {
+            ModeLevel = i;
+        }
+    }
+
+    const float InvSum = 1.0f / Sum;
+    const float LogSum = FMath::Loge(Sum);
+    const float MeanLevel = WeightedSum * InvSum;
+    const float LevelVariance = FMath::Max(WeightedSquareSum * InvSum - MeanLevel * MeanLevel, 0.0f);
+
+    // With p_i = w_i / S: H = -sum p_i log p_i = log S - sum w_i log w_i / S.
+    // The entropy offset puts it on the common EntropyStepInDb bins, so it does not jump on a re-bin
+    FPosteriorMoments& LocationMoments = Moments[LocationIndex];
+    LocationMoments.MeanInDb = Origin + MeanLevel * Step;
+    LocationMoments.Variance = LevelVariance * Step * Step;
+    LocationMoments.StandardDeviationInDb = FMath::Sqrt(LocationMoments.Variance);
+    LocationMoments.ModeInDb = Origin + ModeLevel * Step;
+    LocationMoments.Entropy = LogSum - WeightedLogSum * InvSum + GetEntropyOffset(LocationIndex);
+
+    LogNormalizers[LocationIndex] = Max + LogSum;
+}
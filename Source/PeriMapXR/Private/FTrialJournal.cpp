@@ -0,0 +1,164 @@
+// FTrialJournal.cpp
+
+#include "FTrialJournal.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "Misc/DateTime.h"
+
+static_assert(sizeof(FTrialJournalRecord) == 64, "Journal record layout is part of the file format");
+static_assert(sizeof(FTrialJournalFileHeader) == 40, "Journal file header layout is part of the file format");
+
+// Constructor: the ring is allocated once, so appending never allocates
+FTrialJournal::FTrialJournal()
+    : NumAppended(0)
+    , NumWritten(0)
+    , bStopRequested(false)
+    , NumDropped(0)
+    , SyncIntervalSeconds(0.5f)
+    , WakeEvent(FPlatformProcess::GetSynchEventFromPool(false))
+    , Thread(nullptr)
+{
+    Ring.SetNumZeroed(Capacity);
+}
+
+// Destructor: nothing queued is lost on the way out
+FTrialJournal::~FTrialJournal()
+{
+    Close();
+    FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+}
+
+// Opens the file so a failure is reported to the caller, then hands it to the writer thread; nothing is written here
+bool FTrialJournal::Open(const FString& InFilePath, float InSyncIntervalSeconds)
+{
+    if (Thread)
+    {
+        return false;
+    }
+
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    FileHandle.Reset(PlatformFile.OpenWrite(*InFilePath, true, true));
+    if (!FileHandle)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to open trial journal %s; trials will not be journaled."), *InFilePath);
+        return false;
+    }
+
+    FilePath = InFilePath;
+    SyncIntervalSeconds = FMath::Max(InSyncIntervalSeconds, 0.01f);
+    NumAppended.store(0);
+    NumWritten.store(0);
+    bStopRequested.store(false);
+    NumDropped = 0;
+
+    Thread = FRunnableThread::Create(this, TEXT("PeriMapXRTrialJournal"), 0, TPri_BelowNormal);
+    if (!Thread)
+    {
+        FileHandle.Reset();
+        return false;
+    }
+    return true;
+}
+
+// Copies the record into the next free slot and publishes it to the writer
+bool FTrialJournal::Append(const FTrialJournalRecord& Record)
+{
+    const uint64 Head = NumAppended.load(std::memory_order_relaxed);
+    if (!Thread || Head - NumWritten.load(std::memory_order_acquire) >= (uint64)Capacity)
+    {
+        NumDropped++;
+        return false;
+    }
+
+    FTrialJournalRecord& Slot = Ring[(int32)(Head % Capacity)];
+    FMemory::Memcpy(&Slot, &Record, sizeof(FTrialJournalRecord));
+    Slot.Sequence = (int32)Head;
+    NumAppended.store(Head + 1, std::memory_order_release);
+    return true;
+}
+
+// Wakes the writer for its last pass and waits for it
+void FTrialJournal::Close()
+{
+    if (!Thread)
+    {
+        return;
+    }
+
+    Stop();
+    Thread->WaitForCompletion();
+    delete Thread;
+    Thread = nullptr;
+    FileHandle.Reset();
+
+    if (NumDropped > 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Trial journal %s dropped %lld records: the writer fell behind."), *FilePath, NumDropped);
+    }
+}
+
+// Asks the writer to finish; it drains the ring before leaving
+void FTrialJournal::Stop()
+{
+    bStopRequested.store(true);
+    WakeEvent->Trigger();
+}
+
+// Writer loop: one write and one sync per batch of records, every SyncIntervalSeconds
+uint32 FTrialJournal::Run()
+{
+    // A new file starts with its header; an existing one is appended to as it is
+    if (FileHandle->Size() == 0)
+    {
+        FTrialJournalFileHeader Header;
+        Header.Magic = FileMagic;
+        Header.Version = FileVersion;
+        Header.RecordSize = sizeof(FTrialJournalRecord);
+        Header.Reserved = 0;
+        Header.SecondsPerCycle = FPlatformTime::GetSecondsPerCycle64();
+        Header.StartDateTimeTicks = FDateTime::UtcNow().GetTicks();
+        Header.StartCycles = (int64)FPlatformTime::Cycles64();
+        FileHandle->Write((const uint8*)&Header, sizeof(Header));
+        FileHandle->Flush(true);
+    }
+
+    const uint32 WaitMilliseconds = (uint32)FMath::CeilToInt(SyncIntervalSeconds * 1000.0f);
+    while (!bStopRequested.load())
+    {
+        WakeEvent->Wait(WaitMilliseconds);
+        WritePending();
+    }
+
+    // Records queued while the last pass was writing
+    WritePending();
+    return 0;
+}
+
+// Writes the queued records straight from the ring, in at most two runs around its end, then syncs once
+void FTrialJournal::WritePending()
+{
+    const uint64 Head = NumAppended.load(std::memory_order_acquire);
+    uint64 Tail = NumWritten.load(std::memory_order_relaxed);
+    if (Head == Tail)
+    {
+        return;
+    }
+
+    while (Tail < Head)
+    {
+        const int32 Slot = (int32)(Tail % Capacity);
+        const int32 Count = (int32)FMath::Min<uint64>(Head - Tail, (uint64)(Capacity - Slot));
+        if (!FileHandle->Write((const uint8*)&Ring[Slot], Count * sizeof(FTrialJournalRecord)))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Failed to write %d records to trial journal %s"), Count, *FilePath);
+        }
+        Tail += Count;
+    }
+    FileHandle->Flush(true);
+
+    // The slots are free for the game thread only once their records are on disk
+    NumWritten.store(Tail, std::memory_order_release);
+}
@@ -0,0 +1,380 @@
+// PeriMapXRBenchmarks.cpp
+// Console benchmarks for the threshold estimation hot paths. Run from the in-game console or with
+// -ExecCmds="PeriMapXR.Bench.LikelihoodUpdate" on a development build.
+
+#include "CoreMinimal.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "FThresholdPosteriorStore.h"
+#include "FPsychometricLikelihoodTable.h"
+#include "FExpectedEntropySelector.h"
+#include "EStimulusSelectionPolicy.h"
+#include "UThresholdEstimator.h"
+
+#if !UE_BUILD_SHIPPING
+
+// Number of locations in a 24-2 test, used as the benchmark working set
+static const int32 BenchNumLocations = 54;
+
+// Grid and psychometric defaults matching UThresholdEstimator
+static const float BenchMinThresholdInDb = 0.0f;
+static const float BenchMaxThresholdInDb = 40.0f;
+static const float BenchThresholdStepSizeInDb = 1.0f;
+static const float BenchIntensityBinSizeInDb = 0.1f;
+static const float BenchStoppingCriterionInDb = 1.0f;
+
+// Upper bound on presentations per simulated location, so a policy that stalls still terminates
+static const int32 BenchMaxTrialsPerLocation = 200;
+
+// Adaptive grid defaults matching UThresholdEstimator
+static const float BenchCoarseStepSizeInDb = 2.0f;
+static const float BenchFineStepSizeInDb = 0.25f;
+static const float BenchGridRefinementDeviationInDb = 1.0f;
+
+// Parses the optional update count argument shared by every benchmark
+static int32 ParseBenchUpdateCount(const TArray<FString>& Args, int32 DefaultCount)
+{
+    return Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : DefaultCount;
+}
+
+// Linear-domain update the estimator used before the log-domain store: multiply, then renormalize
+static void ApplyLinearLikelihood(float* Posterior, const float* Likelihood, int32 NumLevels)
+{
+    float Sum = 0.0f;
+    for (int32 i = 0; i < NumLevels; ++i)
+    {
+        Posterior[i] *= Likelihood[i];
+        Sum += Posterior[i];
+    }
+
+    // Fall back to a uniform prior if the product underflowed
+    const float InvSum = Sum > 0.0f ? 1.0f / Sum : 0.0f;
+    for (int32 i = 0; i < NumLevels; ++i)
+    {
+        Posterior[i] = Sum > 0.0f ? Posterior[i] * InvSum : 1.0f / NumLevels;
+    }
+}
+
+// Mean of a linear-domain posterior row, used as the checksum for the linear passes
+static float GetLinearMean(const float* Posterior, const float* Levels, int32 NumLevels)
+{
+    float Mean = 0.0f;
+    for (int32 i = 0; i < NumLevels; ++i)
+    {
+        Mean += Levels[i] * Posterior[i];
+    }
+    return Mean;
+}
+
+// Times the per-response posterior update: linear with std::erf per level, linear with the precomputed
+// likelihood table, and the log-domain SIMD kernel with its fused moment pass
+static void RunLikelihoodUpdateBench(const TArray<FString>& Args)
+{
+    const int32 NumUpdates = ParseBenchUpdateCount(Args, 200000);
+    const FPsychometricParameters Params;
+
+    FThresholdPosteriorStore Store;
+    Store.Initialize(BenchNumLocations, BenchMinThresholdInDb, BenchMaxThresholdInDb, BenchThresholdStepSizeInDb);
+    const int32 NumLevels = Store.GetNumLevels();
+    const int32 Stride = Store.GetStride();
+    const float* Levels = Store.GetThresholdLevelsInDb();
+
+    FPsychometricLikelihoodTable Table;
+    const double BuildStart = FPlatformTime::Seconds();
+    Table.EnsureBuilt(Params, Store.GetMinThresholdInDb(), Store.GetThresholdStepSizeInDb(), NumLevels, Stride, BenchIntensityBinSizeInDb);
+    const double BuildSeconds = FPlatformTime::Seconds() - BuildStart;
+
+    // The linear passes keep their own rows, laid out like the store
+    TArray<float> LinearPosteriors;
+    TArray<float> Likelihood;
+    Likelihood.SetNumZeroed(Stride);
+
+    // Every pass replays the same pseudo-random responses
+    FRandomStream Stream(1234);
+    LinearPosteriors.Init(1.0f / NumLevels, BenchNumLocations * Stride);
+    const double ErfStart = FPlatformTime::Seconds();
+    for (int32 Update = 0; Update < NumUpdates; ++Update)
+    {
+        const int32 LocationIndex = Update % BenchNumLocations;
+        const float StimulusIntensity = Table.GetBinIntensityInDb(Stream.RandRange(0, Table.GetNumBins() - 1));
+        const bool bSeen = Stream.FRand() < 0.5f;
+
+        for (int32 i = 0; i < NumLevels; ++i)
+        {
+            const float ProbabilityOfSeeing = FPsychometricLikelihoodTable::Evaluate(Params, StimulusIntensity, Levels[i]);
+            Likelihood[i] = bSeen ? ProbabilityOfSeeing : (1.0f - ProbabilityOfSeeing);
+        }
+        ApplyLinearLikelihood(LinearPosteriors.GetData() + LocationIndex * Stride, Likelihood.GetData(), NumLevels);
+    }
+    const double ErfSeconds = FPlatformTime::Seconds() - ErfStart;
+    const float ErfChecksum = GetLinearMean(LinearPosteriors.GetData(), Levels, NumLevels);
+
+    Stream.Initialize(1234);
+    LinearPosteriors.Init(1.0f / NumLevels, BenchNumLocations * Stride);
+    const double TableStart = FPlatformTime::Seconds();
+    for (int32 Update = 0; Update < NumUpdates; ++Update)
+    {
+        const int32 LocationIndex = Update % BenchNumLocations;
+        const int32 Bin = Stream.RandRange(0, Table.GetNumBins() - 1);
+        const bool bSeen = Stream.FRand() < 0.5f;
+
+        ApplyLinearLikelihood(LinearPosteriors.GetData() + LocationIndex * Stride, Table.GetLikelihoodRow(Bin, bSeen), NumLevels);
+    }
+    const double TableSeconds = FPlatformTime::Seconds() - TableStart;
+    const float TableChecksum = GetLinearMean(LinearPosteriors.GetData(), Levels, NumLevels);
+
+    Stream.Initialize(1234);
+    const double LogStart = FPlatformTime::Seconds();
+    for (int32 Update = 0; Update < NumUpdates; ++Update)
+    {
+        const int32 LocationIndex = Update % BenchNumLocations;
+        const int32 Bin = Stream.RandRange(0, Table.GetNumBins() - 1);
+        const bool bSeen = Stream.FRand() < 0.5f;
+
+        Store.ApplyLogLikelihood(LocationIndex, Table.GetLogLikelihoodRow(Bin, bSeen));
+    }
+    const double LogSeconds = FPlatformTime::Seconds() - LogStart;
+
+    // Moments are refreshed inside the update, so reading them back should cost next to nothing
+    const double MomentStart = FPlatformTime::Seconds();
+    float MeanSum = 0.0f;
+    for (int32 LocationIndex = 0; LocationIndex < BenchNumLocations; ++LocationIndex)
+    {
+        MeanSum += Store.GetMean(LocationIndex);
+    }
+    const double MomentSeconds = FPlatformTime::Seconds() - MomentStart;
+    const float LogChecksum = Store.GetMean(0);
+
+    UE_LOG(LogTemp, Display, TEXT("PeriMapXR.Bench.LikelihoodUpdate: %d updates over %d locations x %d levels"), NumUpdates, BenchNumLocations, NumLevels);
+    UE_LOG(LogTemp, Display, TEXT("  table build (%d bins): %.3f ms"), Table.GetNumBins(), BuildSeconds * 1000.0);
+    UE_LOG(LogTemp, Display, TEXT("  linear, erf per level:    %.1f ns/update (checksum %f)"), ErfSeconds * 1.0e9 / NumUpdates, ErfChecksum);
+    UE_LOG(LogTemp, Display, TEXT("  linear, likelihood table: %.1f ns/update (checksum %f)"), TableSeconds * 1.0e9 / NumUpdates, TableChecksum);
+    UE_LOG(LogTemp, Display, TEXT("  log kernel + moments:     %.1f ns/update (checksum %f)"), LogSeconds * 1.0e9 / NumUpdates, LogChecksum);
+    UE_LOG(LogTemp, Display, TEXT("  cached mean, read back:   %.1f ns/location (sum %f)"), MomentSeconds * 1.0e9 / BenchNumLocations, MeanSum);
+}
+
+static FAutoConsoleCommand BenchLikelihoodUpdateCommand(
+    TEXT("PeriMapXR.Bench.LikelihoodUpdate"),
+    TEXT("Times the posterior update with per-level std::erf, the linear likelihood table and the log-domain SIMD kernel. Usage: PeriMapXR.Bench.LikelihoodUpdate [NumUpdates]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunLikelihoodUpdateBench));
+
+// Per-policy totals gathered by the stimulus selection benchmark
+struct FSelectionBenchTotals
+{
+    int64 Trials = 0;
+    int32 UnfinishedLocations = 0;
+    double AbsoluteErrorSum = 0.0;
+    double SelectionSeconds = 0.0;
+};
+
+// Runs simulated locations to the stopping criterion with one selection policy
+static FSelectionBenchTotals RunSelectionPolicy(EStimulusSelectionPolicy Policy, const TArray<float>& TrueThresholds, const FPsychometricParameters& Params,
+    FThresholdPosteriorStore& Store, const FPsychometricLikelihoodTable& Table)
+{
+    FSelectionBenchTotals Totals;
+    const float* Levels = Store.GetThresholdLevelsInDb();
+    const float MaxLevelInDb = Levels[Store.GetNumLevels() - 1];
+
+    // The same response stream is replayed for each policy
+    FRandomStream Stream(4321);
+    for (float TrueThresholdInDb : TrueThresholds)
+    {
+        Store.ResetLocation(0);
+
+        int32 Trial = 0;
+        for (; Trial < BenchMaxTrialsPerLocation && Store.GetStandardDeviation(0) > BenchStoppingCriterionInDb; ++Trial)
+        {
+            const double SelectStart = FPlatformTime::Seconds();
+            const float StimulusIntensity = Policy == EStimulusSelectionPolicy::MinimumExpectedEntropy
+                ? FExpectedEntropySelector::SelectIntensityInDb(Store, Table, 0)
+                : FMath::Clamp(Store.GetMean(0), Levels[0], MaxLevelInDb);
+            Totals.SelectionSeconds += FPlatformTime::Seconds() - SelectStart;
+
+            const bool bSeen = Stream.FRand() < FPsychometricLikelihoodTable::Evaluate(Params, StimulusIntensity, TrueThresholdInDb);
+            Store.ApplyLogLikelihood(0, Table.GetLogLikelihoodRow(StimulusIntensity, bSeen));
+        }
+
+        Totals.Trials += Trial;
+        Totals.UnfinishedLocations += Trial == BenchMaxTrialsPerLocation ? 1 : 0;
+        Totals.AbsoluteErrorSum += FMath::Abs(Store.GetMean(0) - TrueThresholdInDb);
+    }
+    return Totals;
+}
+
+// Compares trials to reach the stopping criterion for the posterior-mean and minimum-expected-entropy policies
+static void RunStimulusSelectionBench(const TArray<FString>& Args)
+{
+    const int32 NumSimulatedLocations = ParseBenchUpdateCount(Args, 2000);
+    const FPsychometricParameters Params;
+
+    FThresholdPosteriorStore Store;
+    Store.Initialize(1, BenchMinThresholdInDb, BenchMaxThresholdInDb, BenchThresholdStepSizeInDb);
+
+    FPsychometricLikelihoodTable Table;
+    Table.EnsureBuilt(Params, Store.GetMinThresholdInDb(), Store.GetThresholdStepSizeInDb(), Store.GetNumLevels(), Store.GetStride(), BenchIntensityBinSizeInDb);
+
+    // True thresholds are drawn away from the grid edges so neither policy is helped by the clamp
+    FRandomStream ThresholdStream(5678);
+    TArray<float> TrueThresholds;
+    TrueThresholds.SetNumUninitialized(NumSimulatedLocations);
+    for (float& TrueThresholdInDb : TrueThresholds)
+    {
+        TrueThresholdInDb = ThresholdStream.FRandRange(BenchMinThresholdInDb + 2.0f, BenchMaxThresholdInDb - 2.0f);
+    }
+
+    UE_LOG(LogTemp, Display, TEXT("PeriMapXR.Bench.StimulusSelection: %d simulated locations, stop at SD <= %.2f dB, at most %d trials each"),
+        NumSimulatedLocations, BenchStoppingCriterionInDb, BenchMaxTrialsPerLocation);
+
+    const EStimulusSelectionPolicy Policies[] = { EStimulusSelectionPolicy::PosteriorMean, EStimulusSelectionPolicy::MinimumExpectedEntropy };
+    const TCHAR* PolicyNames[] = { TEXT("posterior mean:          "), TEXT("minimum expected entropy:") };
+    for (int32 PolicyIndex = 0; PolicyIndex < UE_ARRAY_COUNT(Policies); ++PolicyIndex)
+    {
+        const FSelectionBenchTotals Totals = RunSelectionPolicy(Policies[PolicyIndex], TrueThresholds, Params, Store, Table);
+        UE_LOG(LogTemp, Display, TEXT("  %s %.2f trials/location, mean abs error %.2f dB, %d unfinished, %.2f us/selection"),
+            PolicyNames[PolicyIndex],
+            (double)Totals.Trials / NumSimulatedLocations,
+            Totals.AbsoluteErrorSum / NumSimulatedLocations,
+            Totals.UnfinishedLocations,
+            Totals.Trials > 0 ? Totals.SelectionSeconds * 1.0e6 / Totals.Trials : 0.0);
+    }
+}
+
+static FAutoConsoleCommand BenchStimulusSelectionCommand(
+    TEXT("PeriMapXR.Bench.StimulusSelection"),
+    TEXT("Reports average trials to the stopping criterion for posterior-mean versus minimum-expected-entropy stimulus selection. Usage: PeriMapXR.Bench.StimulusSelection [NumSimulatedLocations]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunStimulusSelectionBench));
+
+// Builds a 24-2 style grid: a 6-degree lattice offset 3 degrees from the meridians, trimmed to an ellipse
+static void BuildBenchGrid(TArray<FVector>& OutLocations, TArray<FVector2D>& OutAngularPositions)
+{
+    for (int32 VerticalAngle = -21; VerticalAngle <= 21; VerticalAngle += 6)
+    {
+        for (int32 HorizontalAngle = -27; HorizontalAngle <= 27; HorizontalAngle += 6)
+        {
+            if (FMath::Square(HorizontalAngle / 27.0f) + FMath::Square(VerticalAngle / 21.0f) > 1.15f)
+            {
+                continue;
+            }
+
+            // Same layout as ATestStimuli::PolarToCartesian
+            const float Vertical = FMath::DegreesToRadians((float)VerticalAngle);
+            const float Horizontal = FMath::DegreesToRadians((float)HorizontalAngle);
+            OutLocations.Add(FVector(FMath::Cos(Vertical) * FMath::Sin(Horizontal), FMath::Sin(Vertical), FMath::Cos(Vertical) * FMath::Cos(Horizontal)) * 100.0f);
+            OutAngularPositions.Add(FVector2D(HorizontalAngle, VerticalAngle));
+        }
+    }
+}
+
+// Compares presentations per eye with and without spatial priors on simulated fields
+static void RunSpatialPriorBench(const TArray<FString>& Args)
+{
+    const int32 NumEyes = ParseBenchUpdateCount(Args, 20);
+    const FPsychometricParameters Params;
+
+    TArray<FVector> Locations;
+    TArray<FVector2D> AngularPositions;
+    BuildBenchGrid(Locations, AngularPositions);
+
+    UE_LOG(LogTemp, Display, TEXT("PeriMapXR.Bench.SpatialPriors: %d simulated eyes, %d locations each"), NumEyes, Locations.Num());
+
+    for (const bool bUseSpatialPriors : { false, true })
+    {
+        int64 TotalPresentations = 0;
+        double AbsoluteErrorSum = 0.0;
+
+        for (int32 Eye = 0; Eye < NumEyes; ++Eye)
+        {
+            // Sloping hill of vision with local noise; every fourth eye has a deep superior-temporal defect
+            FRandomStream Stream(100 + Eye);
+            TArray<float> TrueThresholds;
+            for (const FVector2D& AngularPosition : AngularPositions)
+            {
+                const float Eccentricity = AngularPosition.Size();
+                float TrueThresholdInDb = 31.0f - 0.12f * Eccentricity + Stream.FRandRange(-1.5f, 1.5f);
+                if (Eye % 4 == 0 && AngularPosition.X > 0.0f && AngularPosition.Y > 0.0f && Eccentricity > 10.0f)
+                {
+                    TrueThresholdInDb -= 15.0f;
+                }
+                TrueThresholds.Add(FMath::Clamp(TrueThresholdInDb, BenchMinThresholdInDb, BenchMaxThresholdInDb));
+            }
+
+            UThresholdEstimator* Estimator = NewObject<UThresholdEstimator>();
+            Estimator->SelectionPolicy = EStimulusSelectionPolicy::MinimumExpectedEntropy;
+            Estimator->bUseSpatialPriors = bUseSpatialPriors;
+            Estimator->Initialize(FTestSettings(), ETestType::TEST_24_2, true);
+            Estimator->RegisterLocations(Locations);
+
+            for (int32 LocationIndex = Estimator->GetNextLocationIndex(INDEX_NONE); LocationIndex != INDEX_NONE; LocationIndex = Estimator->GetNextLocationIndex(LocationIndex))
+            {
+                const float StimulusIntensity = Estimator->GetNextStimulusIntensityInDbAtIndex(LocationIndex);
+                const bool bSeen = Stream.FRand() < FPsychometricLikelihoodTable::Evaluate(Params, StimulusIntensity, TrueThresholds[LocationIndex]);
+                Estimator->UpdateWithResponseAtIndex(LocationIndex, StimulusIntensity, bSeen);
+            }
+
+            TotalPresentations += Estimator->GetTotalPresentations();
+            for (int32 LocationIndex = 0; LocationIndex < Locations.Num(); ++LocationIndex)
+            {
+                AbsoluteErrorSum += FMath::Abs(Estimator->GetThresholdEstimateInDb(Locations[LocationIndex]) - TrueThresholds[LocationIndex]);
+            }
+        }
+
+        UE_LOG(LogTemp, Display, TEXT("  spatial priors %s: %.1f presentations/eye, mean abs error %.2f dB"),
+            bUseSpatialPriors ? TEXT("on: ") : TEXT("off:"),
+            (double)TotalPresentations / NumEyes,
+            AbsoluteErrorSum / (NumEyes * Locations.Num()));
+    }
+}
+
+static FAutoConsoleCommand BenchSpatialPriorsCommand(
+    TEXT("PeriMapXR.Bench.SpatialPriors"),
+    TEXT("Reports presentations per eye with and without neighbour-seeded priors on simulated 24-2 fields. Usage: PeriMapXR.Bench.SpatialPriors [NumEyes]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunSpatialPriorBench));
+
+// Per-update cost of a store row, replaying the same random responses on every location
+static double TimeBenchUpdates(FThresholdPosteriorStore& Store, const FPsychometricLikelihoodTable& Table, int32 NumUpdates)
+{
+    FRandomStream Stream(1234);
+    const double Start = FPlatformTime::Seconds();
+    for (int32 Update = 0; Update < NumUpdates; ++Update)
+    {
+        const int32 Bin = Stream.RandRange(0, Table.GetNumBins() - 1);
+        Store.ApplyLogLikelihood(Update % Store.GetNumLocations(), Table.GetLogLikelihoodRow(Bin, Stream.FRand() < 0.5f));
+    }
+    return (FPlatformTime::Seconds() - Start) * 1.0e9 / NumUpdates;
+}
+
+// Reports the update cost at the coarse and the uniform fine resolution; the re-bin's accuracy is checked by the
+// PeriMapXR.ThresholdEstimation.AdaptiveGridRebin automation test
+static void RunAdaptiveGridBench(const TArray<FString>& Args)
+{
+    const int32 NumUpdates = ParseBenchUpdateCount(Args, 1000000);
+
+    // A 24-2 sized working set at each resolution; the fine table's extra row width lets a window near the top read a full stride
+    const FPsychometricParameters Params;
+    FThresholdPosteriorStore CoarseRows;
+    CoarseRows.Initialize(BenchNumLocations, BenchMinThresholdInDb, BenchMaxThresholdInDb, BenchCoarseStepSizeInDb);
+    FThresholdPosteriorStore FineRows;
+    FineRows.Initialize(BenchNumLocations, BenchMinThresholdInDb, BenchMaxThresholdInDb, BenchFineStepSizeInDb);
+    const int32 NumLevels = CoarseRows.GetNumLevels();
+    const int32 FineNumLevels = FineRows.GetNumLevels();
+    FPsychometricLikelihoodTable CoarseTable;
+    CoarseTable.EnsureBuilt(Params, BenchMinThresholdInDb, BenchCoarseStepSizeInDb, NumLevels, CoarseRows.GetStride(), BenchIntensityBinSizeInDb);
+    FPsychometricLikelihoodTable FineTable;
+    FineTable.EnsureBuilt(Params, BenchMinThresholdInDb, BenchFineStepSizeInDb, FineNumLevels, FineRows.GetStride() + CoarseRows.GetStride(), BenchIntensityBinSizeInDb);
+
+    const double CoarseNanoseconds = TimeBenchUpdates(CoarseRows, CoarseTable, NumUpdates);
+    const double FineNanoseconds = TimeBenchUpdates(FineRows, FineTable, NumUpdates);
+
+    UE_LOG(LogTemp, Display, TEXT("PeriMapXR.Bench.AdaptiveGrid: %d updates, %.2f dB grid re-binned to %.2f dB at SD <= %.2f dB (%d levels per row)"),
+        NumUpdates, BenchCoarseStepSizeInDb, BenchFineStepSizeInDb, BenchGridRefinementDeviationInDb, NumLevels);
+    UE_LOG(LogTemp, Display, TEXT("  update cost: %.1f ns/update at %d levels, %.1f ns/update on a uniform %.2f dB grid (%d levels)"),
+        CoarseNanoseconds, NumLevels, FineNanoseconds, BenchFineStepSizeInDb, FineNumLevels);
+}
+
+static FAutoConsoleCommand BenchAdaptiveGridCommand(
+    TEXT("PeriMapXR.Bench.AdaptiveGrid"),
+    TEXT("Reports the update cost of a row at the coarse and the uniform fine resolution. Usage: PeriMapXR.Bench.AdaptiveGrid [NumUpdates]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunAdaptiveGridBench));
+
+#endif // !UE_BUILD_SHIPPING
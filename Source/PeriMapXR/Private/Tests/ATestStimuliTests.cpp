@@ -0,0 +1,64 @@
+// ATestStimuliTests.cpp
+// Automation tests for ATestStimuli. Run with -ExecCmds="Automation RunTests PeriMapXR" on a development build.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "ATestStimuli.h"
+#include "AFixationPoint.h"
+#include "ABackgroundSphere.h"
+#include "UStimulusFieldComponent.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPeriMapXRTestStimuliPoolingTest, "PeriMapXR.TestStimuli.ScenePooling",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Sets up a 24-2 test in a fresh world and switches eyes twice; the scene actors and the stimulus field must be
+// reused, so neither the live actor count nor the number of stimuli and components may change after the first setup
+bool FPeriMapXRTestStimuliPoolingTest::RunTest(const FString& Parameters)
+{
+    // The world never begins play, so ATestStimuli::BeginPlay does not start a test of its own
+    UWorld* World = UWorld::CreateWorld(EWorldType::Game, false);
+    FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+    WorldContext.SetCurrentWorld(World);
+
+    ATestStimuli* TestStimuli = World->SpawnActor<ATestStimuli>(FVector::ZeroVector, FRotator::ZeroRotator);
+    if (!TestNotNull(TEXT("ATestStimuli spawned"), TestStimuli))
+    {
+        GEngine->DestroyWorldContext(World);
+        World->DestroyWorld(false);
+        return false;
+    }
+
+    // Without an HMD the scene is laid out in front of the actor, as in a headless run
+    TestStimuli->bHeadlessDriver = true;
+    TestStimuli->FixationActorClass = AFixationPoint::StaticClass();
+    TestStimuli->BackgroundSphereActorClass = ABackgroundSphere::StaticClass();
+    TestStimuli->ConvergingLinesActorClass = AActor::StaticClass();
+
+    TestStimuli->SetupTest(ETestType::TEST_24_2);
+    const int32 ActorCount = World->GetActorCount();
+    const int32 NumStimuli = TestStimuli->StimulusField->GetNumStimuli();
+    const int32 NumComponents = TestStimuli->GetComponents().Num();
+    TestTrue(TEXT("The first setup spawns the fixation point, background sphere and converging lines"),
+        TestStimuli->FixationActor != nullptr && TestStimuli->BackgroundSphereActor != nullptr && TestStimuli->ConvergingLinesActor != nullptr);
+    TestTrue(TEXT("The first setup fills the stimulus field"), NumStimuli > 0);
+
+    for (int32 Switch = 1; Switch <= 2; ++Switch)
+    {
+        TestStimuli->SwitchEye();
+        TestEqual(FString::Printf(TEXT("Live actors after switch %d"), Switch), World->GetActorCount(), ActorCount);
+        TestEqual(FString::Printf(TEXT("Stimuli in the field after switch %d"), Switch), TestStimuli->StimulusField->GetNumStimuli(), NumStimuli);
+        TestEqual(FString::Printf(TEXT("Components on the actor after switch %d"), Switch), TestStimuli->GetComponents().Num(), NumComponents);
+    }
+
+    // Take the estimator back from the task graph before the world goes
+    TestStimuli->AsyncEstimator.Flush();
+    GEngine->DestroyWorldContext(World);
+    World->DestroyWorld(false);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
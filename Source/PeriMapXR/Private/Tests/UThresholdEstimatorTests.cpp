@@ -0,0 +1,167 @@
+// UThresholdEstimatorTests.cpp
+// Automation tests for the threshold estimation. Run with -ExecCmds="Automation RunTests PeriMapXR" on a development build.
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Math/RandomStream.h"
+#include "FThresholdPosteriorStore.h"
+#include "FPsychometricLikelihoodTable.h"
+#include "FExpectedEntropySelector.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Grid and adaptive grid defaults matching UThresholdEstimator
+static const float TestMinThresholdInDb = 0.0f;
+static const float TestMaxThresholdInDb = 40.0f;
+static const float TestIntensityBinSizeInDb = 0.1f;
+static const float TestCoarseStepSizeInDb = 2.0f;
+static const float TestFineStepSizeInDb = 0.25f;
+static const float TestGridRefinementDeviationInDb = 1.0f;
+
+// Upper bound on presentations per simulated location, so a location that never narrows still terminates
+static const int32 TestMaxTrialsPerLocation = 200;
+
+// Interpolation error of the coarse-to-fine re-bin, summed over the simulated locations that were re-binned
+struct FAdaptiveGridAccuracy
+{
+    int32 NumRebinned = 0;
+    double TotalVariationSum = 0.0;
+    double MaxTotalVariation = 0.0;
+    double MeanErrorSum = 0.0;
+    double MaxMeanError = 0.0;
+    double DeviationErrorSum = 0.0;
+    double TruncatedMassSum = 0.0;
+    double MaxTruncatedMass = 0.0;
+};
+
+// Checks the coarse-to-fine re-bin against a posterior updated on a uniform fine grid from the start, drawing
+// each location's true threshold and responses from a stream seeded with Seed
+static FAdaptiveGridAccuracy MeasureAdaptiveGridAccuracy(int32 NumSimulatedLocations, int32 Seed)
+{
+    const FPsychometricParameters Params;
+
+    // The coarse store is the one that gets re-binned; the reference holds the exact posterior on the full fine grid
+    FThresholdPosteriorStore Store;
+    Store.Initialize(1, TestMinThresholdInDb, TestMaxThresholdInDb, TestCoarseStepSizeInDb);
+    FThresholdPosteriorStore Reference;
+    Reference.Initialize(1, TestMinThresholdInDb, TestMaxThresholdInDb, TestFineStepSizeInDb);
+
+    const int32 NumLevels = Store.GetNumLevels();
+    const int32 FineNumLevels = Reference.GetNumLevels();
+    FPsychometricLikelihoodTable CoarseTable;
+    CoarseTable.EnsureBuilt(Params, TestMinThresholdInDb, TestCoarseStepSizeInDb, NumLevels, Store.GetStride(), TestIntensityBinSizeInDb);
+    FPsychometricLikelihoodTable FineTable;
+    FineTable.EnsureBuilt(Params, TestMinThresholdInDb, TestFineStepSizeInDb, FineNumLevels, Reference.GetStride() + Store.GetStride(), TestIntensityBinSizeInDb);
+
+    // Window placement as in UThresholdEstimator::GetFineWindowOriginInDb
+    const float AlignmentInDb = FThresholdPosteriorStore::RowAlignment * TestFineStepSizeInDb;
+    const float WindowInDb = (NumLevels - 1) * TestFineStepSizeInDb;
+    const float MaxOriginInDb = TestMinThresholdInDb + FMath::FloorToFloat((TestMaxThresholdInDb - TestMinThresholdInDb - WindowInDb) / AlignmentInDb + KINDA_SMALL_NUMBER) * AlignmentInDb;
+
+    TArray<float> Rebinned;
+    Rebinned.SetNumUninitialized(NumLevels);
+    TArray<float> Exact;
+    Exact.SetNumUninitialized(FineNumLevels);
+
+    FRandomStream Stream(Seed);
+    FAdaptiveGridAccuracy Accuracy;
+    for (int32 Location = 0; Location < NumSimulatedLocations; ++Location)
+    {
+        const float TrueThresholdInDb = Stream.FRandRange(TestMinThresholdInDb + 2.0f, TestMaxThresholdInDb - 2.0f);
+        Store.ResetLocation(0);
+        Reference.ResetLocation(0);
+
+        for (int32 Trial = 0; Trial < TestMaxTrialsPerLocation && Store.GetStandardDeviation(0) > TestGridRefinementDeviationInDb; ++Trial)
+        {
+            const float StimulusIntensity = FExpectedEntropySelector::SelectIntensityInDb(Store, CoarseTable, 0);
+            const bool bSeen = Stream.FRand() < FPsychometricLikelihoodTable::Evaluate(Params, StimulusIntensity, TrueThresholdInDb);
+            Store.ApplyLogLikelihood(0, CoarseTable.GetLogLikelihoodRow(StimulusIntensity, bSeen));
+            Reference.ApplyLogLikelihood(0, FineTable.GetLogLikelihoodRow(StimulusIntensity, bSeen));
+        }
+        if (Store.GetStandardDeviation(0) > TestGridRefinementDeviationInDb)
+        {
+            continue;
+        }
+
+        const float OriginInDb = FMath::Clamp(
+            TestMinThresholdInDb + FMath::RoundToFloat((Store.GetMoments(0).ModeInDb - 0.5f * WindowInDb - TestMinThresholdInDb) / AlignmentInDb) * AlignmentInDb,
+            TestMinThresholdInDb, MaxOriginInDb);
+        Store.Rebin(0, OriginInDb, TestFineStepSizeInDb);
+        Store.GetPosterior(0, Rebinned.GetData());
+        Reference.GetPosterior(0, Exact.GetData());
+
+        // Compare against the exact posterior restricted to the window, so interpolation and truncation are reported apart
+        const int32 Offset = FineTable.GetLevelOffset(OriginInDb);
+        double WindowMass = 0.0;
+        double ExactMean = 0.0;
+        double ExactMeanSquare = 0.0;
+        for (int32 i = 0; i < NumLevels; ++i)
+        {
+            const double Level = Store.GetLevelInDb(0, i);
+            WindowMass += Exact[Offset + i];
+            ExactMean += Exact[Offset + i] * Level;
+            ExactMeanSquare += Exact[Offset + i] * Level * Level;
+        }
+        ExactMean /= WindowMass;
+        const double ExactDeviation = FMath::Sqrt(FMath::Max(ExactMeanSquare / WindowMass - ExactMean * ExactMean, 0.0));
+
+        double TotalVariation = 0.0;
+        for (int32 i = 0; i < NumLevels; ++i)
+        {
+            TotalVariation += 0.5 * FMath::Abs(Rebinned[i] - Exact[Offset + i] / WindowMass);
+        }
+        const double MeanError = FMath::Abs(Store.GetMean(0) - ExactMean);
+
+        Accuracy.NumRebinned++;
+        Accuracy.TotalVariationSum += TotalVariation;
+        Accuracy.MaxTotalVariation = FMath::Max(Accuracy.MaxTotalVariation, TotalVariation);
+        Accuracy.MeanErrorSum += MeanError;
+        Accuracy.MaxMeanError = FMath::Max(Accuracy.MaxMeanError, MeanError);
+        Accuracy.DeviationErrorSum += FMath::Abs(Store.GetStandardDeviation(0) - ExactDeviation);
+        Accuracy.TruncatedMassSum += 1.0 - WindowMass;
+        Accuracy.MaxTruncatedMass = FMath::Max(Accuracy.MaxTruncatedMass, 1.0 - WindowMass);
+    }
+    return Accuracy;
+}
+
+// Bounds on the re-bin's interpolation error for the fixed-seed run below. A correct quadratic re-bin gives about
+// 0.023 mean and 0.06 max total variation, 0.011 dB mean and 0.06 dB max mean error, and 0.008 dB mean SD error;
+// re-binning with linear interpolation already breaks the mean bounds
+static const int32 AdaptiveGridTestNumLocations = 500;
+static const int32 AdaptiveGridTestSeed = 4321;
+static const double AdaptiveGridTestMaxMeanTotalVariation = 0.04;
+static const double AdaptiveGridTestMaxTotalVariation = 0.1;
+static const double AdaptiveGridTestMaxMeanMeanErrorInDb = 0.02;
+static const double AdaptiveGridTestMaxMeanErrorInDb = 0.1;
+static const double AdaptiveGridTestMaxMeanDeviationErrorInDb = 0.02;
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPeriMapXRAdaptiveGridRebinTest, "PeriMapXR.ThresholdEstimation.AdaptiveGridRebin",
+    EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+// Re-bins simulated coarse posteriors onto the fine window and checks them against the uniform fine-grid reference
+bool FPeriMapXRAdaptiveGridRebinTest::RunTest(const FString& Parameters)
+{
+    const FAdaptiveGridAccuracy Accuracy = MeasureAdaptiveGridAccuracy(AdaptiveGridTestNumLocations, AdaptiveGridTestSeed);
+
+    // Nearly every location narrows to the refinement deviation well within the trial cap
+    TestTrue(TEXT("Most simulated locations are re-binned"), Accuracy.NumRebinned >= AdaptiveGridTestNumLocations * 9 / 10);
+    if (Accuracy.NumRebinned == 0)
+    {
+        return false;
+    }
+
+    const double NumRebinned = Accuracy.NumRebinned;
+    TestTrue(FString::Printf(TEXT("Mean total variation %.4f <= %.4f"), Accuracy.TotalVariationSum / NumRebinned, AdaptiveGridTestMaxMeanTotalVariation),
+        Accuracy.TotalVariationSum / NumRebinned <= AdaptiveGridTestMaxMeanTotalVariation);
+    TestTrue(FString::Printf(TEXT("Max total variation %.4f <= %.4f"), Accuracy.MaxTotalVariation, AdaptiveGridTestMaxTotalVariation),
+        Accuracy.MaxTotalVariation <= AdaptiveGridTestMaxTotalVariation);
+    TestTrue(FString::Printf(TEXT("Mean error of the posterior mean %.4f dB <= %.4f dB"), Accuracy.MeanErrorSum / NumRebinned, AdaptiveGridTestMaxMeanMeanErrorInDb),
+        Accuracy.MeanErrorSum / NumRebinned <= AdaptiveGridTestMaxMeanMeanErrorInDb);
+    TestTrue(FString::Printf(TEXT("Max error of the posterior mean %.4f dB <= %.4f dB"), Accuracy.MaxMeanError, AdaptiveGridTestMaxMeanErrorInDb),
+        Accuracy.MaxMeanError <= AdaptiveGridTestMaxMeanErrorInDb);
+    TestTrue(FString::Printf(TEXT("Mean error of the posterior SD %.4f dB <= %.4f dB"), Accuracy.DeviationErrorSum / NumRebinned, AdaptiveGridTestMaxMeanDeviationErrorInDb),
+        Accuracy.DeviationErrorSum / NumRebinned <= AdaptiveGridTestMaxMeanDeviationErrorInDb);
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
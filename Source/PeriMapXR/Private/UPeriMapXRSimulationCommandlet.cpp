@@ -0,0 +1,344 @@
+// UPeriMapXRSimulationCommandlet.cpp
+
+#include "UPeriMapXRSimulationCommandlet.h"
+#include "UThresholdEstimator.h"
+#include "FPsychometricLikelihoodTable.h"
+#include "FStimulusGridLibrary.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "Misc/Parse.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogPeriMapXRSimulation, Log, All);
+
+// Smallest guess / lapse rate handed to the estimator, so no likelihood is exactly zero
+static const float SimulationMinModelRate = 0.005f;
+
+// Share of eyes drawn with a defect that a screening run has to flag with at least one ScreeningDefect location
+static const float SimulationMinDefectEyesFlagged = 0.95f;
+
+// Synthetic observer for one configuration
+struct FSimulationObserver
+{
+    float Slope;
+    float FalsePositiveRate;
+    float FalseNegativeRate;
+};
+
+// Per-eye outcome; each eye owns its slot, so workers never share writes
+struct FSimulatedEyeResult
+{
+    int32 Trials = 0;
+    float TestSeconds = 0.0f;
+    bool bFinished = true;
+    bool bHasDefect = false;
+    int32 StoppingRuleCounts[(int32)EStoppingRule::ScreeningDefect + 1] = {};
+};
+
+// Parses -Key=a,b,c into a list of floats, falling back to a single default
+static TArray<float> ParseFloatList(const FString& Params, const TCHAR* Key, float DefaultValue)
+{
+    TArray<float> Values;
+    FString ListString;
+    if (FParse::Value(*Params, Key, ListString, false))
+    {
+        TArray<FString> Items;
+        ListString.ParseIntoArray(Items, TEXT(","));
+        for (const FString& Item : Items)
+        {
+            Values.Add(FCString::Atof(*Item));
+        }
+    }
+    if (Values.Num() == 0)
+    {
+        Values.Add(DefaultValue);
+    }
+    return Values;
+}
+
+// Draws a field of true thresholds: a sloping hill of vision with local noise, and optionally a deep defect in one quadrant.
+// Returns whether the field has the defect
+static bool DrawTrueThresholds(const TArray<FVector2D>& AngularPositions, float DefectRate, FRandomStream& Stream, TArray<float>& OutThresholdsInDb)
+{
+    const bool bHasDefect = Stream.FRand() < DefectRate;
+    const float DefectHorizontalSign = Stream.FRand() < 0.5f ? -1.0f : 1.0f;
+    const float DefectVerticalSign = Stream.FRand() < 0.5f ? -1.0f : 1.0f;
+    const float DefectDepthInDb = Stream.FRandRange(10.0f, 25.0f);
+
+    OutThresholdsInDb.Reset(AngularPositions.Num());
+    for (const FVector2D& AngularPosition : AngularPositions)
+    {
+        const float Eccentricity = AngularPosition.Size();
+        float ThresholdInDb = 31.0f - 0.12f * Eccentricity + Stream.FRandRange(-1.5f, 1.5f);
+        if (bHasDefect && AngularPosition.X * DefectHorizontalSign > 0.0f && AngularPosition.Y * DefectVerticalSign > 0.0f && Eccentricity > 3.0f)
+        {
+            ThresholdInDb -= DefectDepthInDb;
+        }
+        OutThresholdsInDb.Add(FMath::Clamp(ThresholdInDb, 0.0f, 40.0f));
+    }
+    return bHasDefect;
+}
+
+// Value at a fraction of the way through a sorted array
+template <typename T>
+static T GetPercentile(const TArray<T>& SortedValues, float Fraction)
+{
+    const int32 Index = FMath::Clamp(FMath::RoundToInt(Fraction * (SortedValues.Num() - 1)), 0, SortedValues.Num() - 1);
+    return SortedValues[Index];
+}
+
+// Constructor
+UPeriMapXRSimulationCommandlet::UPeriMapXRSimulationCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+// Runs the simulation described by the command line and logs a report per configuration
+int32 UPeriMapXRSimulationCommandlet::Main(const FString& Params)
+{
+    int32 NumEyes = 1000;
+    int32 Seed = 1;
+    int32 MaxTrialsPerEye = 10000;
+    int32 MaxPresentationsPerLocation = 40;
+    float EyeBudgetInSeconds = 0.0f;
+    float SeenSeconds = 1.2f;
+    float MissedSeconds = 1.2f;
+    float DefectRate = 0.25f;
+    float PatientAgeInYears = 50.0f;
+    FString TestName = TEXT("24-2");
+    FString PolicyName = TEXT("Entropy");
+    FString StrategyName = TEXT("Bayesian");
+    FParse::Value(*Params, TEXT("Eyes="), NumEyes);
+    FParse::Value(*Params, TEXT("Seed="), Seed);
+    FParse::Value(*Params, TEXT("MaxTrialsPerEye="), MaxTrialsPerEye);
+    FParse::Value(*Params, TEXT("MaxPresentations="), MaxPresentationsPerLocation);
+    FParse::Value(*Params, TEXT("EyeBudget="), EyeBudgetInSeconds);
+    FParse::Value(*Params, TEXT("SeenSeconds="), SeenSeconds);
+    FParse::Value(*Params, TEXT("MissedSeconds="), MissedSeconds);
+    FParse::Value(*Params, TEXT("DefectRate="), DefectRate);
+    FParse::Value(*Params, TEXT("Age="), PatientAgeInYears);
+    FParse::Value(*Params, TEXT("Test="), TestName);
+    FString GridPath;
+    FParse::Value(*Params, TEXT("Grid="), GridPath);
+    FParse::Value(*Params, TEXT("Policy="), PolicyName);
+    FParse::Value(*Params, TEXT("Strategy="), StrategyName);
+    const bool bUseSpatialPriors = !FParse::Param(*Params, TEXT("NoSpatialPriors"));
+    const bool bMatchModel = FParse::Param(*Params, TEXT("MatchModel"));
+    const bool bUseAdaptiveGrid = FParse::Param(*Params, TEXT("AdaptiveGrid"));
+    const bool bUseEntropyStopping = FParse::Param(*Params, TEXT("EntropyStopping"));
+    const bool bScheduleByInformationRate = !FParse::Param(*Params, TEXT("NoInformationScheduling"));
+    const bool bSkipBlindSpotPoints = FParse::Param(*Params, TEXT("SkipBlindSpot"));
+    const bool bThresholdScreeningDefects = FParse::Param(*Params, TEXT("ThresholdDefects"));
+    NumEyes = FMath::Max(NumEyes, 1);
+
+    const ETestType TestType = TestName == TEXT("10-2") ? ETestType::TEST_10_2
+        : TestName == TEXT("24-2C") ? ETestType::TEST_24_2C
+        : TestName == TEXT("30-2") ? ETestType::TEST_30_2
+        : TestName == TEXT("Custom") ? ETestType::TEST_CUSTOM
+        : ETestType::TEST_24_2;
+    const EStimulusSelectionPolicy Policy = PolicyName == TEXT("Mean") ? EStimulusSelectionPolicy::PosteriorMean : EStimulusSelectionPolicy::MinimumExpectedEntropy;
+
+    FTestSettings TestSettings;
+    TestSettings.ThresholdStrategy = StrategyName == TEXT("FullThreshold") ? EThresholdStrategy::FullThreshold42
+        : StrategyName == TEXT("ZEST") ? EThresholdStrategy::Zest
+        : StrategyName == TEXT("SITAFast") ? EThresholdStrategy::SitaFast
+        : StrategyName == TEXT("Screening") ? EThresholdStrategy::SuprathresholdScreening
+        : EThresholdStrategy::Bayesian;
+
+    TArray<FSimulationObserver> Observers;
+    for (float Slope : ParseFloatList(Params, TEXT("Slope="), 3.0f))
+    {
+        for (float FalsePositiveRate : ParseFloatList(Params, TEXT("FP="), 0.03f))
+        {
+            for (float FalseNegativeRate : ParseFloatList(Params, TEXT("FN="), 0.03f))
+            {
+                Observers.Add({ Slope, FalsePositiveRate, FalseNegativeRate });
+            }
+        }
+    }
+
+    // The grid the headset runs, for the right eye
+    const FStimulusGridLayout& Layout = FStimulusGridLibrary::GetLayout(TestType, false, 100.0f, bSkipBlindSpotPoints, GridPath);
+    if (Layout.Num() == 0)
+    {
+        UE_LOG(LogPeriMapXRSimulation, Error, TEXT("PeriMapXR simulation: no stimulus grid for -Test=%s."), *TestName);
+        return 1;
+    }
+    const TArray<FVector>& Locations = Layout.Locations;
+    const TArray<FVector2D>& AngularPositions = Layout.AngularPositions;
+    const int32 NumLocations = Locations.Num();
+
+    // Estimators are UObjects, so they are created here on the game thread; each worker then owns one
+    const int32 NumWorkers = FMath::Clamp(FTaskGraphInterface::Get().GetNumWorkerThreads() + 1, 1, NumEyes);
+    Estimators.Reset();
+    for (int32 Worker = 0; Worker < NumWorkers; ++Worker)
+    {
+        UThresholdEstimator* Estimator = NewObject<UThresholdEstimator>(this);
+        Estimator->SelectionPolicy = Policy;
+        Estimator->bUseSpatialPriors = bUseSpatialPriors;
+        Estimator->bUseAdaptiveGrid = bUseAdaptiveGrid;
+        Estimator->bUseEntropyStopping = bUseEntropyStopping;
+        Estimator->bScheduleByInformationRate = bScheduleByInformationRate;
+        Estimator->SeenPresentationSeconds = SeenSeconds;
+        Estimator->MissedPresentationSeconds = MissedSeconds;
+        Estimator->EyeTimeBudgetInSeconds = EyeBudgetInSeconds;
+        Estimator->PatientAgeInYears = PatientAgeInYears;
+        Estimator->bThresholdScreeningDefects = bThresholdScreeningDefects;
+        Estimator->MaxPresentationsPerLocation = FMath::Max(MaxPresentationsPerLocation, 0);
+        Estimator->bEnablePosteriorTrace = false;
+        Estimators.Add(Estimator);
+    }
+
+    UE_LOG(LogPeriMapXRSimulation, Display, TEXT("PeriMapXR simulation: %d eyes x %d configurations, %s grid (%d locations), strategy %s, policy %s, spatial priors %s, adaptive grid %s, %d workers"),
+        NumEyes, Observers.Num(), *TestName, NumLocations, *StrategyName, *PolicyName, bUseSpatialPriors ? TEXT("on") : TEXT("off"), bUseAdaptiveGrid ? TEXT("on") : TEXT("off"), NumWorkers);
+
+    TArray<FSimulatedEyeResult> EyeResults;
+    TArray<float> Errors;
+    bool bScreeningCheckFailed = false;
+    for (const FSimulationObserver& Observer : Observers)
+    {
+        const FPsychometricParameters ObserverParams(Observer.Slope, Observer.FalsePositiveRate, Observer.FalseNegativeRate);
+        for (UThresholdEstimator* Estimator : Estimators)
+        {
+            if (bMatchModel)
+            {
+                Estimator->SetPsychometricParameters(Observer.Slope, FMath::Max(Observer.FalsePositiveRate, SimulationMinModelRate), FMath::Max(Observer.FalseNegativeRate, SimulationMinModelRate));
+            }
+        }
+
+        EyeResults.Reset();
+        EyeResults.SetNum(NumEyes);
+        Errors.SetNumZeroed(NumEyes * NumLocations);
+
+        const double StartSeconds = FPlatformTime::Seconds();
+        ParallelFor(NumWorkers, [&](int32 Worker)
+        {
+            UThresholdEstimator* Estimator = Estimators[Worker];
+            TArray<float> TrueThresholds;
+
+            for (int32 Eye = Worker; Eye < NumEyes; Eye += NumWorkers)
+            {
+                // Seeded per eye, so results do not depend on the number of workers
+                FRandomStream Stream(Seed * 7919 + Eye);
+                FSimulatedEyeResult& Result = EyeResults[Eye];
+                Result.bHasDefect = DrawTrueThresholds(AngularPositions, DefectRate, Stream, TrueThresholds);
+
+                Estimator->Initialize(TestSettings, TestType, true);
+                Estimator->RegisterLocations(Locations);
+
+                int32 LocationIndex = Estimator->GetNextLocationIndex(INDEX_NONE);
+                while (LocationIndex != INDEX_NONE && Result.Trials < MaxTrialsPerEye)
+                {
+                    const float StimulusIntensity = Estimator->GetNextStimulusIntensityInDbAtIndex(LocationIndex);
+                    const bool bSeen = Stream.FRand() < FPsychometricLikelihoodTable::Evaluate(ObserverParams, StimulusIntensity, TrueThresholds[LocationIndex]);
+                    Estimator->UpdateWithResponseAtIndex(LocationIndex, StimulusIntensity, bSeen);
+                    Result.Trials++;
+                    Result.TestSeconds += bSeen ? SeenSeconds : MissedSeconds;
+                    LocationIndex = Estimator->GetNextLocationIndex(LocationIndex);
+                }
+                Result.bFinished = LocationIndex == INDEX_NONE;
+
+                for (int32 i = 0; i < NumLocations; ++i)
+                {
+                    Errors[Eye * NumLocations + i] = Estimator->GetThresholdEstimateInDbAtIndex(i) - TrueThresholds[i];
+                    Result.StoppingRuleCounts[(int32)Estimator->GetStoppingRuleAtIndex(i)]++;
+                }
+            }
+        });
+        const double WallSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+        // Trials per eye, and how the locations ended
+        TArray<int32> Trials;
+        TArray<float> TestSeconds;
+        int64 TotalTrials = 0;
+        int32 UnfinishedEyes = 0;
+        int64 StoppingRuleCounts[(int32)EStoppingRule::ScreeningDefect + 1] = {};
+        int32 NumEyesByDefect[2] = { 0, 0 };
+        int32 NumFlaggedEyesByDefect[2] = { 0, 0 };
+        for (const FSimulatedEyeResult& Result : EyeResults)
+        {
+            NumEyesByDefect[Result.bHasDefect ? 1 : 0]++;
+            NumFlaggedEyesByDefect[Result.bHasDefect ? 1 : 0] += Result.StoppingRuleCounts[(int32)EStoppingRule::ScreeningDefect] > 0 ? 1 : 0;
+            Trials.Add(Result.Trials);
+            TestSeconds.Add(Result.TestSeconds);
+            TotalTrials += Result.Trials;
+            UnfinishedEyes += Result.bFinished ? 0 : 1;
+            for (int32 Rule = 0; Rule <= (int32)EStoppingRule::ScreeningDefect; ++Rule)
+            {
+                StoppingRuleCounts[Rule] += Result.StoppingRuleCounts[Rule];
+            }
+        }
+        Trials.Sort();
+        TestSeconds.Sort();
+        double TotalTestSeconds = 0.0;
+        for (float Seconds : TestSeconds)
+        {
+            TotalTestSeconds += Seconds;
+        }
+        const double MeanTrials = (double)TotalTrials / NumEyes;
+        double TrialsVariance = 0.0;
+        for (int32 TrialCount : Trials)
+        {
+            TrialsVariance += FMath::Square(TrialCount - MeanTrials);
+        }
+        TrialsVariance /= NumEyes;
+
+        // Error distribution over every location of every eye
+        double ErrorSum = 0.0;
+        double AbsoluteErrorSum = 0.0;
+        double SquaredErrorSum = 0.0;
+        int32 WithinCounts[3] = { 0, 0, 0 };
+        const float WithinLimitsInDb[3] = { 1.0f, 2.0f, 4.0f };
+        for (float Error : Errors)
+        {
+            ErrorSum += Error;
+            AbsoluteErrorSum += FMath::Abs(Error);
+            SquaredErrorSum += Error * Error;
+            for (int32 Limit = 0; Limit < 3; ++Limit)
+            {
+                WithinCounts[Limit] += FMath::Abs(Error) <= WithinLimitsInDb[Limit] ? 1 : 0;
+            }
+        }
+        Errors.Sort();
+        const double NumErrors = Errors.Num();
+
+        UE_LOG(LogPeriMapXRSimulation, Display, TEXT("Observer slope %.2f dB, false positives %.3f, false negatives %.3f"), Observer.Slope, Observer.FalsePositiveRate, Observer.FalseNegativeRate);
+        UE_LOG(LogPeriMapXRSimulation, Display, TEXT("  trials/eye: mean %.1f, sd %.1f, p5 %d, median %d, p95 %d, %d eyes hit the %d-trial cap"),
+            MeanTrials, FMath::Sqrt(TrialsVariance), GetPercentile(Trials, 0.05f), GetPercentile(Trials, 0.5f), GetPercentile(Trials, 0.95f), UnfinishedEyes, MaxTrialsPerEye);
+        UE_LOG(LogPeriMapXRSimulation, Display, TEXT("  test time/eye (seen %.2f s, missed %.2f s): mean %.1f s, p5 %.1f s, median %.1f s, p95 %.1f s"),
+            SeenSeconds, MissedSeconds, TotalTestSeconds / NumEyes, GetPercentile(TestSeconds, 0.05f), GetPercentile(TestSeconds, 0.5f), GetPercentile(TestSeconds, 0.95f));
+        UE_LOG(LogPeriMapXRSimulation, Display, TEXT("  error (estimate - true): mean %.2f dB, MAE %.2f dB, RMSE %.2f dB, p5 %.2f, median %.2f, p95 %.2f dB"),
+            ErrorSum / NumErrors, AbsoluteErrorSum / NumErrors, FMath::Sqrt(SquaredErrorSum / NumErrors),
+            GetPercentile(Errors, 0.05f), GetPercentile(Errors, 0.5f), GetPercentile(Errors, 0.95f));
+        UE_LOG(LogPeriMapXRSimulation, Display, TEXT("  |error| within 1 dB %.1f%%, 2 dB %.1f%%, 4 dB %.1f%%"),
+            100.0 * WithinCounts[0] / NumErrors, 100.0 * WithinCounts[1] / NumErrors, 100.0 * WithinCounts[2] / NumErrors);
+        const double NumEndedLocations = (double)NumEyes * NumLocations;
+        UE_LOG(LogPeriMapXRSimulation, Display, TEXT("  locations ended by: SD %.1f%%, entropy %.1f%%, staircase %.1f%%, presentation cap %.1f%%, time budget %.1f%%, still pending %.1f%%"),
+            100.0 * StoppingRuleCounts[(int32)EStoppingRule::StandardDeviation] / NumEndedLocations, 100.0 * StoppingRuleCounts[(int32)EStoppingRule::Entropy] / NumEndedLocations,
+            100.0 * StoppingRuleCounts[(int32)EStoppingRule::StaircaseReversals] / NumEndedLocations, 100.0 * StoppingRuleCounts[(int32)EStoppingRule::MaxPresentations] / NumEndedLocations,
+            100.0 * StoppingRuleCounts[(int32)EStoppingRule::TimeBudget] / NumEndedLocations, 100.0 * StoppingRuleCounts[(int32)EStoppingRule::None] / NumEndedLocations);
+        if (TestSettings.ThresholdStrategy == EThresholdStrategy::SuprathresholdScreening)
+        {
+            UE_LOG(LogPeriMapXRSimulation, Display, TEXT("  screening (age %.0f): passed %.1f%%, defects %.1f%%; eyes flagged: %d/%d with a defect, %d/%d without"), PatientAgeInYears,
+                100.0 * StoppingRuleCounts[(int32)EStoppingRule::ScreeningPassed] / NumEndedLocations, 100.0 * StoppingRuleCounts[(int32)EStoppingRule::ScreeningDefect] / NumEndedLocations,
+                NumFlaggedEyesByDefect[1], NumEyesByDefect[1], NumFlaggedEyesByDefect[0], NumEyesByDefect[0]);
+
+            // A screening that lets drawn defects pass is broken, whatever its other numbers say
+            if (NumEyesByDefect[1] > 0 && NumFlaggedEyesByDefect[1] < SimulationMinDefectEyesFlagged * NumEyesByDefect[1])
+            {
+                UE_LOG(LogPeriMapXRSimulation, Error, TEXT("  screening check failed: %d of %d eyes with a defect were flagged (at least %.0f%% expected)."),
+                    NumFlaggedEyesByDefect[1], NumEyesByDefect[1], SimulationMinDefectEyesFlagged * 100.0f);
+                bScreeningCheckFailed = true;
+            }
+        }
+        UE_LOG(LogPeriMapXRSimulation, Display, TEXT("  throughput: %.2f s wall clock, %.1f eyes/s, %.0f trials/s"),
+            WallSeconds, NumEyes / WallSeconds, TotalTrials / WallSeconds);
+    }
+
+    Estimators.Reset();
+    return bScreeningCheckFailed ? 1 : 0;
+}
@@ -0,0 +1,238 @@
+// UStimulusFieldComponent.cpp
+
+#include "UStimulusFieldComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Materials/Material.h"
+#include "Materials/MaterialInstanceDynamic.h"
+#include "Misc/PackageName.h"
+#include "UObject/ConstructorHelpers.h"
+
+// Sets up the sphere mesh and the instanced stimulus material
+UStimulusFieldComponent::UStimulusFieldComponent()
+{
+    // Initialize max luminance and brightness values
+    MaxLuminanceNits = 60.0f; // Max luminance of the Pico 4 in nits
+    MaxBrightness = 1.0f; // Max brightness for Unreal Engine material (0-1 range)
+
+    bEnableConsoleMessages = true;
+    bEnableOnScreenMessages = true;
+    bEnableSaveToLog = true;
+    NumVisibleStimuli = 0;
+    bUseInstancing = false;
+    StimulusMaterial = nullptr;
+
+    // Stimuli are only ever looked at: no collision, no shadows, nothing drawn until one is shown
+    SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    SetCastShadow(false);
+    SetVisibility(false);
+    NumCustomDataFloats = NumStimulusDataFloats;
+
+    // Find and assign the Sphere mesh
+    static ConstructorHelpers::FObjectFinder<UStaticMesh> SphereMeshAsset(TEXT("/Game/Mesh/Sphere.Sphere"));
+    if (SphereMeshAsset.Succeeded())
+    {
+        SetStaticMesh(SphereMeshAsset.Object);
+    }
+    else
+    {
+        LogMessage = "UStimulusFieldComponent::Failed to find mesh for stimuli.";
+        LogManager.LogMessage(LogMessage, ELogVerbosity::Error, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+    }
+
+    // Find and assign the M_StimuliInstanced material, which reads brightness and visibility from the custom data. Without it
+    // the default material would draw every instance at once at one brightness, so each stimulus gets its own M_Stimuli mesh instead
+    if (FPackageName::DoesPackageExist(TEXT("/Game/Material/M_StimuliInstanced")))
+    {
+        static ConstructorHelpers::FObjectFinder<UMaterial> InstancedMaterialAsset(TEXT("/Game/Material/M_StimuliInstanced.M_StimuliInstanced"));
+        if (InstancedMaterialAsset.Succeeded())
+        {
+            SetMaterial(0, InstancedMaterialAsset.Object);
+            bUseInstancing = true;
+            return;
+        }
+    }
+
+    static ConstructorHelpers::FObjectFinder<UMaterial> MaterialAsset(TEXT("/Game/Material/M_Stimuli.M_Stimuli"));
+    if (MaterialAsset.Succeeded())
+    {
+        StimulusMaterial = MaterialAsset.Object;
+        LogMessage = "UStimulusFieldComponent::M_StimuliInstanced not found; drawing one M_Stimuli mesh per stimulus.";
+        LogManager.LogMessage(LogMessage, ELogVerbosity::Log, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+    }
+    else
+    {
+        LogMessage = "UStimulusFieldComponent::Failed to find M_StimuliInstanced and M_Stimuli materials.";
+        LogManager.LogMessage(LogMessage, ELogVerbosity::Error, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+    }
+}
+
+// Sets the field to one hidden, dark stimulus per location, reusing the existing instances when the count matches
+void UStimulusFieldComponent::InitializeField(const TArray<FVector>& RelativeLocations, float DesiredDiameter)
+{
+    // Original diameter of UE sphere mesh is 100 units
+    const FVector InstanceScale(DesiredDiameter / 100.0f);
+
+    if (!bUseInstancing)
+    {
+        InitializeStimulusMeshes(RelativeLocations, InstanceScale);
+        return;
+    }
+
+    TArray<FTransform> InstanceTransforms;
+    InstanceTransforms.Reserve(RelativeLocations.Num());
+    for (const FVector& RelativeLocation : RelativeLocations)
+    {
+        InstanceTransforms.Add(FTransform(FQuat::Identity, RelativeLocation, InstanceScale));
+    }
+
+    if (GetInstanceCount() == RelativeLocations.Num())
+    {
+        // Same layout size: move the instances and clear their data in place
+        const float ClearedData[NumStimulusDataFloats] = { 0.0f, 0.0f };
+        BatchUpdateInstancesTransforms(0, InstanceTransforms, false, false, true);
+        for (int32 StimulusIndex = 0; StimulusIndex < RelativeLocations.Num(); ++StimulusIndex)
+        {
+            SetCustomData(StimulusIndex, MakeArrayView(ClearedData, NumStimulusDataFloats), false);
+        }
+        MarkRenderStateDirty();
+        SetVisibility(false);
+        NumVisibleStimuli = 0;
+    }
+    else
+    {
+        ClearField();
+        SetNumCustomDataFloats(NumStimulusDataFloats);
+        AddInstances(InstanceTransforms, false);
+    }
+
+    // Every instance starts with zeroed custom data: dark and hidden
+    VisibleStimuli.Init(false, RelativeLocations.Num());
+
+    LogMessage = FString::Printf(TEXT("UStimulusFieldComponent::Field initialized with %d stimuli."), RelativeLocations.Num());
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Log, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+}
+
+// Sets up one hidden, dark M_Stimuli mesh per location under the field, moving the existing ones and adding or removing the difference
+void UStimulusFieldComponent::InitializeStimulusMeshes(const TArray<FVector>& RelativeLocations, const FVector& Scale)
+{
+    while (StimulusMeshes.Num() > RelativeLocations.Num())
+    {
+        StimulusMeshes.Pop()->DestroyComponent();
+        StimulusMaterials.Pop();
+    }
+    while (StimulusMeshes.Num() < RelativeLocations.Num())
+    {
+        UStaticMeshComponent* StimulusMesh = NewObject<UStaticMeshComponent>(GetOwner() ? (UObject*)GetOwner() : (UObject*)this);
+        StimulusMesh->SetStaticMesh(GetStaticMesh());
+        StimulusMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+        StimulusMesh->SetCastShadow(false);
+        StimulusMesh->SetVisibility(false);
+        StimulusMesh->SetupAttachment(this);
+        UMaterialInstanceDynamic* Material = StimulusMaterial ? UMaterialInstanceDynamic::Create(StimulusMaterial, StimulusMesh) : nullptr;
+        StimulusMesh->SetMaterial(0, Material);
+        if (IsRegistered())
+        {
+            StimulusMesh->RegisterComponent();
+        }
+        StimulusMeshes.Add(StimulusMesh);
+        StimulusMaterials.Add(Material);
+    }
+
+    for (int32 StimulusIndex = 0; StimulusIndex < RelativeLocations.Num(); ++StimulusIndex)
+    {
+        StimulusMeshes[StimulusIndex]->SetRelativeTransform(FTransform(FQuat::Identity, RelativeLocations[StimulusIndex], Scale));
+        StimulusMeshes[StimulusIndex]->SetVisibility(false);
+        if (StimulusMaterials[StimulusIndex])
+        {
+            StimulusMaterials[StimulusIndex]->SetScalarParameterValue(TEXT("Brightness"), 0.0f);
+        }
+    }
+
+    VisibleStimuli.Init(false, RelativeLocations.Num());
+    NumVisibleStimuli = 0;
+
+    LogMessage = FString::Printf(TEXT("UStimulusFieldComponent::Field initialized with %d stimulus meshes."), RelativeLocations.Num());
+    LogManager.LogMessage(LogMessage, ELogVerbosity::Log, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+}
+
+// Removes every stimulus
+void UStimulusFieldComponent::ClearField()
+{
+    for (UStaticMeshComponent* StimulusMesh : StimulusMeshes)
+    {
+        StimulusMesh->DestroyComponent();
+    }
+    StimulusMeshes.Empty();
+    StimulusMaterials.Empty();
+    ClearInstances();
+    VisibleStimuli.Empty();
+    NumVisibleStimuli = 0;
+    SetVisibility(false);
+}
+
+// Sets the brightness of a stimulus from its intensity in decibels
+void UStimulusFieldComponent::SetBrightnessFromDb(int32 StimulusIndex, float dBValue)
+{
+    if (!VisibleStimuli.IsValidIndex(StimulusIndex))
+    {
+        LogMessage = FString::Printf(TEXT("UStimulusFieldComponent::No stimulus at index %d in SetBrightnessFromDb."), StimulusIndex);
+        LogManager.LogMessage(LogMessage, ELogVerbosity::Error, 5.0f, bEnableConsoleMessages, bEnableOnScreenMessages, bEnableSaveToLog);
+        return;
+    }
+
+    // Calculate luminance from dB value using the formula: Luminance = L_max * 10^(-dB/10)
+    float Luminance = MaxLuminanceNits * FMath::Pow(10.0f, -dBValue / 10.0f);
+
+    // Normalize luminance to the 0-1 range for material brightness (0 = black, MaxLuminanceNits = full brightness)
+    float BrightnessValue = FMath::Clamp(Luminance / MaxLuminanceNits, 0.0f, MaxBrightness);
+
+    if (!bUseInstancing)
+    {
+        if (StimulusMaterials[StimulusIndex])
+        {
+            StimulusMaterials[StimulusIndex]->SetScalarParameterValue(TEXT("Brightness"), BrightnessValue);
+        }
+        return;
+    }
+    SetCustomDataValue(StimulusIndex, BrightnessDataIndex, BrightnessValue, true);
+}
+
+// Shows or hides a stimulus; the component only draws while at least one stimulus is visible
+void UStimulusFieldComponent::SetStimulusVisibility(int32 StimulusIndex, bool bVisible)
+{
+    if (!VisibleStimuli.IsValidIndex(StimulusIndex) || VisibleStimuli[StimulusIndex] == bVisible)
+    {
+        return;
+    }
+
+    VisibleStimuli[StimulusIndex] = bVisible;
+    NumVisibleStimuli += bVisible ? 1 : -1;
+    if (!bUseInstancing)
+    {
+        StimulusMeshes[StimulusIndex]->SetVisibility(bVisible);
+        return;
+    }
+    SetCustomDataValue(StimulusIndex, VisibilityDataIndex, bVisible ? 1.0f : 0.0f, true);
+    SetVisibility(NumVisibleStimuli > 0);
+}
+
+// Hides every stimulus
+void UStimulusFieldComponent::HideAllStimuli()
+{
+    for (TConstSetBitIterator<> It(VisibleStimuli); It; ++It)
+    {
+        if (bUseInstancing)
+        {
+            SetCustomDataValue(It.GetIndex(), VisibilityDataIndex, 0.0f, false);
+        }
+        else
+        {
+            StimulusMeshes[It.GetIndex()]->SetVisibility(false);
+        }
+    }
+    VisibleStimuli.Init(false, VisibleStimuli.Num());
+    NumVisibleStimuli = 0;
+    MarkRenderStateDirty();
+    SetVisibility(false);
+}
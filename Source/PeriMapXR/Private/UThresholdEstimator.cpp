@@ -1,10 +1,10 @@
 // UThresholdEstimator.cpp
 
 #include "UThresholdEstimator.h"
+#include "FExpectedEntropySelector.h"
 #include "Math/UnrealMathUtility.h"
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
-#include <cmath>
 
 // Constructor
 UThresholdEstimator::UThresholdEstimator()
@@ -13,8 +13,63 @@ UThresholdEstimator::UThresholdEstimator()
     MinThresholdInDb = 0.0f;
     MaxThresholdInDb = 40.0f;
     ThresholdStepSizeInDb = 1.0f;
-    StoppingCriterionInDb = 1.0f; // Standard deviation threshold for stopping
     bIsLeftEye = true;
+
+    // Stopping rules: the standard deviation ends a location normally; the cap keeps a noisy responder from running on
+    StoppingCriterionInDb = 1.0f;
+    bUseEntropyStopping = false;
+    StoppingEntropyInNats = 1.2f;
+    MaxPresentationsPerLocation = 0;
+    EyeTimeBudgetInSeconds = 0.0f;
+    EyeElapsedSeconds = 0.0f;
+
+    // A presentation takes the 200 ms stimulus plus the 1 s gap whether it is seen or not, until ATestStimuli says otherwise
+    bScheduleByInformationRate = false;
+    SeenPresentationSeconds = 1.2f;
+    MissedPresentationSeconds = 1.2f;
+    NumPendingPrimarySeeds = 0;
+    TotalPresentations = 0;
+    CompletedPresentations = 0;
+    NumCompletedLocations = 0;
+    bOwnedByTaskGraph = false;
+
+    // Psychometric function parameters shared by every location
+    Slope = 3.0f;
+    GuessRate = 0.5f;
+    LapseRate = 0.01f;
+    IntensityBinSizeInDb = 0.1f;
+    SelectionPolicy = EStimulusSelectionPolicy::PosteriorMean;
+    ThresholdStrategy = EThresholdStrategy::Bayesian;
+
+    // Spatial prior defaults: the radius takes in the diagonal neighbours of a 6-degree grid
+    bUseSpatialPriors = false;
+    NeighbourRadiusInDeg = 8.5f;
+    NeighbourPriorWeight = 0.9f;
+    NeighbourPriorSpreadInDb = 2.0f;
+    PrimarySeedAngleInDeg = 9.0f;
+    bAdjacencyDirty = false;
+
+    // The adaptive grid keeps 21 levels per row: 0-40 dB in 2 dB steps, then a 5 dB window in 0.25 dB steps
+    bUseAdaptiveGrid = false;
+    CoarseThresholdStepSizeInDb = 2.0f;
+    FineThresholdStepSizeInDb = 0.25f;
+    GridRefinementDeviationInDb = 1.0f;
+
+    // Screening presents 6 dB brighter than an age-expected normal field, which falls away from fixation and with age
+    PatientAgeInYears = 50.0f;
+    ScreeningOffsetInDb = 6.0f;
+    NormalThresholdAtFixationInDb = 30.0f;
+    NormalThresholdEccentricitySlopeInDb = 0.1f;
+    NormalThresholdAgeSlopeInDb = 0.06f;
+    NormalReferenceAgeInYears = 20.0f;
+    bThresholdScreeningDefects = false;
+
+    // Off unless debugging; when on, room for a full two-eye test with spatial priors before the oldest records are overwritten
+    bEnablePosteriorTrace = false;
+    PosteriorTraceCapacity = 8192;
+
+    // Lay out the threshold grid so the Blueprint shim works before Initialize is called
+    PosteriorStore.Initialize(0, MinThresholdInDb, MaxThresholdInDb, ThresholdStepSizeInDb);
 }
 
 // Destructor
@@ -26,81 +81,285 @@ UThresholdEstimator::~UThresholdEstimator()
 // Initializes the estimator for a new test
 void UThresholdEstimator::Initialize(const FTestSettings& TestSettings, ETestType TestType, bool bLeftEye)
 {
-    bLeftEye = bIsLeftEye;
+    CheckGameThreadAccess();
+    bIsLeftEye = bLeftEye;
     CurrentTestSettings = TestSettings;
     CurrentTestType = TestType;
+    ThresholdStrategy = TestSettings.ThresholdStrategy;
 
     // Cleanup any existing estimators
     CleanupEstimators();
+    EyeElapsedSeconds = 0.0f;
 
     // Initialize estimation parameters if needed
     // MinThresholdInDb, MaxThresholdInDb, ThresholdStepSizeInDb can be set based on TestSettings or TestType
+    const float InitialStepSizeInDb = bUseAdaptiveGrid ? CoarseThresholdStepSizeInDb : ThresholdStepSizeInDb;
+    PosteriorStore.Initialize(0, MinThresholdInDb, MaxThresholdInDb, InitialStepSizeInDb);
+    EnsureLikelihoodTables();
+
+    // The trace spans both eyes, so it is only cleared when its layout changes
+    if (bEnablePosteriorTrace)
+    {
+        PosteriorTrace.Initialize(FMath::Max(PosteriorTraceCapacity, 1), PosteriorStore.GetNumLevels(), MinThresholdInDb, InitialStepSizeInDb);
+    }
+
+    IndexedLocations.Reserve(TestSettings.NumStimuli);
+    LocationIndices.Reserve(TestSettings.NumStimuli);
+}
+
+// Registers the stimulus locations in presentation order
+void UThresholdEstimator::RegisterLocations(const TArray<FVector>& Locations)
+{
+    CheckGameThreadAccess();
+    for (const FVector& Location : Locations)
+    {
+        GetOrAddLocationIndex(Location);
+    }
+
+    // The grid is fixed from here on, so the neighbour table is built once
+    BuildAdjacency();
+}
+
+// Gets the stimulus index for a location, or INDEX_NONE if it has not been registered
+int32 UThresholdEstimator::GetLocationIndex(const FVector& Location) const
+{
+    const int32* LocationIndex = LocationIndices.Find(Location);
+    return LocationIndex ? *LocationIndex : INDEX_NONE;
 }
 
-// Updates the estimator with a user's response at a location
+// Updates the estimator with a user's response at a location, registering it on its first response
 void UThresholdEstimator::UpdateWithResponse(const FVector& Location, float StimulusIntensity, bool bSeen)
 {
-    LocationEstimator* Estimator = GetOrCreateLocationEstimator(Location);
-    if (Estimator && !Estimator->bEstimationComplete)
+    // Registering a location grows every per-location array, which the task chain may be reading
+    CheckGameThreadAccess();
+    UpdateWithResponseAtIndex(GetOrAddLocationIndex(Location), StimulusIntensity, bSeen);
+}
+
+// Updates the estimator with a user's response at a stimulus index
+void UThresholdEstimator::UpdateWithResponseAtIndex(int32 LocationIndex, float StimulusIntensity, bool bSeen)
+{
+    if (!PosteriorStore.IsValidIndex(LocationIndex) || PosteriorStore.bEstimationComplete[LocationIndex])
+    {
+        return;
+    }
+
+    if (bAdjacencyDirty)
     {
-        // Debugging: Log the response details before updating the probability distribution
-        UE_LOG(LogTemp, Warning, TEXT("Updating probability distribution for location %s with intensity %f dB, Seen: %s"), *Location.ToString(), StimulusIntensity, bSeen ? TEXT("True") : TEXT("False"));
+        BuildAdjacency();
+    }
+
+    const FVector& Location = IndexedLocations[LocationIndex];
 
-        Estimator->UpdateProbabilityDistribution(StimulusIntensity, bSeen);
-        RecordStimulusResult(Location, bSeen, StimulusIntensity);
+    // The budget runs on test time: the window and gap each posted response takes, not pauses or frame rate
+    EyeElapsedSeconds += bSeen ? SeenPresentationSeconds : MissedPresentationSeconds;
 
-        if (bSeen)
+    // Per-response details go to the binary posterior trace rather than the log
+    UpdateProbabilityDistribution(LocationIndex, StimulusIntensity, bSeen);
+    RecordStimulusResult(Location, bSeen, StimulusIntensity);
+
+    if (bSeen)
+    {
+        PosteriorStore.ConsistentResponsesCount[LocationIndex]++;
+    }
+    else
+    {
+        PosteriorStore.ConsistentResponsesCount[LocationIndex] = 0;
+    }
+
+    UpdateAdaptiveGrid(LocationIndex);
+
+    // Let the strategy advance and apply its own rule, then the rules shared by every strategy
+    const FThresholdStrategyContext Context = MakeStrategyContext(LocationIndex);
+    EStoppingRule Rule = VisitThresholdStrategy(ThresholdStrategy, [&](auto Engine)
+    {
+        return decltype(Engine)::ApplyResponse(Context, StaircaseStates[LocationIndex], LocationIndex, StimulusIntensity, bSeen);
+    });
+    if (Rule == EStoppingRule::None && bUseEntropyStopping && Context.bOnFinalGrid && PosteriorStore.GetMoments(LocationIndex).Entropy <= StoppingEntropyInNats)
+    {
+        Rule = EStoppingRule::Entropy;
+    }
+    if (Rule == EStoppingRule::None && MaxPresentationsPerLocation > 0 && PosteriorStore.TrialCounts[LocationIndex] >= MaxPresentationsPerLocation)
+    {
+        Rule = EStoppingRule::MaxPresentations;
+    }
+
+    if (Rule != EStoppingRule::None)
+    {
+        CompleteLocation(LocationIndex, Rule);
+    }
+    else
+    {
+        RefreshInformationGain(LocationIndex);
+    }
+
+    // Out of time: every pending location completes with the estimate it has. Tested locations go first,
+    // so untested ones still get a prior from their neighbours when spatial priors are on. This pass runs once:
+    // afterwards no location is pending, so every later response returns before it
+    if (EyeTimeBudgetInSeconds > 0.0f && GetEyeElapsedSeconds() >= EyeTimeBudgetInSeconds)
+    {
+        for (const bool bTested : { true, false })
         {
-            Estimator->ConsistentResponsesCount++;
-            ConsistencyMap.FindOrAdd(Location)++;
+            for (int32 PendingIndex = 0; PendingIndex < PosteriorStore.GetNumLocations(); ++PendingIndex)
+            {
+                if (!PosteriorStore.bEstimationComplete[PendingIndex] && (PosteriorStore.TrialCounts[PendingIndex] > 0) == bTested)
+                {
+                    CompleteLocation(PendingIndex, EStoppingRule::TimeBudget);
+                }
+            }
         }
-        else
+    }
+}
+
+// Marks a stimulus index complete with the strategy's threshold estimate and the rule that ended it
+void UThresholdEstimator::CompleteLocation(int32 LocationIndex, EStoppingRule Rule)
+{
+    // This may run on the task chain, so the threshold stays with the index; the owner logs the completion and
+    // CalculateFinalThresholds collects the thresholds on the game thread
+    PosteriorStore.bEstimationComplete[LocationIndex] = true;
+    StoppingRules[LocationIndex] = Rule;
+    Scheduler.Remove(LocationIndex);
+    WaitingScheduler.Remove(LocationIndex);
+    GainScheduler.Remove(LocationIndex);
+    RecentlyCompletedIndices.Add(LocationIndex);
+
+    OnLocationComplete(LocationIndex);
+
+    // The last primary seed opens the frontier; a one-off pass over every location
+    if (bPrimarySeeds[LocationIndex] && --NumPendingPrimarySeeds == 0)
+    {
+        for (int32 PendingIndex = 0; PendingIndex < PosteriorStore.GetNumLocations(); ++PendingIndex)
         {
-            Estimator->ConsistentResponsesCount = 0;
-            ConsistencyMap.FindOrAdd(Location) = 0;
+            if (!PosteriorStore.bEstimationComplete[PendingIndex])
+            {
+                RefreshInformationGain(PendingIndex);
+            }
         }
+    }
+}
+
+// Gets the stimulus index to present after PreviousIndex, or INDEX_NONE once every location is complete
+int32 UThresholdEstimator::GetNextLocationIndex(int32 PreviousIndex) const
+{
+    const int32 NumLocations = PosteriorStore.GetNumLocations();
+    const int32 StartIndex = FMath::Max(PreviousIndex, INDEX_NONE);
 
-        if (Estimator->IsThresholdEstimationComplete(StoppingCriterionInDb))
+    // Short on time: spend what is left where it is expected to tell the most
+    if (IsEyeTimeBudgetTight())
+    {
+        const int32 MostInformativeIndex = GetMostInformativeLocationIndex();
+        if (MostInformativeIndex != INDEX_NONE)
         {
-            float EstimatedThresholdInDb = Estimator->GetThresholdEstimateInDb();
-            GetCurrentThresholdMap().Add(Location, EstimatedThresholdInDb); // Use GetCurrentThresholdMap() here
-            Estimator->bEstimationComplete = true;
+            return MostInformativeIndex;
+        }
+    }
 
-            // Debugging: Log when the threshold estimation is completed
-            UE_LOG(LogTemp, Warning, TEXT("Threshold estimation complete for location %s. Estimated threshold: %f dB"), *Location.ToString(), EstimatedThresholdInDb);
+    // Most information per second among the locations under test, from another quadrant than the last one;
+    // a waiting location from another quadrant comes forward when only the last quadrant has work under way
+    if (bScheduleByInformationRate && Scheduler.Num() > 0)
+    {
+        const int32 PreviousQuadrant = Scheduler.GetQuadrant(PreviousIndex);
+        int32 NextIndex = Scheduler.GetBestOutside(PreviousQuadrant);
+        if (NextIndex == INDEX_NONE)
+        {
+            NextIndex = WaitingScheduler.GetBestOutside(PreviousQuadrant);
         }
+        return NextIndex != INDEX_NONE ? NextIndex : Scheduler.GetBest(PreviousQuadrant);
     }
+
+    // Growth pattern: primary seeds until they are all complete, then locations with a completed neighbour or already under way
+    if (bUseSpatialPriors && bPrimarySeeds.Num() == NumLocations)
+    {
+        const bool bSeedsPending = NumPendingPrimarySeeds > 0;
+
+        for (int32 Offset = 1; Offset <= NumLocations; ++Offset)
+        {
+            const int32 Candidate = (StartIndex + Offset) % NumLocations;
+            if (PosteriorStore.bEstimationComplete[Candidate])
+            {
+                continue;
+            }
+
+            const bool bOnFrontier = bSeedsPending
+                ? bPrimarySeeds[Candidate]
+                : (PosteriorStore.TrialCounts[Candidate] > 0 || CompletedNeighbourCounts[Candidate] > 0);
+            if (bOnFrontier)
+            {
+                return Candidate;
+            }
+        }
+    }
+
+    // Any remaining location, in presentation order
+    for (int32 Offset = 1; Offset <= NumLocations; ++Offset)
+    {
+        const int32 Candidate = (StartIndex + Offset) % NumLocations;
+        if (!PosteriorStore.bEstimationComplete[Candidate])
+        {
+            return Candidate;
+        }
+    }
+    return INDEX_NONE;
+}
+
+// Checks if a stimulus index is one of the primary seed locations
+bool UThresholdEstimator::IsPrimarySeedAtIndex(int32 LocationIndex) const
+{
+    return bPrimarySeeds.IsValidIndex(LocationIndex) && bPrimarySeeds[LocationIndex];
+}
+
+// Gets the number of responses applied across every location of the current eye
+int32 UThresholdEstimator::GetTotalPresentations() const
+{
+    return TotalPresentations;
+}
+
+// Gets the next stimulus intensity for a location (in decibels); the middle of the range for an unregistered location
+float UThresholdEstimator::GetNextStimulusIntensityInDb(const FVector& Location) const
+{
+    CheckGameThreadAccess();
+    return GetNextStimulusIntensityInDbAtIndex(GetLocationIndex(Location));
 }
 
-// Gets the next stimulus intensity for a location (in decibels)
-float UThresholdEstimator::GetNextStimulusIntensityInDb(const FVector& Location)
+// Gets the next stimulus intensity for a stimulus index (in decibels)
+float UThresholdEstimator::GetNextStimulusIntensityInDbAtIndex(int32 LocationIndex) const
 {
-    LocationEstimator* Estimator = GetOrCreateLocationEstimator(Location);
-    if (Estimator)
+    if (PosteriorStore.IsValidIndex(LocationIndex))
     {
-        return Estimator->SelectNextStimulusIntensityInDb();
+        return SelectNextStimulusIntensityInDb(LocationIndex);
     }
     return (MaxThresholdInDb - MinThresholdInDb) / 2.0f;  // Return default if no estimator
 }
 
-// Gets the next luminance for a location (in nits)
-float UThresholdEstimator::GetNextLuminanceForLocation(const FVector& Location)
+// Gets the next luminance for a location (in nits); 0 for an unregistered location
+float UThresholdEstimator::GetNextLuminanceForLocation(const FVector& Location) const
+{
+    CheckGameThreadAccess();
+    return GetNextLuminanceAtIndex(GetLocationIndex(Location));
+}
+
+// Gets the next luminance for a stimulus index (in nits)
+float UThresholdEstimator::GetNextLuminanceAtIndex(int32 LocationIndex) const
 {
-    LocationEstimator* Estimator = GetOrCreateLocationEstimator(Location);
-    if (Estimator)
+    if (PosteriorStore.IsValidIndex(LocationIndex))
     {
-        return Estimator->SelectNextLuminance();
+        return ConvertDbToLuminance(SelectNextStimulusIntensityInDb(LocationIndex));
     }
     return 0.0f;  // Return 0 if no estimator
 }
 
-// Checks if threshold estimation is complete for a location
-bool UThresholdEstimator::IsThresholdEstimationComplete(const FVector& Location)
+// Checks if threshold estimation is complete for a location; an unregistered location has nothing left to test
+bool UThresholdEstimator::IsThresholdEstimationComplete(const FVector& Location) const
+{
+    CheckGameThreadAccess();
+    return IsThresholdEstimationCompleteAtIndex(GetLocationIndex(Location));
+}
+
+// Checks if threshold estimation is complete for a stimulus index
+bool UThresholdEstimator::IsThresholdEstimationCompleteAtIndex(int32 LocationIndex) const
 {
-    LocationEstimator* Estimator = GetOrCreateLocationEstimator(Location);
-    if (Estimator)
+    if (PosteriorStore.IsValidIndex(LocationIndex))
     {
-        return Estimator->bEstimationComplete;
+        return PosteriorStore.bEstimationComplete[LocationIndex];
     }
     return true;
 }
@@ -108,22 +367,178 @@ bool UThresholdEstimator::IsThresholdEstimationComplete(const FVector& Location)
 // Gets the estimated threshold for a location (in decibels)
 float UThresholdEstimator::GetThresholdEstimateInDb(const FVector& Location)
 {
-    if (GetCurrentThresholdMap().Contains(Location))
+    CheckGameThreadAccess();
+    const int32 LocationIndex = GetLocationIndex(Location);
+    if (PosteriorStore.IsValidIndex(LocationIndex) && PosteriorStore.bEstimationComplete[LocationIndex])
     {
-        return GetCurrentThresholdMap()[Location];
+        return GetThresholdEstimateInDbAtIndex(LocationIndex);
+    }
+    return 0.0f;
+}
+
+// Gets the current threshold estimate of the active strategy for a stimulus index (in decibels)
+float UThresholdEstimator::GetThresholdEstimateInDbAtIndex(int32 LocationIndex) const
+{
+    if (PosteriorStore.IsValidIndex(LocationIndex))
+    {
+        const FThresholdStrategyContext Context = MakeStrategyContext(LocationIndex);
+        return VisitThresholdStrategy(ThresholdStrategy, [&](auto Engine)
+        {
+            return decltype(Engine)::GetThresholdInDb(Context, StaircaseStates[LocationIndex], LocationIndex);
+        });
     }
     return 0.0f;
 }
 
-// Calculates final thresholds after the test is complete
+// Gets the rule that ended a location, or None while it is still being tested
+EStoppingRule UThresholdEstimator::GetStoppingRule(const FVector& Location) const
+{
+    CheckGameThreadAccess();
+    return GetStoppingRuleAtIndex(GetLocationIndex(Location));
+}
+
+// Gets the rule that ended a stimulus index, or None while it is still being tested
+EStoppingRule UThresholdEstimator::GetStoppingRuleAtIndex(int32 LocationIndex) const
+{
+    return StoppingRules.IsValidIndex(LocationIndex) ? StoppingRules[LocationIndex] : EStoppingRule::None;
+}
+
+// Gets the test time of the responses applied to the current eye (in seconds)
+float UThresholdEstimator::GetEyeElapsedSeconds() const
+{
+    return EyeElapsedSeconds;
+}
+
+// Checks whether the remaining time budget no longer covers the presentations the pending locations are expected to need
+bool UThresholdEstimator::IsEyeTimeBudgetTight() const
+{
+    if (EyeTimeBudgetInSeconds <= 0.0f)
+    {
+        return false;
+    }
+
+    if (TotalPresentations == 0)
+    {
+        return false;
+    }
+
+    // Remaining presentations at the pace so far, against what the pending locations need at the rate completed ones took:
+    // that share each, less what they have already had, and at least one each
+    const float ElapsedSeconds = GetEyeElapsedSeconds();
+    const float PresentationsLeft = (EyeTimeBudgetInSeconds - ElapsedSeconds) * TotalPresentations / FMath::Max(ElapsedSeconds, KINDA_SMALL_NUMBER);
+    const float PresentationsPerLocation = NumCompletedLocations > 0 ? (float)CompletedPresentations / NumCompletedLocations : 1.0f;
+    const int32 NumPendingLocations = PosteriorStore.GetNumLocations() - NumCompletedLocations;
+    const float PresentationsNeeded = FMath::Max(NumPendingLocations * PresentationsPerLocation - (TotalPresentations - CompletedPresentations), (float)NumPendingLocations);
+    return PresentationsNeeded > 0.0f && PresentationsLeft < PresentationsNeeded;
+}
+
+// Pending stimulus index whose next presentation has the highest expected information gain; a peek at the gain heaps
+int32 UThresholdEstimator::GetMostInformativeLocationIndex() const
+{
+    return GainScheduler.GetBest();
+}
+
+// Recomputes the cached information gain of a stimulus index's next presentation and its place in the schedule
+void UThresholdEstimator::RefreshInformationGain(int32 LocationIndex)
+{
+    const FPsychometricLikelihoodTable& Table = GetLikelihoodTableForLocation(LocationIndex);
+    if ((EyeTimeBudgetInSeconds <= 0.0f && !bScheduleByInformationRate) || !Table.IsBuilt())
+    {
+        return;
+    }
+
+    // Gain of the presentation the strategy would actually make there
+    const int32 Bin = Table.GetIntensityBin(SelectNextStimulusIntensityInDb(LocationIndex));
+    float ProbabilityOfSeeing = 0.0f;
+    InformationGains[LocationIndex] = FExpectedEntropySelector::GetExpectedInformationGain(PosteriorStore, Table, LocationIndex, Bin, &ProbabilityOfSeeing);
+    if (GainScheduler.GetQuadrant(LocationIndex) != INDEX_NONE)
+    {
+        if (PosteriorStore.bEstimationComplete[LocationIndex])
+        {
+            GainScheduler.Remove(LocationIndex);
+        }
+        else
+        {
+            GainScheduler.Update(LocationIndex, InformationGains[LocationIndex]);
+        }
+    }
+
+    if (!bScheduleByInformationRate || Scheduler.GetQuadrant(LocationIndex) == INDEX_NONE)
+    {
+        return;
+    }
+
+    const float ExpectedSeconds = ProbabilityOfSeeing * SeenPresentationSeconds + (1.0f - ProbabilityOfSeeing) * MissedPresentationSeconds;
+    const float InformationRate = InformationGains[LocationIndex] / FMath::Max(ExpectedSeconds, KINDA_SMALL_NUMBER);
+    if (IsSchedulable(LocationIndex))
+    {
+        WaitingScheduler.Remove(LocationIndex);
+        Scheduler.Update(LocationIndex, InformationRate);
+    }
+    else if (!PosteriorStore.bEstimationComplete[LocationIndex])
+    {
+        Scheduler.Remove(LocationIndex);
+        WaitingScheduler.Update(LocationIndex, InformationRate);
+    }
+    else
+    {
+        Scheduler.Remove(LocationIndex);
+        WaitingScheduler.Remove(LocationIndex);
+    }
+}
+
+// Whether a stimulus index belongs in the schedule
+bool UThresholdEstimator::IsSchedulable(int32 LocationIndex) const
+{
+    if (PosteriorStore.bEstimationComplete[LocationIndex])
+    {
+        return false;
+    }
+    if (!bUseSpatialPriors)
+    {
+        return true;
+    }
+    return NumPendingPrimarySeeds > 0
+        ? bPrimarySeeds[LocationIndex]
+        : (PosteriorStore.TrialCounts[LocationIndex] > 0 || CompletedNeighbourCounts[LocationIndex] > 0);
+}
+
+// Gets the cached posterior moments for a location
+FPosteriorMoments UThresholdEstimator::GetPosteriorMoments(const FVector& Location) const
+{
+    return GetPosteriorMomentsAtIndex(GetLocationIndex(Location));
+}
+
+// Gets the cached posterior moments for a stimulus index; a default summary if the index is unknown
+FPosteriorMoments UThresholdEstimator::GetPosteriorMomentsAtIndex(int32 LocationIndex) const
+{
+    CheckGameThreadAccess();
+    if (PosteriorStore.IsValidIndex(LocationIndex))
+    {
+        return PosteriorStore.GetMoments(LocationIndex);
+    }
+    return FPosteriorMoments();
+}
+
+// Collects the thresholds of the current eye's completed locations
 void UThresholdEstimator::CalculateFinalThresholds()
 {
-    // Thresholds are already calculated and stored in FinalThresholdsInDb
+    CheckGameThreadAccess();
+    TMap<FVector, float>& Thresholds = GetCurrentThresholdMap();
+    Thresholds.Reset();
+    for (int32 LocationIndex = 0; LocationIndex < PosteriorStore.GetNumLocations(); ++LocationIndex)
+    {
+        if (PosteriorStore.bEstimationComplete[LocationIndex])
+        {
+            Thresholds.Add(IndexedLocations[LocationIndex], GetThresholdEstimateInDbAtIndex(LocationIndex));
+        }
+    }
 }
 
 // Calculates sensitivities based on the final thresholds
 void UThresholdEstimator::CalculateFinalSensitivities()
 {
+    CheckGameThreadAccess();
     for (const auto& Pair : GetCurrentThresholdMap())
     {
         FVector Location = Pair.Key;
@@ -138,12 +553,14 @@ void UThresholdEstimator::CalculateFinalSensitivities()
 // Gets the final thresholds (in decibels)
 const TMap<FVector, float>& UThresholdEstimator::GetFinalThresholdsInDb() const
 {
+    CheckGameThreadAccess();
     return bIsLeftEye ? LeftEyeThresholds : RightEyeThresholds;
 }
 
 // Gets the final sensitivities
 const TMap<FVector, float>& UThresholdEstimator::GetFinalSensitivities() const
 {
+    CheckGameThreadAccess();
     return bIsLeftEye ? LeftEyeSensitivities : RightEyeSensitivities;
 }
 
@@ -152,36 +569,93 @@ void UThresholdEstimator::RecordStimulusResult(const FVector& Location, bool bSe
 {
     FTestResults NewResult(Location, bSeen, ThresholdLevel);
     TestResultsArray.Add(NewResult);
+}
 
-    UE_LOG(LogTemp, Warning, TEXT("Recorded result at location %s: %s at %f dB"), *Location.ToString(), bSeen ? TEXT("Seen") : TEXT("Not Seen"), ThresholdLevel);
+// Moves the stimulus indices completed since the last call into OutIndices
+void UThresholdEstimator::TakeCompletedLocationIndices(TArray<int32>& OutIndices)
+{
+    OutIndices.Append(RecentlyCompletedIndices);
+    RecentlyCompletedIndices.Reset();
+}
+
+// Asserts that the game thread is not reading or changing the estimator while the task chain owns it
+void UThresholdEstimator::CheckGameThreadAccess() const
+{
+    checkf(!(bOwnedByTaskGraph && IsInGameThread()), TEXT("UThresholdEstimator used on the game thread while FAsyncThresholdEstimator owns it; Flush first"));
 }
 
 // Checks if retesting can be skipped at a location
 bool UThresholdEstimator::ShouldSkipRetest(const FVector& Location)
 {
-    int32* ConsistencyCount = ConsistencyMap.Find(Location);
-    return ConsistencyCount && *ConsistencyCount >= 3;
+    CheckGameThreadAccess();
+    return ShouldSkipRetestAtIndex(GetLocationIndex(Location));
+}
+
+// Checks if retesting can be skipped at a stimulus index
+bool UThresholdEstimator::ShouldSkipRetestAtIndex(int32 LocationIndex) const
+{
+    return PosteriorStore.IsValidIndex(LocationIndex) && PosteriorStore.ConsistentResponsesCount[LocationIndex] >= 3;
+}
+
+// Sets the psychometric function parameters
+void UThresholdEstimator::SetPsychometricParameters(float InSlope, float InGuessRate, float InLapseRate)
+{
+    CheckGameThreadAccess();
+    Slope = InSlope;
+    GuessRate = InGuessRate;
+    LapseRate = InLapseRate;
+
+    // Rebuild now so the next selection already uses the new parameters
+    EnsureLikelihoodTables();
 }
 
-// Helper function to get or create a LocationEstimator for a location
-UThresholdEstimator::LocationEstimator* UThresholdEstimator::GetOrCreateLocationEstimator(const FVector& Location)
+// Helper function to get or register the stimulus index for a location
+int32 UThresholdEstimator::GetOrAddLocationIndex(const FVector& Location)
 {
-    if (!LocationEstimators.Contains(Location))
+    if (const int32* LocationIndex = LocationIndices.Find(Location))
     {
-        TUniquePtr<LocationEstimator> NewEstimator = MakeUnique<LocationEstimator>(this);
-        NewEstimator->Initialize();
-        LocationEstimators.Add(Location, MoveTemp(NewEstimator));
+        return *LocationIndex;
     }
-    return LocationEstimators[Location].Get();
+
+    const int32 NewIndex = PosteriorStore.AddLocation();
+    check(NewIndex == IndexedLocations.Num());
+    IndexedLocations.Add(Location);
+    LocationIndices.Add(Location, NewIndex);
+
+    // Keep the neighbour bookkeeping sized; the table itself is rebuilt before the next update
+    bPrimarySeeds.Add(false);
+    CompletedNeighbourCounts.Add(0);
+    StaircaseStates.AddDefaulted();
+    StoppingRules.Add(EStoppingRule::None);
+    InformationGains.Add(0.0f);
+    bAdjacencyDirty = true;
+    return NewIndex;
 }
 
 // Cleans up all location estimators
 void UThresholdEstimator::CleanupEstimators()
 {
-    LocationEstimators.Empty();
+    PosteriorStore.Reset();
+    LocationIndices.Empty();
+    IndexedLocations.Empty();
     FinalThresholdsInDb.Empty();
     TestResultsArray.Empty();
-    ConsistencyMap.Empty();
+    Adjacency.Reset();
+    bPrimarySeeds.Empty();
+    CompletedNeighbourCounts.Empty();
+    ScreeningIntensitiesInDb.Empty();
+    StaircaseStates.Empty();
+    StoppingRules.Empty();
+    RecentlyCompletedIndices.Empty();
+    InformationGains.Empty();
+    Scheduler.Reset();
+    WaitingScheduler.Reset();
+    GainScheduler.Reset();
+    NumPendingPrimarySeeds = 0;
+    TotalPresentations = 0;
+    CompletedPresentations = 0;
+    NumCompletedLocations = 0;
+    bAdjacencyDirty = false;
 }
 
 // Returns the current threshold map for the active eye
@@ -197,163 +671,279 @@ TMap<FVector, float>& UThresholdEstimator::GetCurrentSensitivityMap()
 }
 
 ///////////////////////////////////////////////////////////
-// Implementation of LocationEstimator inner class
+// Per-location Bayesian update over the dense posterior store
 
-// Constructor
-UThresholdEstimator::LocationEstimator::LocationEstimator(UThresholdEstimator* InParentEstimator)
-    : ParentEstimator(InParentEstimator)  // Set the pointer to the parent
+// Rebuilds the likelihood tables if the psychometric parameters or threshold grid have changed
+void UThresholdEstimator::EnsureLikelihoodTables()
 {
-    this->Slope = 3.0f;  // Use 'this->' to access non-static members
-    this->GuessRate = 0.5f;
-    this->LapseRate = 0.01f;
-    this->ConsistentResponsesCount = 0;
-    this->bEstimationComplete = false;
+    const FPsychometricParameters Params(Slope, GuessRate, LapseRate);
+    LikelihoodTable.EnsureBuilt(Params,
+        PosteriorStore.GetMinThresholdInDb(), PosteriorStore.GetThresholdStepSizeInDb(),
+        PosteriorStore.GetNumLevels(), PosteriorStore.GetStride(), IntensityBinSizeInDb);
+
+    // The fine table spans the whole range; the extra row width lets a window starting near the top read a full stride
+    if (bUseAdaptiveGrid)
+    {
+        const int32 FineNumLevels = FMath::FloorToInt((MaxThresholdInDb - MinThresholdInDb) / FineThresholdStepSizeInDb + KINDA_SMALL_NUMBER) + 1;
+        FineLikelihoodTable.EnsureBuilt(Params, MinThresholdInDb, FineThresholdStepSizeInDb,
+            FineNumLevels, Align(FineNumLevels, FThresholdPosteriorStore::RowAlignment) + PosteriorStore.GetStride(), IntensityBinSizeInDb);
+    }
 }
 
-// Destructor
-UThresholdEstimator::LocationEstimator::~LocationEstimator()
+// Likelihood table covering a stimulus index's current grid
+const FPsychometricLikelihoodTable& UThresholdEstimator::GetLikelihoodTableForLocation(int32 LocationIndex) const
 {
+    return PosteriorStore.IsRebinned(LocationIndex) ? FineLikelihoodTable : LikelihoodTable;
 }
 
-// Initializes the estimator for a location
-void UThresholdEstimator::LocationEstimator::Initialize()
+// Updates the probability distribution based on user response
+void UThresholdEstimator::UpdateProbabilityDistribution(int32 LocationIndex, float StimulusIntensity, bool bSeen)
 {
-    PossibleThresholdLevelsInDb.Empty();
-    ProbabilityDistribution.Empty();
+    EnsureLikelihoodTables();
+
+    // Log-likelihood of the response given each threshold level, looked up for the presented intensity on the location's grid
+    const FPsychometricLikelihoodTable& Table = GetLikelihoodTableForLocation(LocationIndex);
+    const float* LogLikelihood = Table.GetLogLikelihoodRow(StimulusIntensity, bSeen, Table.GetLevelOffset(PosteriorStore.GetLevelOriginInDb(LocationIndex)));
 
-    for (float Level = ParentEstimator->MinThresholdInDb; Level <= ParentEstimator->MaxThresholdInDb; Level += ParentEstimator->ThresholdStepSizeInDb)
+    // Update the log posterior; the store refreshes its cached moments in the same call
+    PosteriorStore.ApplyLogLikelihood(LocationIndex, LogLikelihood);
+    TotalPresentations++;
+
+    // Debugging: Record the updated posterior for offline analysis; a memcpy into the preallocated trace buffer
+    if (bEnablePosteriorTrace)
     {
-        PossibleThresholdLevelsInDb.Add(Level);
-        ProbabilityDistribution.Add(1.0f); // Uniform prior
+        PosteriorTrace.Record(LocationIndex, PosteriorStore.TrialCounts[LocationIndex], StimulusIntensity, bSeen, bIsLeftEye,
+            PosteriorStore.GetLevelOriginInDb(LocationIndex), PosteriorStore.GetLevelStepInDb(LocationIndex), PosteriorStore.GetLogPosterior(LocationIndex));
     }
+}
+
+// Re-bins a stimulus index onto the fine window once it has narrowed, or re-centres the window on a drifting mode
+void UThresholdEstimator::UpdateAdaptiveGrid(int32 LocationIndex)
+{
+    if (!bUseAdaptiveGrid)
+    {
+        return;
+    }
+
+    const FPosteriorMoments& Moments = PosteriorStore.GetMoments(LocationIndex);
+    const float WindowOriginInDb = GetFineWindowOriginInDb(Moments.ModeInDb);
 
-    NormalizeProbabilityDistribution();
+    if (!PosteriorStore.IsRebinned(LocationIndex))
+    {
+        if (Moments.StandardDeviationInDb <= GridRefinementDeviationInDb)
+        {
+            PosteriorStore.Rebin(LocationIndex, WindowOriginInDb, FineThresholdStepSizeInDb);
+        }
+        return;
+    }
+
+    // Follow the mode once it reaches the outer quarter of the window; the shift is whole levels, so only the new tail is extrapolated
+    const float OriginInDb = PosteriorStore.GetLevelOriginInDb(LocationIndex);
+    const float WindowInDb = (PosteriorStore.GetNumLevels() - 1) * FineThresholdStepSizeInDb;
+    const bool bNearEdge = Moments.ModeInDb - OriginInDb < 0.25f * WindowInDb || OriginInDb + WindowInDb - Moments.ModeInDb < 0.25f * WindowInDb;
+    if (bNearEdge && !FMath::IsNearlyEqual(WindowOriginInDb, OriginInDb))
+    {
+        PosteriorStore.Rebin(LocationIndex, WindowOriginInDb, FineThresholdStepSizeInDb);
+    }
 }
 
-// Normalizes the probability distribution
-void UThresholdEstimator::LocationEstimator::NormalizeProbabilityDistribution()
+// Origin of the fine window centred on a level (in decibels), aligned so the fine table rows stay SIMD-aligned
+float UThresholdEstimator::GetFineWindowOriginInDb(float CenterInDb) const
 {
-    float Sum = 0.0f;
+    const float AlignmentInDb = FThresholdPosteriorStore::RowAlignment * FineThresholdStepSizeInDb;
+    const float WindowInDb = (PosteriorStore.GetNumLevels() - 1) * FineThresholdStepSizeInDb;
+    const float OriginInDb = MinThresholdInDb + FMath::RoundToFloat((CenterInDb - 0.5f * WindowInDb - MinThresholdInDb) / AlignmentInDb) * AlignmentInDb;
 
-    // Accumulate sum of probabilities
-    for (float Prob : ProbabilityDistribution)
+    // Keep the window inside the range, on the last aligned origin that fits
+    const float MaxOriginInDb = MinThresholdInDb + FMath::FloorToFloat((MaxThresholdInDb - MinThresholdInDb - WindowInDb) / AlignmentInDb + KINDA_SMALL_NUMBER) * AlignmentInDb;
+    return FMath::Clamp(OriginInDb, MinThresholdInDb, FMath::Max(MaxOriginInDb, MinThresholdInDb));
+}
+
+// Writes the posterior trace to disk on a background thread
+bool UThresholdEstimator::DumpPosteriorTrace(const FString& FilePath) const
+{
+    CheckGameThreadAccess();
+    return PosteriorTrace.DumpAsync(FilePath);
+}
+
+///////////////////////////////////////////////////////////
+// Spatial priors seeded from completed neighbours
+
+// Rebuilds the neighbour table and primary seeds for the registered locations
+void UThresholdEstimator::BuildAdjacency()
+{
+    const int32 NumLocations = IndexedLocations.Num();
+    Adjacency.Build(IndexedLocations, NeighbourRadiusInDeg);
+    bAdjacencyDirty = false;
+
+    // Age-expected threshold less the screening margin, from each location's eccentricity; fewer decibels is brighter
+    const float AgeLossInDb = NormalThresholdAgeSlopeInDb * FMath::Max(PatientAgeInYears - NormalReferenceAgeInYears, 0.0f);
+    ScreeningIntensitiesInDb.SetNumUninitialized(NumLocations);
+    for (int32 LocationIndex = 0; LocationIndex < NumLocations; ++LocationIndex)
     {
-        Sum += Prob;
+        const float ExpectedThresholdInDb = NormalThresholdAtFixationInDb - NormalThresholdEccentricitySlopeInDb * Adjacency.GetAngularPosition(LocationIndex).Size() - AgeLossInDb;
+        ScreeningIntensitiesInDb[LocationIndex] = FMath::Clamp(ExpectedThresholdInDb - ScreeningOffsetInDb, MinThresholdInDb, MaxThresholdInDb);
     }
 
-    // Normalize if the sum is positive
-    if (Sum > 0.0f)
+    // One primary seed per quadrant, nearest to (+/-PrimarySeedAngleInDeg, +/-PrimarySeedAngleInDeg)
+    bPrimarySeeds.Init(false, NumLocations);
+    for (const float HorizontalSign : { -1.0f, 1.0f })
     {
-        const float InvSum = 1.0f / Sum;
-        for (float& Prob : ProbabilityDistribution)
+        for (const float VerticalSign : { -1.0f, 1.0f })
         {
-            Prob *= InvSum;
+            const int32 SeedIndex = Adjacency.FindNearestLocation(FVector2D(HorizontalSign, VerticalSign) * PrimarySeedAngleInDeg);
+            if (SeedIndex != INDEX_NONE)
+            {
+                bPrimarySeeds[SeedIndex] = true;
+            }
         }
     }
-    else
+
+    // Recount in case locations completed before a rebuild
+    CompletedNeighbourCounts.Init(0, NumLocations);
+    for (int32 LocationIndex = 0; LocationIndex < NumLocations; ++LocationIndex)
     {
-        // If all probabilities are zero, reset to a uniform distribution
-        const float UniformProb = 1.0f / ProbabilityDistribution.Num();
-        for (float& Prob : ProbabilityDistribution)
+        if (PosteriorStore.bEstimationComplete[LocationIndex])
         {
-            Prob = UniformProb;
+            for (const FLocationNeighbour& Neighbour : Adjacency.GetNeighbours(LocationIndex))
+            {
+                CompletedNeighbourCounts[Neighbour.Index]++;
+            }
         }
     }
+
+    // Lay out the schedule by quadrant and fill it with the locations under test
+    TArray<int32> Quadrants;
+    Quadrants.SetNumUninitialized(NumLocations);
+    NumPendingPrimarySeeds = 0;
+    for (int32 LocationIndex = 0; LocationIndex < NumLocations; ++LocationIndex)
+    {
+        Quadrants[LocationIndex] = FLocationScheduler::GetQuadrantOfAngularPosition(Adjacency.GetAngularPosition(LocationIndex));
+        NumPendingPrimarySeeds += bPrimarySeeds[LocationIndex] && !PosteriorStore.bEstimationComplete[LocationIndex] ? 1 : 0;
+    }
+    Scheduler.Initialize(Quadrants);
+    WaitingScheduler.Initialize(Quadrants);
+    GainScheduler.Initialize(Quadrants);
+    for (int32 LocationIndex = 0; LocationIndex < NumLocations; ++LocationIndex)
+    {
+        RefreshInformationGain(LocationIndex);
+    }
 }
 
-// Psychometric function (cumulative Gaussian)
-float UThresholdEstimator::LocationEstimator::PsychometricFunction(float StimulusIntensity, float ThresholdLevel)
+// Propagates a completed location to its neighbours, seeding the ones that have not been tested yet
+void UThresholdEstimator::OnLocationComplete(int32 LocationIndex)
 {
-    float Probability = GuessRate + (1.0f - GuessRate - LapseRate) * 0.5f * (1.0f + std::erf((StimulusIntensity - ThresholdLevel) / (Slope * FMath::Sqrt(2.0f))));
-    return Probability;
+    CompletedPresentations += PosteriorStore.TrialCounts[LocationIndex];
+    NumCompletedLocations++;
+
+    for (const FLocationNeighbour& Neighbour : Adjacency.GetNeighbours(LocationIndex))
+    {
+        CompletedNeighbourCounts[Neighbour.Index]++;
+
+        // A location keeps whatever prior it had once its first response is in
+        if (bUseSpatialPriors && !PosteriorStore.bEstimationComplete[Neighbour.Index] && PosteriorStore.TrialCounts[Neighbour.Index] == 0)
+        {
+            SeedPriorFromNeighbours(Neighbour.Index);
+        }
+        else if (bScheduleByInformationRate && !Scheduler.IsActive(Neighbour.Index) && !PosteriorStore.bEstimationComplete[Neighbour.Index])
+        {
+            // Now on the frontier
+            RefreshInformationGain(Neighbour.Index);
+        }
+    }
 }
 
-// Updates the probability distribution based on user response
-void UThresholdEstimator::LocationEstimator::UpdateProbabilityDistribution(float StimulusIntensity, bool bSeen)
+// Replaces an untested location's prior with one built from its completed neighbours
+void UThresholdEstimator::SeedPriorFromNeighbours(int32 LocationIndex)
 {
-    for (int32 i = 0; i < PossibleThresholdLevelsInDb.Num(); ++i)
+    // Distance-weighted mixture of the completed neighbours' posteriors, summarised by its mean and variance
+    float WeightSum = 0.0f;
+    float Mean = 0.0f;
+    float MeanSquare = 0.0f;
+    for (const FLocationNeighbour& Neighbour : Adjacency.GetNeighbours(LocationIndex))
     {
-        float ThresholdLevel = PossibleThresholdLevelsInDb[i];
-        float ProbabilityOfSeeing = PsychometricFunction(StimulusIntensity, ThresholdLevel);
+        if (!PosteriorStore.bEstimationComplete[Neighbour.Index])
+        {
+            continue;
+        }
 
-        // Likelihood of the response given the threshold level
-        float Likelihood = bSeen ? ProbabilityOfSeeing : (1.0f - ProbabilityOfSeeing);
+        const float Weight = 1.0f / FMath::Max(Neighbour.DistanceInDeg, 1.0f);
+        const FPosteriorMoments& NeighbourMoments = PosteriorStore.GetMoments(Neighbour.Index);
+        WeightSum += Weight;
+        Mean += Weight * NeighbourMoments.MeanInDb;
+        MeanSquare += Weight * (NeighbourMoments.Variance + NeighbourMoments.MeanInDb * NeighbourMoments.MeanInDb);
+    }
 
-        // Update the probability
-        ProbabilityDistribution[i] *= Likelihood;
+    if (WeightSum <= 0.0f)
+    {
+        return;
     }
 
-    // Normalize the updated probability distribution
-    NormalizeProbabilityDistribution();
+    Mean /= WeightSum;
+    MeanSquare /= WeightSum;
+    const float Spread = FMath::Max(NeighbourPriorSpreadInDb, KINDA_SMALL_NUMBER);
+    const float Variance = FMath::Max(MeanSquare - Mean * Mean, 0.0f) + Spread * Spread;
+
+    // Gaussian around the neighbours, mixed with a uniform floor so a defect next to normal field is still reachable
+    const int32 NumLevels = PosteriorStore.GetNumLevels();
+    TArray<float, TInlineAllocator<128>> Prior;
+    Prior.SetNumUninitialized(NumLevels);
 
-    // Debugging: Log the updated probability distribution for analysis
-    FString ProbabilityLog = "Updated Probability Distribution: ";
-    for (int32 i = 0; i < ProbabilityDistribution.Num(); ++i)
+    float GaussianSum = 0.0f;
+    for (int32 i = 0; i < NumLevels; ++i)
     {
-        ProbabilityLog += FString::Printf(TEXT("[%f dB: %f] "), PossibleThresholdLevelsInDb[i], ProbabilityDistribution[i]);
+        Prior[i] = FMath::Exp(-0.5f * FMath::Square(PosteriorStore.GetLevelInDb(LocationIndex, i) - Mean) / Variance);
+        GaussianSum += Prior[i];
     }
 
-    UE_LOG(LogTemp, Warning, TEXT("LocationEstimator - %s - Probability distribution after response: %s"), *ParentEstimator->GetName(), *ProbabilityLog);
+    const float Weight = FMath::Clamp(NeighbourPriorWeight, 0.0f, 1.0f);
+    const float UniformShare = (1.0f - Weight) / NumLevels;
+    for (int32 i = 0; i < NumLevels; ++i)
+    {
+        Prior[i] = Weight * Prior[i] / GaussianSum + UniformShare;
+    }
+
+    PosteriorStore.SetPrior(LocationIndex, Prior.GetData());
+    RefreshInformationGain(LocationIndex);
+
+    UE_LOG(LogTemp, Verbose, TEXT("Seeded prior for location %s from neighbours: mean %f dB, spread %f dB"), *IndexedLocations[LocationIndex].ToString(), Mean, FMath::Sqrt(Variance));
 }
 
+///////////////////////////////////////////////////////////
+// Stimulus selection
+
 // Selects the next stimulus intensity to present (in dB)
-float UThresholdEstimator::LocationEstimator::SelectNextStimulusIntensityInDb()
+float UThresholdEstimator::SelectNextStimulusIntensityInDb(int32 LocationIndex) const
 {
-    // Calculate the expected threshold (mean of the distribution)
-    float ExpectedThresholdInDb = 0.0f;
-    for (int32 i = 0; i < PossibleThresholdLevelsInDb.Num(); ++i)
+    const FThresholdStrategyContext Context = MakeStrategyContext(LocationIndex);
+    return VisitThresholdStrategy(ThresholdStrategy, [&](auto Engine)
     {
-        ExpectedThresholdInDb += PossibleThresholdLevelsInDb[i] * ProbabilityDistribution[i];
-    }
-
-    // Ensure the intensity is within the valid range
-    ExpectedThresholdInDb = FMath::Clamp(ExpectedThresholdInDb, PossibleThresholdLevelsInDb[0], PossibleThresholdLevelsInDb.Last());
-
-    return ExpectedThresholdInDb;
+        return decltype(Engine)::SelectIntensityInDb(Context, StaircaseStates[LocationIndex], LocationIndex);
+    });
 }
 
-// Selects the next luminance (in nits) based on the selected dB value
-float UThresholdEstimator::LocationEstimator::SelectNextLuminance()
+// What the strategy engines read for a stimulus index
+FThresholdStrategyContext UThresholdEstimator::MakeStrategyContext(int32 LocationIndex) const
 {
-    float SelectedThresholdInDb = SelectNextStimulusIntensityInDb();
-    return ConvertDbToLuminance(SelectedThresholdInDb);
+    // The likelihood tables are rebuilt in Initialize, SetPsychometricParameters and on every update;
+    // on the adaptive grid a location only counts as final once it is on the fine window
+    return FThresholdStrategyContext{
+        PosteriorStore,
+        GetLikelihoodTableForLocation(LocationIndex),
+        SelectionPolicy,
+        StoppingCriterionInDb,
+        !bUseAdaptiveGrid || PosteriorStore.IsRebinned(LocationIndex),
+        MinThresholdInDb,
+        MaxThresholdInDb,
+        ScreeningIntensitiesInDb.IsValidIndex(LocationIndex) ? ScreeningIntensitiesInDb[LocationIndex] : MaxThresholdInDb,
+        bThresholdScreeningDefects
+    };
 }
 
 // Helper function to convert dB to luminance (nits)
-float UThresholdEstimator::LocationEstimator::ConvertDbToLuminance(float dBValue)
+float UThresholdEstimator::ConvertDbToLuminance(float dBValue)
 {
     float MaxLuminanceInNits = 60.0f;  // Maximum luminance of the Pico 4 display
     float Luminance = MaxLuminanceInNits * FMath::Pow(10.0f, -dBValue / 10.0f);
     return Luminance;
 }
-
-// Checks if threshold estimation is complete for this location
-bool UThresholdEstimator::LocationEstimator::IsThresholdEstimationComplete(float StoppingCriterionValue)
-{
-    // Calculate the standard deviation of the probability distribution
-    float Mean = 0.0f;
-    float MeanSquare = 0.0f;
-    for (int32 i = 0; i < PossibleThresholdLevelsInDb.Num(); ++i)
-    {
-        float Level = PossibleThresholdLevelsInDb[i];
-        float Prob = ProbabilityDistribution[i];
-        Mean += Level * Prob;
-        MeanSquare += Level * Level * Prob;
-    }
-    float Variance = MeanSquare - Mean * Mean;
-    float StandardDeviation = FMath::Sqrt(FMath::Max(Variance, 0.0f));
-
-    // Check if standard deviation is below the stopping criterion
-    return StandardDeviation <= StoppingCriterionValue;
-}
-
-// Gets the estimated threshold for this location (in decibels)
-float UThresholdEstimator::LocationEstimator::GetThresholdEstimateInDb()
-{
-    float EstimatedThresholdInDb = 0.0f;
-    for (int32 i = 0; i < PossibleThresholdLevelsInDb.Num(); ++i)
-    {
-        EstimatedThresholdInDb += PossibleThresholdLevelsInDb[i] * ProbabilityDistribution[i];
-    }
-    return EstimatedThresholdInDb;
-}
@@ -20,9 +20,6 @@ protected:
 	virtual void BeginPlay() override;
 
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
 	// Function to set the scale of the background sphere
 	void SetScale(float Diameter);
 
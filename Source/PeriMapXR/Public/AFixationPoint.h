@@ -20,9 +20,6 @@ protected:
 	virtual void BeginPlay() override;
 
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
 	// Function to set the scale of the fixation point
 	void SetScale(float Radius);
 
@@ -30,8 +27,5 @@ private:
 	UPROPERTY(VisibleAnywhere)
 	UStaticMeshComponent* MeshComponent;
 
-	UPROPERTY(EditAnywhere)
-	float DistanceFromPlayer = 100.0f; // Distance in front of the player
-
 	UMaterialInstanceDynamic* DynamicMaterial;
 };
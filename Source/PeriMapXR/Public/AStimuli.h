@@ -21,9 +21,6 @@ protected:
     virtual void BeginPlay() override;
 
 public:
-    // Called every frame
-    virtual void Tick(float DeltaTime) override;
-
     // Function to set the scale of the visual stimulus
     void SetScale(float DesiredDiameter);
 
@@ -3,17 +3,25 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#if PERIMAPXR_WITH_PICO
 #include "PXR_MotionTracking.h"
+#endif
 #include "GameFramework/Actor.h"
 #include "ABackgroundSphere.h"
 #include "AFixationPoint.h"
-#include "AStimuli.h"
+#include "UStimulusFieldComponent.h"
 #include "ETestState.h"
 #include "ETestType.h"
 #include "FTestSettings.h"
-#include "FTestResults.h"
+#include "FStimulusPresentation.h"
+#include "FReliabilityIndices.h"
+#include "FReactionTimeDistribution.h"
+#include "ECatchTrialType.h"
+#include "FScriptedResponder.h"
+#include "FTrialJournal.h"
 #include "FLogManager.h"
 #include "UThresholdEstimator.h"
+#include "FAsyncThresholdEstimator.h"
 #include "ATestStimuli.generated.h"
 
 UCLASS()
@@ -21,22 +29,32 @@ class PERIMAPXR_API ATestStimuli : public AActor
 {
     GENERATED_BODY()
 
+    // Drives SetupTest and SwitchEye directly to check the scene is pooled (Private/Tests/ATestStimuliTests.cpp)
+    friend class FPeriMapXRTestStimuliPoolingTest;
+
 public:
     // Constructor that sets default values for properties, especially around eye-tracking and test setup
     ATestStimuli();
 
+    /** Posterior summary of a stimulus of the current eye as of the last trial taken from the estimation task, for a live operator display. */
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    FPosteriorMoments GetLivePosteriorMoments(int32 StimulusIndex) const;
+
 protected:
     // Called once when the actor is first initialized, used to start the test and configure settings
     virtual void BeginPlay() override;
 
-    // Called every frame to update actors like the fixation point
+    // Called every frame while a stimulus is on screen, to hide it after a whole number of frames
     virtual void Tick(float DeltaTime) override;
 
+    // Called when the actor is removed, used to wait for any estimation task still in flight
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
     // Setup and Initialization
     /** Initializes eye tracking settings and checks whether it's supported and active. */
     void InitializeEyeTracking();
 
-    /** Configures the test environment for a specific test type (e.g., 10-2 or 24-2). */
+    /** Configures the test environment for a specific test type (e.g., 10-2 or 24-2), spawning the scene on the first call and reusing it after. */
     void SetupTest(ETestType NewTestType);
 
     /** Starts the test by generating stimuli and beginning the presentation cycle. */
@@ -58,43 +76,99 @@ protected:
     /** Flashes a stimulus at a given index and records user interaction with the stimulus. */
     void FlashStimuli(int32 StimulusIndex, float StimulusIntensityInDb);
 
-    /** Update stimuli positions, used when the user moves their head position. */
-    void UpdateStimuliPositions();
+    /** Hides the stimulus on screen and records how long it was shown; bInterrupted when a pause cuts it short. */
+    void EndStimulusPresentation(bool bInterrupted);
+
+    /** Number of display frames a stimulus stays visible: StimuliDuration at RefreshRate, at least one. */
+    int32 GetStimulusFrames() const;
+
+    /** Test time one frame stands for: a display frame at RefreshRate, or HeadlessTimeDilation of them in a headless run. */
+    float GetFrameSeconds() const;
+
+    /** Takes RefreshRate from the HMD when it reports one; keeps the configured rate otherwise. */
+    void QueryRefreshRate();
+
+    /** Logs the on-screen duration statistics of the eye just tested. */
+    void ReportPresentationTiming();
 
-    /** Compares the current position of the fixation actor to the last stored position. */
-    bool FixationActorMoved() const;
+    /** Closes the response window of the current stimulus, posts the response and starts the gap before the next one. */
+    void HandleStimulusResponse();
 
-    /** Destroys any leftover stimuli actors and cleans up. */
+    /** Applies the prepared next trial's intensity to its hidden stimulus while the gap runs, so the flash only shows it. */
+    void PrepareNextStimulus();
+
+    /** Takes the trial the estimation task prepared and applies the location updates published with it; false while it is still being prepared. */
+    bool TakePreparedTrial(FPreparedTrial& OutTrial);
+
+    /** Logs how much time closing response windows on a press saved for the eye just tested, and the reaction times so far. */
+    void ReportResponsePipeline();
+
+    /** Response window for the next stimulus: ResponseWindowSeconds until enough reaction times are in, then their ResponseWindowPercentile plus ResponseWindowMarginSeconds. */
+    float GetResponseWindowSeconds() const;
+
+    /** Settings of the current test type, with the screening strategy swapped in when bScreeningMode is set. */
+    FTestSettings GetEyeTestSettings() const;
+
+    /** Hides the current eye's stimuli, keeping them in the stimulus field for reuse. */
     void CleanupStimuli();
 
     // Response and Data Management
 	/** Saves the test results to a file for later analysis and review. */
     void SaveResultsToFile();
 
-    /** Detects false positives during stimulus detection trials and adjusts the test accordingly. */
-    bool CheckForFalsePositives();
+    /** Journals a presentation once it is off screen and its outcome is final; does nothing if it already was. */
+    void TryJournalPresentation(int32 PresentationIndex);
+
+    /** Queues the journal record of a presentation, or of the empty gap of a false-positive catch trial. */
+    void AppendJournalRecord(const FStimulusPresentation& Presentation);
+
+    /** Decides whether the gap just started hosts a catch trial, and if so schedules it to open inside the gap. */
+    void ScheduleCatchTrial();
+
+    /** Opens a catch trial: a false-positive one shows nothing, a false-negative one flashes a bright stimulus at a location already seen. */
+    void OpenCatchTrial(ECatchTrialType CatchTrialType);
+
+    /** Scores the catch trial open in the gap that just ended and updates the reliability indices. */
+    void CloseCatchTrial();
+
+    /** Logs the reliability indices of the eye just tested. */
+    void ReportReliability();
 
     /** Tracks missed responses to identify attention lapses and adjust test timing if necessary. */
     void TrackAttentionLapses(bool bSeen);
 
-    /** Calculates the overall reliability of the user's responses by comparing seen stimuli to total stimuli. */
+    /** Calculates the overall reliability of the user's responses as the share of catch trials answered correctly. */
     float CalculateResponseReliability();
 
-    /** Determines whether a stimulus was detected by the user, combining gaze and input tracking. */
+    /** Determines whether a stimulus was detected by the user; fixation has already been checked on every frame of its flash. */
     bool WasStimulusDetected();
 
     /** Function to set a flag indicating the stimulus was detected. */
     void OnStimulusDetected();
 
     // Eye Tracking and Gaze Focus
-    /** Checks if the user's gaze is focused on the fixation point and manages test state accordingly. */
+    /** Checks if the user's gaze is focused on the fixation point and shows the converging lines while it is not. */
     bool CheckGazeFocus();
 
-    /** Adjusts the timing between stimuli based on the user's consistency in responding to stimuli. */
-    void AdjustTimingBasedOnResponses();
+    /** Whether a gaze direction in HMD space points at the fixation point, within FixationToleranceDegrees. */
+    bool IsGazeDirectionOnFixation(const FVector& GazeDirection) const;
+
+    /** Angle (in degrees) between a gaze direction in HMD space and the direction of the fixation point. */
+    float GetGazeErrorInDeg(const FVector& GazeDirection) const;
+
+    /** Reads the newest unsmoothed gaze sample of the tested eye into bOutOnFixation and its angle from the fixation point; false if there is no valid sample this frame. */
+    bool SampleGazeOnFixation(bool& bOutOnFixation, float& OutGazeErrorInDeg);
+
+    /** Discards the trial on screen after a loss of fixation: its response is never posted and its location is requeued. */
+    void InvalidateStimulusPresentation();
+
+    /** Discards the trial waiting for a response after a press sooner than MinResponseSeconds: it is not posted as seen and its location is requeued. */
+    void DiscardAnticipatoryResponse(float ReactionTimeSeconds);
 
+#if PERIMAPXR_WITH_PICO
     /** Function to add data to the buffer and keep it within the BufferSize limit. */
     void AddEyeTrackingDataToBuffer(const FPXREyeTrackingData& NewData);
+#endif
 
     /** Function to compute a smoothed gaze direction by averaging the buffered data. */
     FVector GetSmoothedGazeDirection();
@@ -115,19 +189,34 @@ protected:
     /** Converts polar coordinates (used for stimuli locations) into cartesian coordinates for actor placement. */
     FVector PolarToCartesian(float Radius, float VerticalAngle, float HorizontalAngle);
 
-	/** Monitors the latency between frames to detect performance spikes. */
+	/** Monitors the latency between frames to detect performance spikes; sampled once per trial. */
     void MonitorLatency();
 
+    // Headless Driver
+    /** Sets up a headless run: fixed, unthrottled frames at HeadlessTimeDilation, the scripted responder and the frame timing. */
+    void InitializeHeadlessDriver();
+
+    /** Has the scripted responder answer a stimulus just shown, or the empty gap of a false-positive catch trial (INDEX_NONE). */
+    void ScheduleScriptedResponse(int32 StimulusIndex, float StimulusIntensityInDb);
+
+    /** Logs the throughput and catch-trial rates of the headless run and asks the engine to exit, with status 1 if the rates are off. */
+    void FinishHeadlessRun();
+
     // Properties
 
+    // Head-Locked Rig
+    /** Root of the test, attached to the HMD camera; the fixation point, stimuli, converging lines and background hang off it and follow the head without ticking. */
+    UPROPERTY(VisibleAnywhere, Category = "References")
+    USceneComponent* StimulusRig;
+
     // Actor Class References
     /** Reference to the class of the player pawn, used to track the camera and player view. */
     UPROPERTY(EditAnywhere, Category = "References")
     TSubclassOf<AActor> PICOXRPawnClass;
 
-    /** The class of the stimuli actors to spawn at various positions around the player. */
-    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Stimuli")
-    TSubclassOf<AStimuli> StimuliActorClass;
+    /** Every stimulus of the current eye as an instance of one mesh on the head-locked rig, indexed like StimuliLocations. */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Stimuli")
+    UStimulusFieldComponent* StimulusField;
 
     /** The class of the fixation point actor that appears at a fixed distance from the player. */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Fixation")
@@ -148,15 +237,31 @@ protected:
     /** Indicates whether eye tracking is currently active, checked at runtime. */
     bool bIsEyeTrackingActive = false;
 
-    /** Holds the value of the HMD refresh rate to sync with eye tracking. */
+    /** Display refresh rate of the HMD (in Hz); stimuli are shown for a whole number of frames at this rate. Replaced by the rate the HMD reports at SetupTest. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Timing")
     float RefreshRate;
 
+    /** Relative difference between the measured frame time and the one RefreshRate implies above which the timing report warns. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Timing")
+    float RefreshRateTolerance;
+
+    /** Frame times summed over the frames stimuli of the current eye were on screen, and the frames counted. */
+    double MeasuredFrameSeconds;
+    int32 NumMeasuredFrames;
+
+#if PERIMAPXR_WITH_PICO
     /** Buffer for storing the last few frames of eye-tracking data. */
     TArray<FPXREyeTrackingData> EyeTrackingDataBuffer;
+#endif
 
 	/** Size of the buffer for storing eye-tracking data frames. */
     const int32 BufferSize = 5;
 
+    /** Angle (in degrees) between the gaze and the fixation point within which the user counts as fixating. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Eye Tracking")
+    float FixationToleranceDegrees;
+
+#if PERIMAPXR_WITH_PICO
     /** Array of supported eye tracking modes on the device, populated during initialization. */
     TArray<EPXREyeTrackingMode> SupportedModes;
 
@@ -168,6 +273,7 @@ protected:
 
     /** Configuration for retrieving eye tracking data, including whether to query position and orientation. */
     FPXREyeTrackingDataGetInfo GetInfo;
+#endif
 
     // Test Configuration
     /** The current test type (e.g., 10-2 or 24-2), which determines the stimuli arrangement and behavior. */
@@ -178,6 +284,26 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Test Settings")
     TMap<ETestType, FTestSettings> TestSettingsMap;
 
+    /** Grid file for TEST_CUSTOM: one "Horizontal,Vertical" point in degrees per line, right eye orientation. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Test Settings")
+    FString CustomGridPath;
+
+    /** Leaves out grid points that fall inside the tested eye's blind spot. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Test Settings")
+    bool bSkipBlindSpotPoints;
+
+    /** Screens the grid at age-expected suprathreshold intensities instead of thresholding it, re-testing only the misses. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Test Settings")
+    bool bScreeningMode;
+
+    /** Age of the patient (in years), which sets the screening intensities. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Test Settings", meta = (ClampMin = "0.0"))
+    float PatientAgeInYears;
+
+    /** In screening mode, thresholds the locations confirmed as defects before the eye ends. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Test Settings")
+    bool bThresholdScreeningDefects;
+
     // Timing and Randomization
     /** The duration (in seconds) that each stimulus is visible to the user. */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Timing")
@@ -187,6 +313,38 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Timing")
     float TimeBetweenStimuli;
 
+    /** How long (in seconds) after onset a press still counts as seeing the stimulus; never shorter than the stimulus itself. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Timing")
+    float ResponseWindowSeconds;
+
+    /** Whether a press closes the response window at once instead of waiting it out, starting the gap to the next stimulus. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Timing")
+    bool bAdvanceOnResponse;
+
+    /** Earliest time (in seconds) after onset a press counts as a response; an earlier one closes the window at this time and discards the trial as anticipatory. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Timing")
+    float MinResponseSeconds;
+
+    /** Whether the response window is fitted to the participant's reaction times once enough of them are in; ResponseWindowSeconds is then its upper bound. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Timing")
+    bool bAdaptResponseWindow;
+
+    /** Share (0-1) of the participant's reaction times the adapted response window waits out. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Timing")
+    float ResponseWindowPercentile;
+
+    /** Time (in seconds) the adapted response window waits past that percentile. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Timing")
+    float ResponseWindowMarginSeconds;
+
+    /** Shortest the adapted response window gets (in seconds). */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Timing")
+    float MinAdaptiveResponseWindowSeconds;
+
+    /** Reaction times needed before the response window is adapted. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Timing")
+    int32 MinReactionTimesForAdaptation;
+
     /** The number of times a stimulus may be retested if uncertainty is detected. */
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Randomization")
     int32 RetestCount;
@@ -195,6 +353,55 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Randomization")
     float RetestProbability;
 
+    // Reliability
+    /** Probability that a gap between stimuli hosts a false-positive catch trial. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reliability")
+    float FalsePositiveCatchProbability;
+
+    /** Probability that a gap between stimuli hosts a false-negative catch trial, once some location has been seen. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reliability")
+    float FalseNegativeCatchProbability;
+
+    /** How much brighter (in decibels) than the dimmest intensity seen at a location its false-negative catch stimulus is. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reliability")
+    float FalseNegativeCatchOffsetInDb;
+
+    /** Time (in seconds) from the start of a gap to its catch trial, so late presses for the previous stimulus do not count. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reliability")
+    float CatchTrialGuardSeconds;
+
+    /** False-positive rate above which the eye is flagged as unreliable. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reliability")
+    float MaxFalsePositiveRate;
+
+    /** False-negative rate above which the eye is flagged as unreliable. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reliability")
+    float MaxFalseNegativeRate;
+
+    /** Catch trials of a kind needed before its rate can flag the eye as unreliable. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reliability")
+    int32 MinCatchTrialsForReliability;
+
+    /** Whether an eye flagged as unreliable is ended at once instead of being run to the end. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Reliability")
+    bool bStopWhenUnreliable;
+
+    /** Reliability indices of the eye being tested, current after every catch trial. */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Reliability")
+    FReliabilityIndices Reliability;
+
+    // Results
+    /** Whether every presentation is appended to a binary journal as the test runs (ProjectDir/TrialJournal_<date>.bin). */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Results")
+    bool bEnableTrialJournal;
+
+    /** How often (in seconds) the journal's writer syncs to disk; a crash loses at most the trials of the last interval. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Results", meta = (ClampMin = "0.01"))
+    float TrialJournalSyncIntervalSeconds;
+
+    /** Per-trial journal, written and synced on its own thread. */
+    FTrialJournal TrialJournal;
+
     // Settings for message toggling
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug Settings")
     bool bEnableConsoleMessages;
@@ -212,11 +419,38 @@ protected:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Demo")
     bool bIsDemoMode;
 
+    // Headless Driver
+    /**
+     * Runs the test without a headset or a participant: a scripted responder presses and a synthetic gaze source fixates,
+     * and the throughput is logged once both eyes are done. Also set from the command line, e.g. on a build agent without a GPU:
+     *   UnrealEditor PeriMapXR.uproject <TestMap> -game -nullrhi -unattended -PeriMapXRHeadless [-HeadlessTimeDilation=10] [-HeadlessSeed=1]
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Headless")
+    bool bHeadlessDriver;
+
+    /** How many seconds of test time each second of the headless game clock stands for; -HeadlessTimeDilation= on the command line. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Headless", meta = (ClampMin = "1.0"))
+    float HeadlessTimeDilation;
+
+    /** Seed of the scripted responder, so a headless run can be repeated; -HeadlessSeed= on the command line. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Headless")
+    int32 HeadlessSeed;
+
+    /** Whether the engine exits once a headless run has tested both eyes. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Headless")
+    bool bExitAfterHeadlessRun;
+
+    /** Synthetic participant answering stimuli and providing gaze samples in a headless run. */
+    FScriptedResponder ScriptedResponder;
+
     // Threshold Levels for Eyes
     /** Threshold class pointer object for storing and managing threshold data. */
     UPROPERTY(BlueprintReadOnly)
     UThresholdEstimator* ThresholdEstimator = nullptr;
 
+    /** Runs the estimator on the task graph while a test is running and holds the prepared next trial. */
+    FAsyncThresholdEstimator AsyncEstimator;
+
     // Test State and Results
     /** Current state of the test (e.g., Idle, Running, or Paused). */
     ETestState TestState;
@@ -224,33 +458,97 @@ protected:
     /** Array of locations for each stimulus, stored in cartesian coordinates. */
     TArray<FVector> StimuliLocations;
 
-    /** Array of recorded results for each stimulus presentation. */
-    TArray<FTestResults> TestResultsArray;
-
-    /** Array of active stimuli actors, stored so they can be destroyed when necessary. */
-    TArray<AStimuli*> StimuliActors;
-
     /** Index of the currently active stimulus in the test sequence. */
     int32 CurrentStimulusIndex;
 
-    /** Count of how many times the user has provided consistent responses in a row. */
-    int32 ConsistentResponsesCount;
-
     /** Count of consecutive successful responses, used to adjust difficulty. */
     int32 ConsecutiveSuccessCount;
 
     /** Tracks the number of consistent responses for each stimulus location. */
     TMap<FVector, int32> ConsistencyMap;
 
-    /** Count of false positives detected during the test. */
-    int32 FalsePositiveCount;
-
     /** Count of consecutive missed responses, used to track attention lapses. */
     int32 ConsecutiveMisses;
 
     /** Boolean flag to track if the user has responded to a stimulus. */
     bool bUserResponded;
 
+    /** How each stimulus of the current eye was shown, in presentation order. */
+    UPROPERTY(BlueprintReadOnly, Category = "Timing")
+    TArray<FStimulusPresentation> StimulusPresentations;
+
+    /** Entry of StimulusPresentations for the stimulus on screen, or INDEX_NONE while none is. */
+    int32 ActivePresentationIndex;
+
+    /** Entry of StimulusPresentations for the test trial waiting for a response, which a press is timed against, or INDEX_NONE. */
+    int32 TrialPresentationIndex;
+
+    /** Reaction times of the participant's seen test trials, over both eyes; the response window is fitted to them. */
+    FReactionTimeDistribution ReactionTimes;
+
+    /** Intensity of the stimulus waiting for a response (in decibels). */
+    float CurrentStimulusIntensityInDb;
+
+    /** World time (in seconds) at which the stimulus waiting for a response was shown. */
+    double StimulusOnsetSeconds;
+
+    /** Response window of the stimulus waiting for a response (in seconds). */
+    float CurrentResponseWindowSeconds;
+
+    /** Stimulus whose intensity was applied ahead of its flash by PrepareNextStimulus, or INDEX_NONE. */
+    int32 PreparedStimulusIndex;
+
+    /** Intensity applied to the prepared stimulus (in decibels). */
+    float PreparedStimulusIntensityInDb;
+
+    // Catch Trials (current eye)
+    /** Catch trial open in the current gap, or None. */
+    ECatchTrialType ActiveCatchTrial;
+
+    /** Whether the participant pressed while the open catch trial was running. */
+    bool bCatchTrialResponded;
+
+    /** Stimulus flashed by the open false-negative catch trial, or INDEX_NONE. */
+    int32 CatchStimulusIndex;
+
+    /** Entry of StimulusPresentations for the open false-negative catch trial, or INDEX_NONE. */
+    int32 CatchPresentationIndex;
+
+    /** FPlatformTime::Cycles64() and game frame at which the open catch trial opened. */
+    int64 CatchTrialOpenCycles;
+    int64 CatchTrialOpenFrame;
+
+    /** Dimmest intensity (in decibels) seen at each stimulus, or a negative value where none has been seen yet. */
+    TArray<float> SeenIntensityInDb;
+
+    /** Stimuli seen at least once, the candidates for false-negative catch trials. */
+    TArray<int32> SeenStimulusIndices;
+
+    /** Posterior summary of each stimulus of the current eye, copied from the updates the estimation task publishes. */
+    TArray<FPosteriorMoments> LivePosteriorMoments;
+
+    // Response Pipeline Statistics (current eye)
+    /** Response windows closed so far, early or not. */
+    int32 NumResponseWindows;
+
+    /** Response windows closed early by a press. */
+    int32 NumEarlyResponseWindows;
+
+    /** Total time (in seconds) early closing saved against waiting out every window. */
+    double ResponseSecondsSaved;
+
+    /** Total time (in seconds) from onset to the close of windows that ended in a seen response. */
+    double SeenResponseWindowSeconds;
+
+    /** Response windows that ended in a seen response. */
+    int32 NumSeenResponseWindows;
+
+    /** Test trials discarded because fixation was lost during their flash. */
+    int32 NumInvalidatedTrials;
+
+    /** False-negative catch trials dropped because fixation was lost during their flash. */
+    int32 NumInvalidatedCatchTrials;
+
     // Actors for Fixation, Background Sphere, and Converging Lines
     /** Pointer to the fixation point actor, placed in front of the user to guide their gaze. */
     AFixationPoint* FixationActor;
@@ -261,6 +559,9 @@ protected:
     /** Pointer to the background sphere actor, which creates a visual environment for the test. */
     ABackgroundSphere* BackgroundSphereActor;
 
+    /** Live actors in the world after the first SetupTest of the session, or INDEX_NONE before it. */
+    int32 SessionActorCount;
+
     // Eye Tracking and Test Control Variables
     /** Boolean flag to indicate if the test is paused. */
     bool bIsTestPaused;
@@ -278,16 +579,38 @@ protected:
     /** Handle for managing the timer that handles the user's response to stimuli. */
     FTimerHandle StimulusResponseTimerHandle;
 
-    /** Handle for managing the timer that schedules the presentation of stimuli for false positives. */
+    /** Handle for managing the timer that opens the catch trial hosted by the current gap. */
     FTimerHandle CatchTrialTimerHandle;
 
+    /** Handle for the scripted responder's pending press in a headless run. */
+    FTimerHandle ScriptedPressTimerHandle;
+
+    // Headless Run Statistics (whole session)
+    /** Wall-clock and world time (in seconds) at the start of the headless run. */
+    double HeadlessStartWallSeconds;
+    double HeadlessStartWorldSeconds;
+
+    /** Game-thread time of every frame since the start of the headless run (in cycles), and the frames counted. */
+    uint64 HeadlessGameThreadCycles;
+    int32 HeadlessNumFrames;
+
+    /** Cycles64 at the start of the frame being timed, or 0 outside one. */
+    uint64 HeadlessFrameStartCycles;
+
+    /** Test trials answered in the session, both eyes. */
+    int32 NumSessionTrials;
+
+    /** Catch trials of both eyes, scored like Reliability; a headless run checks them against the scripted responder. */
+    FReliabilityIndices SessionReliability;
+
+    /** Frame delegates timing the game thread of a headless run. */
+    FDelegateHandle HeadlessBeginFrameHandle;
+    FDelegateHandle HeadlessEndFrameHandle;
+
 	// Utility Variables
     /** Stores the latency value, initialized to 0. */
     float DetectedLatency;
 
-    /** Stores the last known position of the FixationActor. */
-    FVector LastFixationPosition;
-
     /** Instance of FLogManager to call in this class, ensures ini */
     FLogManager LogManager;
 
@@ -0,0 +1,13 @@
+// ECatchTrialType.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+UENUM(BlueprintType)
+enum class ECatchTrialType : uint8
+{
+    None UMETA(DisplayName = "None"),
+    FalsePositive UMETA(DisplayName = "False Positive (No Stimulus)"),
+    FalseNegative UMETA(DisplayName = "False Negative (Bright Stimulus)")
+};
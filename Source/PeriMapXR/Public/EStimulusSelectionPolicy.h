@@ -0,0 +1,12 @@
+// EStimulusSelectionPolicy.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+UENUM(BlueprintType)
+enum class EStimulusSelectionPolicy : uint8
+{
+    PosteriorMean UMETA(DisplayName = "Posterior Mean"),
+    MinimumExpectedEntropy UMETA(DisplayName = "Minimum Expected Entropy")
+};
@@ -0,0 +1,18 @@
+// EStoppingRule.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+UENUM(BlueprintType)
+enum class EStoppingRule : uint8
+{
+    None UMETA(DisplayName = "None"),
+    StandardDeviation UMETA(DisplayName = "Posterior Standard Deviation"),
+    Entropy UMETA(DisplayName = "Posterior Entropy"),
+    StaircaseReversals UMETA(DisplayName = "Staircase Reversals"),
+    MaxPresentations UMETA(DisplayName = "Maximum Presentations"),
+    TimeBudget UMETA(DisplayName = "Eye Time Budget"),
+    ScreeningPassed UMETA(DisplayName = "Screening Passed"),
+    ScreeningDefect UMETA(DisplayName = "Screening Defect")
+};
@@ -7,5 +7,8 @@
 UENUM(BlueprintType)
 enum class ETestType : uint8 {
     TEST_10_2 UMETA(DisplayName = "10-2 Test"),
-    TEST_24_2 UMETA(DisplayName = "24-2 Test")
+    TEST_24_2 UMETA(DisplayName = "24-2 Test"),
+    TEST_24_2C UMETA(DisplayName = "24-2C Test"),
+    TEST_30_2 UMETA(DisplayName = "30-2 Test"),
+    TEST_CUSTOM UMETA(DisplayName = "Custom Grid")
 };
\ No newline at end of file
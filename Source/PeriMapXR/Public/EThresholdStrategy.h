@@ -0,0 +1,15 @@
+// EThresholdStrategy.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+UENUM(BlueprintType)
+enum class EThresholdStrategy : uint8
+{
+    Bayesian UMETA(DisplayName = "Bayesian"),
+    FullThreshold42 UMETA(DisplayName = "Full Threshold 4-2 Staircase"),
+    Zest UMETA(DisplayName = "ZEST"),
+    SitaFast UMETA(DisplayName = "SITA-like Fast"),
+    SuprathresholdScreening UMETA(DisplayName = "Suprathreshold Screening")
+};
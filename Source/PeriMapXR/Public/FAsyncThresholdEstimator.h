@@ -0,0 +1,114 @@
+// FAsyncThresholdEstimator.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "FPosteriorMoments.h"
+#include "EStoppingRule.h"
+
+class UThresholdEstimator;
+
+/**
+ * A location whose posterior changed on the task chain, published for the game thread to display and log.
+ */
+struct FLocationUpdate
+{
+    // Stimulus index of the location
+    int32 LocationIndex;
+
+    // Its posterior summary after the update
+    FPosteriorMoments Moments;
+
+    // Rule that ended the location, or None while it is still being tested
+    EStoppingRule StoppingRule;
+
+    // Threshold the location completed with (in decibels); only meaningful once StoppingRule is set
+    float ThresholdInDb;
+
+    FLocationUpdate()
+        : LocationIndex(INDEX_NONE), StoppingRule(EStoppingRule::None), ThresholdInDb(0.0f) {}
+};
+
+/**
+ * The trial the game thread presents next, prepared ahead of time by the estimation task.
+ */
+struct FPreparedTrial
+{
+    // Stimulus index to present, or INDEX_NONE once every location of the current eye is complete
+    int32 LocationIndex;
+
+    // Intensity to present at that location (in decibels)
+    float StimulusIntensityInDb;
+
+    // Responses the estimator had applied for the current eye when the trial was prepared
+    int32 ResponsesApplied;
+
+    // Locations updated since the game thread last took a trial: the one responded to and any that completed with it
+    TArray<FLocationUpdate> LocationUpdates;
+
+    FPreparedTrial()
+        : LocationIndex(INDEX_NONE), StimulusIntensityInDb(0.0f), ResponsesApplied(0) {}
+};
+
+/**
+ * Runs UThresholdEstimator off the game thread. Each response is posted to a task-graph task that
+ * applies it and prepares the next trial (location and intensity), so by the time the next stimulus
+ * is due the game thread only copies a ready-made FPreparedTrial.
+ *
+ * Ownership rules:
+ *  - Only the game thread calls into this class.
+ *  - Between Begin and Flush the estimator belongs to the task chain; the game thread must not call
+ *    any of its functions in that span. It reads the prepared trial, which the tasks only write.
+ *  - Tasks only call the estimator's index-based update and query functions. They never create,
+ *    destroy or look up UObjects, touch actors or the world, change UPROPERTY values or log. What the
+ *    game thread shows or logs about a response (posterior moments, completed locations) is published
+ *    in the prepared trial's LocationUpdates.
+ *  - The owner keeps the estimator alive through a UPROPERTY reference, and calls Flush before using
+ *    the estimator directly (initializing the next eye, reading results, saving) and in EndPlay.
+ *  - Tasks are chained on the previous one, so responses are applied in the order they were posted.
+ */
+class PERIMAPXR_API FAsyncThresholdEstimator
+{
+public:
+    FAsyncThresholdEstimator();
+    ~FAsyncThresholdEstimator();
+
+    // Hands an initialized estimator to the task chain and starts preparing the first trial
+    void Begin(UThresholdEstimator* InEstimator);
+
+    // Posts the response to the trial just presented; the next trial is prepared from the updated posterior
+    void PostResponse(int32 LocationIndex, float StimulusIntensityInDb, bool bSeen);
+
+    // Puts back a trial that was thrown away without a response; the next trial is prepared from the unchanged posterior
+    void RequeueTrial(int32 LocationIndex);
+
+    // Whether every posted task has finished, so the prepared trial can be read
+    bool IsTrialReady() const;
+
+    // Copies the prepared trial into OutTrial and hands over its location updates, so each is taken once;
+    // false while it is still being prepared
+    bool TryGetNextTrial(FPreparedTrial& OutTrial);
+
+    // Waits for every posted task and returns the estimator to the game thread
+    void Flush();
+
+    // Whether the estimator currently belongs to the task chain
+    bool IsActive() const { return Estimator != nullptr; }
+
+private:
+    // Queues Work after the previous task on a background worker
+    void Dispatch(TUniqueFunction<void()>&& Work);
+
+    // Prepares the trial that follows PreviousIndex, publishing UpdatedIndex and the locations completed with it; runs on a worker thread
+    void PrepareTrial(int32 PreviousIndex, int32 UpdatedIndex);
+
+    // Estimator handed over by Begin, or null while the game thread owns it
+    UThresholdEstimator* Estimator;
+
+    // Completion event of the last task posted
+    FGraphEventRef LastTask;
+
+    // Written by the task chain; the game thread reads it only after LastTask has completed
+    FPreparedTrial PreparedTrial;
+};
@@ -0,0 +1,38 @@
+// FExpectedEntropySelector.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class FThresholdPosteriorStore;
+class FPsychometricLikelihoodTable;
+
+/**
+ * QUEST+/ZEST-style stimulus selection: for every candidate intensity on the threshold grid, the
+ * expected entropy of the posterior after a seen or not-seen response is evaluated and the candidate
+ * with the lowest value is presented.
+ *
+ * Expected posterior entropy equals the current entropy minus the mutual information between the
+ * threshold and the response, H(p(seen)) - sum_i p_i * h_i, where h_i is the response entropy at
+ * level i read from the likelihood table. Each candidate therefore costs two dot products over the
+ * posterior and no logarithms beyond one per candidate.
+ *
+ * Candidates are the levels of the location's own grid, and the table must cover that grid: the
+ * coarse table for a location on the initial grid, the fine table once it has been re-binned.
+ */
+class PERIMAPXR_API FExpectedEntropySelector
+{
+public:
+    // Candidate intensity (in dB) that minimizes the expected posterior entropy at a location
+    static float SelectIntensityInDb(const FThresholdPosteriorStore& Store, const FPsychometricLikelihoodTable& Table, int32 LocationIndex);
+
+    // Expected posterior entropy (in nats, on the store's EntropyStepInDb bins) at a location after presenting the stimulus in the given intensity bin
+    static float GetExpectedEntropy(const FThresholdPosteriorStore& Store, const FPsychometricLikelihoodTable& Table, int32 LocationIndex, int32 Bin);
+
+    // Expected information gain (in nats) at a location from presenting the stimulus in the given intensity bin; optionally also the probability it is seen
+    static float GetExpectedInformationGain(const FThresholdPosteriorStore& Store, const FPsychometricLikelihoodTable& Table, int32 LocationIndex, int32 Bin, float* OutProbabilityOfSeeing = nullptr);
+
+private:
+    // Mutual information between threshold and response for one bin, given a normalized posterior starting at LevelOffset in the table
+    static float GetInformationGain(const float* Posterior, int32 NumLevels, const FPsychometricLikelihoodTable& Table, int32 Bin, int32 LevelOffset, float* OutProbabilityOfSeeing = nullptr);
+};
@@ -0,0 +1,66 @@
+// FLocationAdjacency.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * One entry in a location's neighbour list.
+ */
+struct FLocationNeighbour
+{
+    // Stimulus index of the neighbour
+    int32 Index;
+
+    // Angular separation from the owning location (in degrees)
+    float DistanceInDeg;
+};
+
+/**
+ * Precomputed neighbour table for a stimulus grid. Built once per grid from the stimulus
+ * locations: every location gets the list of other locations within an angular radius, stored
+ * back to back so a lookup is a contiguous slice. Also caches each location's angular position
+ * (horizontal, vertical, in degrees) as laid out by ATestStimuli::PolarToCartesian.
+ */
+class PERIMAPXR_API FLocationAdjacency
+{
+public:
+    FLocationAdjacency();
+
+    // Rebuilds the table for the given stimulus locations (relative to the fixation point)
+    void Build(const TArray<FVector>& Locations, float InNeighbourRadiusInDeg);
+
+    // Drops every location
+    void Reset();
+
+    // Neighbours of a location within the build radius, nearest first
+    TArrayView<const FLocationNeighbour> GetNeighbours(int32 LocationIndex) const
+    {
+        return TArrayView<const FLocationNeighbour>(Neighbours.GetData() + NeighbourOffsets[LocationIndex], NeighbourOffsets[LocationIndex + 1] - NeighbourOffsets[LocationIndex]);
+    }
+
+    // Angular position of a location: X is horizontal, Y is vertical (in degrees)
+    const FVector2D& GetAngularPosition(int32 LocationIndex) const { return AngularPositions[LocationIndex]; }
+
+    // Index of the location nearest to an angular position, or INDEX_NONE if the table is empty
+    int32 FindNearestLocation(const FVector2D& AngularPositionInDeg) const;
+
+    int32 GetNumLocations() const { return AngularPositions.Num(); }
+    float GetNeighbourRadiusInDeg() const { return NeighbourRadiusInDeg; }
+
+    // Angular separation between two stimulus locations (in degrees)
+    static float GetAngularDistanceInDeg(const FVector& LocationA, const FVector& LocationB);
+
+    // Angular position (horizontal, vertical, in degrees) of a stimulus location
+    static FVector2D ToAngularPosition(const FVector& Location);
+
+private:
+    float NeighbourRadiusInDeg;
+
+    // Cached angular position of every location
+    TArray<FVector2D> AngularPositions;
+
+    // Neighbours of location i are Neighbours[NeighbourOffsets[i] .. NeighbourOffsets[i + 1])
+    TArray<int32> NeighbourOffsets;
+    TArray<FLocationNeighbour> Neighbours;
+};
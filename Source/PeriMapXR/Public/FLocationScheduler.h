@@ -0,0 +1,76 @@
+// FLocationScheduler.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Priority queue over the locations that are currently being tested, keyed by expected information
+ * gain per second of test time. There is one indexed binary max-heap per visual field quadrant, so:
+ *
+ *  - adding, re-keying or removing a location is O(log n);
+ *  - the next location is the best top among the quadrants other than the one just presented, an
+ *    O(1) peek, so the same quadrant is never presented twice in a row while another has work left.
+ *
+ * Locations are addressed by stimulus index. The scheduler does not own the priorities' meaning;
+ * UThresholdEstimator refreshes a location's key whenever its posterior changes.
+ */
+class PERIMAPXR_API FLocationScheduler
+{
+public:
+    static constexpr int32 NumQuadrants = 4;
+
+    FLocationScheduler();
+
+    // Sizes the scheduler for the given quadrant of each stimulus index; every location starts inactive
+    void Initialize(const TArray<int32>& InQuadrants);
+
+    // Drops every location
+    void Reset();
+
+    // Activates a location or changes its priority
+    void Update(int32 LocationIndex, float Priority);
+
+    // Deactivates a location; does nothing if it is not active
+    void Remove(int32 LocationIndex);
+
+    // Highest-priority active location outside ExcludedQuadrant; from ExcludedQuadrant only if no other quadrant has one. INDEX_NONE if empty
+    int32 GetBest(int32 ExcludedQuadrant = INDEX_NONE) const;
+
+    // Highest-priority active location outside ExcludedQuadrant, or INDEX_NONE if every active location is in it
+    int32 GetBestOutside(int32 ExcludedQuadrant) const;
+
+    bool IsActive(int32 LocationIndex) const { return HeapPositions.IsValidIndex(LocationIndex) && HeapPositions[LocationIndex] != INDEX_NONE; }
+    int32 GetQuadrant(int32 LocationIndex) const { return Quadrants.IsValidIndex(LocationIndex) ? Quadrants[LocationIndex] : INDEX_NONE; }
+    int32 Num() const { return NumActive; }
+
+    // Quadrant of an angular position: bit 0 set on the right (X >= 0), bit 1 set in the upper field (Y >= 0)
+    static int32 GetQuadrantOfAngularPosition(const FVector2D& AngularPositionInDeg)
+    {
+        return (AngularPositionInDeg.X >= 0.0f ? 1 : 0) | (AngularPositionInDeg.Y >= 0.0f ? 2 : 0);
+    }
+
+private:
+    // Whether heap entry A should sit above B; ties go to the lower stimulus index so the order is deterministic
+    bool IsHigher(int32 A, int32 B) const
+    {
+        return Priorities[A] > Priorities[B] || (Priorities[A] == Priorities[B] && A < B);
+    }
+
+    void SiftUp(TArray<int32>& Heap, int32 Position);
+    void SiftDown(TArray<int32>& Heap, int32 Position);
+
+    // Stimulus indices in heap order, one heap per quadrant
+    TArray<int32> Heaps[NumQuadrants];
+
+    // Priority of each stimulus index; only meaningful while it is active
+    TArray<float> Priorities;
+
+    // Position of each stimulus index within its quadrant's heap, INDEX_NONE while inactive
+    TArray<int32> HeapPositions;
+
+    // Quadrant of each stimulus index
+    TArray<int32> Quadrants;
+
+    int32 NumActive;
+};
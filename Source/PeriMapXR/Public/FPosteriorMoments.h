@@ -0,0 +1,41 @@
+// FPosteriorMoments.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "FPosteriorMoments.generated.h"
+
+/**
+ * Summary of one location's threshold posterior. FThresholdPosteriorStore recomputes it in a single
+ * pass whenever the posterior changes, so reading it costs nothing between updates.
+ */
+USTRUCT(BlueprintType)
+struct PERIMAPXR_API FPosteriorMoments
+{
+    GENERATED_BODY()
+
+public:
+
+    // Posterior mean (in decibels)
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Posterior")
+    float MeanInDb;
+
+    // Posterior variance (in squared decibels)
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Posterior")
+    float Variance;
+
+    // Square root of the variance (in decibels)
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Posterior")
+    float StandardDeviationInDb;
+
+    // Most probable threshold level (in decibels)
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Posterior")
+    float ModeInDb;
+
+    // Shannon entropy of the posterior on FThresholdPosteriorStore::EntropyStepInDb bins (in nats), whatever the location's grid
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Posterior")
+    float Entropy;
+
+    FPosteriorMoments()
+        : MeanInDb(0.0f), Variance(0.0f), StandardDeviationInDb(0.0f), ModeInDb(0.0f), Entropy(0.0f) {}
+};
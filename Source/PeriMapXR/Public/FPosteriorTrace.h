@@ -0,0 +1,88 @@
+// FPosteriorTrace.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Fixed-size header written before each record's log-posterior values.
+ */
+struct FPosteriorTraceRecordHeader
+{
+    int32 LocationIndex;
+    int32 TrialNumber;
+    float StimulusIntensityInDb;
+    uint8 bSeen;
+    uint8 bLeftEye;
+    uint8 Padding[2];
+    float LevelOriginInDb;
+    float LevelStepInDb;
+};
+
+/**
+ * Header at the start of a dumped trace file.
+ */
+struct FPosteriorTraceFileHeader
+{
+    uint32 Magic;
+    uint32 Version;
+    int32 NumLevels;
+    int32 NumRecords;
+    float MinThresholdInDb;
+    float ThresholdStepSizeInDb;
+    int64 NumDropped;
+};
+
+/**
+ * Compact binary trace of the Bayesian updates, replacing per-update string logging.
+ * Every update copies (location index, trial number, intensity, response, log posterior) into a
+ * ring buffer allocated up front, so recording never allocates or formats on the game thread.
+ * Once full, the oldest records are overwritten. DumpAsync snapshots the buffer and writes it on
+ * a background thread; scripts/trace/decode_posterior_trace.py turns the file into CSV.
+ *
+ * File layout (little endian): FPosteriorTraceFileHeader, then NumRecords records of
+ * FPosteriorTraceRecordHeader followed by NumLevels float log-posterior values (unnormalized).
+ * Each record carries the grid its values sit on, since a location can be re-binned mid-test; the
+ * file header keeps the initial grid.
+ */
+class PERIMAPXR_API FPosteriorTrace
+{
+public:
+    // "PMXT" read as a little-endian uint32
+    static constexpr uint32 FileMagic = 0x54584D50;
+    static constexpr uint32 FileVersion = 2;
+
+    FPosteriorTrace();
+
+    // Preallocates room for InCapacity records; drops recorded data only if the layout changes
+    void Initialize(int32 InCapacity, int32 InNumLevels, float InMinThresholdInDb, float InThresholdStepSizeInDb);
+
+    // Drops every record while keeping the allocation
+    void Reset();
+
+    // Appends a record, overwriting the oldest one once the buffer is full
+    void Record(int32 LocationIndex, int32 TrialNumber, float StimulusIntensityInDb, bool bSeen, bool bLeftEye, float LevelOriginInDb, float LevelStepInDb, const float* LogPosterior);
+
+    // Snapshots the buffered records, oldest first, and writes them to FilePath on a background thread; false if empty
+    bool DumpAsync(const FString& FilePath) const;
+
+    bool IsInitialized() const { return Capacity > 0; }
+    int32 GetCapacity() const { return Capacity; }
+    int32 GetNumRecords() const { return (int32)FMath::Min<int64>(TotalRecorded, Capacity); }
+
+    // Records overwritten before they could be dumped
+    int64 GetNumDropped() const { return FMath::Max<int64>(TotalRecorded - Capacity, 0); }
+
+private:
+    int32 Capacity;
+    int32 NumLevels;
+    int32 RecordSize;
+    float MinThresholdInDb;
+    float ThresholdStepSizeInDb;
+
+    // Records written since the last reset; the next record goes to slot TotalRecorded % Capacity
+    int64 TotalRecorded;
+
+    // Capacity records of RecordSize bytes each
+    TArray<uint8> Buffer;
+};
@@ -0,0 +1,133 @@
+// FPsychometricLikelihoodTable.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Parameters of the cumulative Gaussian psychometric function shared by every location.
+ *
+ * Intensities are in the display's decibels, an attenuation of the maximum luminance (see
+ * AStimuli::SetBrightnessFromDb), and a threshold is the attenuation seen half the time: a
+ * stimulus is more likely seen the lower its intensity relative to the threshold.
+ */
+struct PERIMAPXR_API FPsychometricParameters
+{
+    float Slope;
+    float GuessRate;
+    float LapseRate;
+
+    FPsychometricParameters()
+        : Slope(3.0f), GuessRate(0.5f), LapseRate(0.01f)
+    {}
+
+    FPsychometricParameters(float InSlope, float InGuessRate, float InLapseRate)
+        : Slope(InSlope), GuessRate(InGuessRate), LapseRate(InLapseRate)
+    {}
+
+    bool operator==(const FPsychometricParameters& Other) const
+    {
+        return Slope == Other.Slope && GuessRate == Other.GuessRate && LapseRate == Other.LapseRate;
+    }
+
+    bool operator!=(const FPsychometricParameters& Other) const
+    {
+        return !(*this == Other);
+    }
+};
+
+/**
+ * Precomputed seen / not-seen likelihood rows for every (presented-intensity bin, threshold level) pair.
+ * Every location shares the same psychometric parameters and threshold grid, so the per-response
+ * Bayesian update becomes an element-wise add of one log-likelihood row instead of one erf per level.
+ * Linear rows are kept alongside for consumers that need response probabilities.
+ * The table rebuilds itself whenever the parameters or the grid it was built for change.
+ *
+ * A posterior row that covers only a window of the table's grid reads its likelihoods from a level
+ * offset into each row. Built with a stride wider than NumLevels, the table serves any window that
+ * starts on a level offset that is a multiple of FThresholdPosteriorStore::RowAlignment.
+ */
+class PERIMAPXR_API FPsychometricLikelihoodTable
+{
+public:
+    FPsychometricLikelihoodTable();
+
+    // Psychometric function (cumulative Gaussian): probability of seeing a stimulus at the given threshold; falls as the intensity rises
+    static float Evaluate(const FPsychometricParameters& Params, float StimulusIntensity, float ThresholdLevel);
+
+    // Rebuilds the table if the parameters or threshold grid differ from the ones it was built for; returns true on rebuild
+    bool EnsureBuilt(const FPsychometricParameters& InParams, float InMinThresholdInDb, float InThresholdStepSizeInDb, int32 InNumLevels, int32 InStride, float InIntensityBinSizeInDb);
+
+    // Marks the table stale so the next EnsureBuilt rebuilds it
+    void Invalidate() { bIsBuilt = false; }
+
+    // Index of the intensity bin nearest to a presented intensity, clamped to the table range
+    int32 GetIntensityBin(float StimulusIntensityInDb) const;
+
+    // Presented intensity (in dB) at the centre of an intensity bin
+    float GetBinIntensityInDb(int32 Bin) const { return MinThresholdInDb + Bin * IntensityBinSizeInDb; }
+
+    // Index of the table level a posterior window starting at LevelOriginInDb begins on
+    int32 GetLevelOffset(float LevelOriginInDb) const { return FMath::RoundToInt((LevelOriginInDb - MinThresholdInDb) / ThresholdStepSizeInDb); }
+
+    // Likelihood row for a response to a stimulus in the given bin, starting at a level offset
+    const float* GetLikelihoodRow(int32 Bin, bool bSeen, int32 LevelOffset = 0) const
+    {
+        return (bSeen ? SeenLikelihoods.GetData() : NotSeenLikelihoods.GetData()) + Bin * Stride + LevelOffset;
+    }
+
+    // Likelihood row for a response to a stimulus at the given intensity, starting at a level offset
+    const float* GetLikelihoodRow(float StimulusIntensityInDb, bool bSeen, int32 LevelOffset = 0) const
+    {
+        return GetLikelihoodRow(GetIntensityBin(StimulusIntensityInDb), bSeen, LevelOffset);
+    }
+
+    // 16-byte aligned log-likelihood row for a response to a stimulus in the given bin, starting at an aligned level offset
+    const float* GetLogLikelihoodRow(int32 Bin, bool bSeen, int32 LevelOffset = 0) const
+    {
+        return (bSeen ? SeenLogLikelihoods.GetData() : NotSeenLogLikelihoods.GetData()) + Bin * Stride + LevelOffset;
+    }
+
+    // Log-likelihood row for a response to a stimulus at the given intensity, starting at an aligned level offset
+    const float* GetLogLikelihoodRow(float StimulusIntensityInDb, bool bSeen, int32 LevelOffset = 0) const
+    {
+        return GetLogLikelihoodRow(GetIntensityBin(StimulusIntensityInDb), bSeen, LevelOffset);
+    }
+
+    // 16-byte aligned row of the response entropy (in nats) at each threshold level for the given bin, starting at a level offset
+    const float* GetResponseEntropyRow(int32 Bin, int32 LevelOffset = 0) const
+    {
+        return ResponseEntropies.GetData() + Bin * Stride + LevelOffset;
+    }
+
+    bool IsBuilt() const { return bIsBuilt; }
+    int32 GetNumBins() const { return NumBins; }
+    int32 GetNumLevels() const { return NumLevels; }
+    int32 GetStride() const { return Stride; }
+    const FPsychometricParameters& GetParameters() const { return Params; }
+
+private:
+    // Fills every table for the current parameters and grid
+    void Build();
+
+    // Parameters and grid the table was built for
+    FPsychometricParameters Params;
+    float MinThresholdInDb;
+    float ThresholdStepSizeInDb;
+    float IntensityBinSizeInDb;
+    int32 NumLevels;
+    int32 Stride;
+    int32 NumBins;
+    bool bIsBuilt;
+
+    // NumBins rows of Stride floats each; padding entries are 1 so they leave a product unchanged
+    TArray<float, TAlignedHeapAllocator<16>> SeenLikelihoods;
+    TArray<float, TAlignedHeapAllocator<16>> NotSeenLikelihoods;
+
+    // Log of the rows above; padding entries are 0 so they leave a sum unchanged
+    TArray<float, TAlignedHeapAllocator<16>> SeenLogLikelihoods;
+    TArray<float, TAlignedHeapAllocator<16>> NotSeenLogLikelihoods;
+
+    // Binary entropy of the seen / not-seen outcome per cell, used by the expected-entropy selector; padding entries are 0
+    TArray<float, TAlignedHeapAllocator<16>> ResponseEntropies;
+};
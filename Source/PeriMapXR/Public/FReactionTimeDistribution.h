@@ -0,0 +1,42 @@
+// FReactionTimeDistribution.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Running distribution of a participant's reaction times, kept as a histogram of fixed-width bins.
+ * Adding a reaction time is O(1) and a percentile is one pass over the bins, whatever the number of
+ * trials, so it can be queried before every trial. Times past the last bin are counted in it.
+ */
+class PERIMAPXR_API FReactionTimeDistribution
+{
+public:
+    // Resolution and range of the histogram
+    static constexpr float BinSeconds = 0.005f;
+    static constexpr int32 NumBins = 400;
+
+    FReactionTimeDistribution();
+
+    // Drops every reaction time
+    void Reset();
+
+    // Adds a reaction time (in seconds)
+    void Add(float ReactionTimeSeconds);
+
+    // Reaction time below which the given fraction (0-1) of the reaction times fall, at the upper edge of its bin; 0 while empty
+    float GetPercentile(float Fraction) const;
+
+    // Mean reaction time (in seconds); 0 while empty
+    float GetMean() const { return NumReactionTimes > 0 ? (float)(SumSeconds / NumReactionTimes) : 0.0f; }
+
+    // Number of reaction times added
+    int32 Num() const { return NumReactionTimes; }
+
+private:
+    // Reaction times per bin
+    TArray<int32> BinCounts;
+
+    int32 NumReactionTimes;
+    double SumSeconds;
+};
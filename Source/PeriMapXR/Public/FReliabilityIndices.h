@@ -0,0 +1,81 @@
+// FReliabilityIndices.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "FReliabilityIndices.generated.h"
+
+/**
+ * Catch-trial reliability of the eye being tested. Each catch trial updates the counts and the rates
+ * in constant time, so the indices are current after every trial and can be read live.
+ */
+USTRUCT(BlueprintType)
+struct PERIMAPXR_API FReliabilityIndices
+{
+    GENERATED_BODY()
+
+public:
+
+    // False-positive catch trials run: gaps with no stimulus in which a press is an error
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Reliability")
+    int32 NumFalsePositiveTrials;
+
+    // False-positive catch trials answered with a press
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Reliability")
+    int32 NumFalsePositives;
+
+    // False-negative catch trials run: bright stimuli at locations already seen, in which no press is an error
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Reliability")
+    int32 NumFalseNegativeTrials;
+
+    // False-negative catch trials missed
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Reliability")
+    int32 NumFalseNegatives;
+
+    // NumFalsePositives / NumFalsePositiveTrials, 0 before the first trial
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Reliability")
+    float FalsePositiveRate;
+
+    // NumFalseNegatives / NumFalseNegativeTrials, 0 before the first trial
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Reliability")
+    float FalseNegativeRate;
+
+    // Whether either rate is over its limit with enough catch trials behind it
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Reliability")
+    bool bIsUnreliable;
+
+    // Test trials pressed for sooner after onset than a reaction to the stimulus can be, which were discarded unscored
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Reliability")
+    int32 NumAnticipatoryResponses;
+
+    FReliabilityIndices()
+        : NumFalsePositiveTrials(0), NumFalsePositives(0), NumFalseNegativeTrials(0), NumFalseNegatives(0), FalsePositiveRate(0.0f), FalseNegativeRate(0.0f), bIsUnreliable(false), NumAnticipatoryResponses(0) {}
+
+    // Counts a false-positive catch trial
+    void AddFalsePositiveTrial(bool bPressed)
+    {
+        NumFalsePositiveTrials++;
+        NumFalsePositives += bPressed ? 1 : 0;
+        FalsePositiveRate = (float)NumFalsePositives / NumFalsePositiveTrials;
+    }
+
+    // Counts a false-negative catch trial
+    void AddFalseNegativeTrial(bool bSeen)
+    {
+        NumFalseNegativeTrials++;
+        NumFalseNegatives += bSeen ? 0 : 1;
+        FalseNegativeRate = (float)NumFalseNegatives / NumFalseNegativeTrials;
+    }
+
+    // Counts a test trial discarded for an anticipatory press
+    void AddAnticipatoryResponse()
+    {
+        NumAnticipatoryResponses++;
+    }
+
+    // Catch trials run of either kind
+    int32 GetNumTrials() const { return NumFalsePositiveTrials + NumFalseNegativeTrials; }
+
+    // Catch trials answered in error of either kind
+    int32 GetNumErrors() const { return NumFalsePositives + NumFalseNegatives; }
+};
@@ -0,0 +1,55 @@
+// FScriptedResponder.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FPsychometricLikelihoodTable.h"
+
+/**
+ * Synthetic participant for headless runs of ATestStimuli: stands in for the button press and the eye
+ * tracker. Each location gets a true threshold from a normal field (31 dB at fixation, falling 0.12 dB
+ * per degree, with some scatter), and each stimulus is seen with the probability the psychometric
+ * function gives for it, so the estimators face the same observer as in the simulation commandlet.
+ * Draws come from a seeded stream, so a run is repeatable. Game thread only.
+ */
+class PERIMAPXR_API FScriptedResponder
+{
+public:
+    FScriptedResponder();
+
+    // Draws the true thresholds for stimulus locations (relative to the fixation point) and restarts the stream from Seed
+    void Initialize(const TArray<FVector>& Locations, int32 Seed);
+
+    // Whether the participant sees a stimulus at a location and intensity; INDEX_NONE for a gap with nothing shown
+    bool DrawSeen(int32 LocationIndex, float StimulusIntensityInDb);
+
+    // Time from onset to the press for a stimulus that was seen (in seconds)
+    float DrawReactionTimeSeconds();
+
+    // Angle between the gaze and the fixation point (in degrees) for a sample taken DeltaSeconds after the previous one
+    float DrawGazeErrorInDeg(float DeltaSeconds);
+
+    // True threshold of a location (in decibels)
+    float GetTrueThresholdInDb(int32 LocationIndex) const { return TrueThresholdsInDb[LocationIndex]; }
+
+    // Psychometric function of the participant; the guess rate is their false-positive rate
+    FPsychometricParameters Params;
+
+    // Mean and spread of the reaction times (in seconds), never below MinReactionTimeSeconds
+    float MeanReactionTimeSeconds;
+    float ReactionTimeDeviationSeconds;
+    float MinReactionTimeSeconds;
+
+    // Rate at which the gaze leaves the fixation point (per second of samples)
+    float FixationLossesPerSecond;
+
+    // Largest gaze error while fixating, and the gaze error of a sample that has left the fixation point (in degrees)
+    float FixationJitterInDeg;
+    float FixationLossErrorInDeg;
+
+private:
+    FRandomStream Stream;
+
+    // True threshold per location (in decibels)
+    TArray<float> TrueThresholdsInDb;
+};
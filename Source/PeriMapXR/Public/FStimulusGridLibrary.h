@@ -0,0 +1,79 @@
+// FStimulusGridLibrary.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ETestType.h"
+
+/**
+ * One test point of a grid pattern, in degrees of visual field for the right eye: X is horizontal
+ * (positive temporal), Y is vertical (positive superior).
+ */
+struct FStimulusGridPoint
+{
+    int8 HorizontalInDeg;
+    int8 VerticalInDeg;
+};
+
+/**
+ * A grid laid out for one eye at one viewing distance. Point i is the same test location in every
+ * session, so results from different sessions line up by index.
+ */
+struct FStimulusGridLayout
+{
+    // Angular position of each point for the tested eye: X horizontal, Y vertical (in degrees)
+    TArray<FVector2D> AngularPositions;
+
+    // Position of each point relative to the fixation point, laid out like ATestStimuli::PolarToCartesian
+    TArray<FVector> Locations;
+
+    // Points that fall inside the physiological blind spot of the tested eye
+    TBitArray<> BlindSpotPoints;
+
+    int32 Num() const { return Locations.Num(); }
+};
+
+/**
+ * Standard perimetric grids (10-2, 24-2, 24-2C, 30-2) as compile-time tables, plus custom grids read
+ * from a file. Tables are written for the right eye; the left eye mirrors them horizontally, which
+ * also moves the blind spot to the other side. A layout's cartesian positions are computed the
+ * first time it is asked for at a given viewing distance and cached, so setting up a test is a
+ * lookup. Game thread only.
+ *
+ * Custom grid files hold one point per line as "Horizontal,Vertical" in degrees, right eye
+ * orientation; blank lines and lines starting with '#' are skipped.
+ */
+class PERIMAPXR_API FStimulusGridLibrary
+{
+public:
+    // Points of a standard pattern in right-eye orientation; empty for TEST_CUSTOM
+    static TArrayView<const FStimulusGridPoint> GetStandardPattern(ETestType TestType);
+
+    // Layout of a grid for an eye at a viewing distance, optionally without its blind-spot points. Custom
+    // grids are read from CustomGridPath; a file that cannot be read gives an empty layout
+    static const FStimulusGridLayout& GetLayout(ETestType TestType, bool bLeftEye, float ViewingDistance, bool bSkipBlindSpotPoints, const FString& CustomGridPath = FString());
+
+    // Reads a custom grid file; false (with the reason in OutError) if it cannot be read or holds no points
+    static bool LoadCustomPattern(const FString& Path, TArray<FVector2D>& OutPoints, FString& OutError);
+
+    // Mirrors a right-eye angular position for the tested eye
+    static FVector2D MirrorForEye(const FVector2D& RightEyePositionInDeg, bool bLeftEye)
+    {
+        return bLeftEye ? FVector2D(-RightEyePositionInDeg.X, RightEyePositionInDeg.Y) : RightEyePositionInDeg;
+    }
+
+    // Whether an angular position of the tested eye falls inside its blind spot
+    static bool IsInBlindSpot(const FVector2D& AngularPositionInDeg, bool bLeftEye);
+
+    // Position of an angular position at a viewing distance, relative to the fixation point
+    static FVector ToCartesian(const FVector2D& AngularPositionInDeg, float ViewingDistance);
+
+    // Drops every cached layout, e.g. after a custom grid file has changed
+    static void ClearCache();
+
+    // Blind spot of the right eye: centre and half-extents of the ellipse (in degrees)
+    static constexpr float BlindSpotHorizontalInDeg = 15.0f;
+    static constexpr float BlindSpotVerticalInDeg = -1.5f;
+    static constexpr float BlindSpotHalfWidthInDeg = 3.0f;
+    static constexpr float BlindSpotHalfHeightInDeg = 5.0f;
+};
@@ -0,0 +1,91 @@
+// FStimulusPresentation.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "FStimulusPresentation.generated.h"
+
+/**
+ * How one stimulus was actually shown. Presentation is counted in frames: the stimulus turns visible
+ * on one game frame and hidden on the frame FramesRequested later, so every trial is shown for a
+ * whole number of display frames whatever the timer granularity. Times are taken on the game thread
+ * at the frames that changed the visibility.
+ */
+USTRUCT(BlueprintType)
+struct PERIMAPXR_API FStimulusPresentation
+{
+    GENERATED_BODY()
+
+public:
+
+    // Stimulus shown, indexed like ATestStimuli::StimuliLocations
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    int32 StimulusIndex;
+
+    // Intensity shown (in decibels)
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    float IntensityInDb;
+
+    // Game frame (GFrameCounter) on which the stimulus turned visible
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    int64 OnsetFrame;
+
+    // FPlatformTime::Cycles64() at onset
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    int64 OnsetCycles;
+
+    // Frames the stimulus should stay visible for at the display refresh rate
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    int32 FramesRequested;
+
+    // Frames it actually stayed visible for; fewer than requested if the test was paused mid-flash
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    int32 FramesShown;
+
+    // Time from the onset frame to the offset frame (in seconds)
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    float ShownSeconds;
+
+    // Whether the presentation was cut short by a pause or a loss of fixation
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    bool bInterrupted;
+
+    // FPlatformTime::Cycles64() at the first press of the trial's response window, or 0 without one
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    int64 ResponseCycles;
+
+    // Time from onset to that press (in seconds), or a negative value without one
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    float ReactionTimeSeconds;
+
+    // Whether this was a false-negative catch trial rather than a test trial
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    bool bCatchTrial;
+
+    // Whether a gaze sample off the fixation point ended it early, discarding the trial
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    bool bFixationLost;
+
+    // Whether it was pressed for sooner than ATestStimuli::MinResponseSeconds after onset, discarding the trial
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    bool bAnticipatory;
+
+    // Largest angle between the gaze and the fixation point over the flash (in degrees), or a negative value without a valid sample
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    float GazeErrorInDeg;
+
+    // Whether the trial was answered as seen
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    bool bSeen;
+
+    // Whether the trial's outcome is final: its response window closed, its catch trial was scored or it was discarded
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    bool bOutcomeKnown;
+
+    // Whether it has been written to the trial journal
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Presentation")
+    bool bJournaled;
+
+    FStimulusPresentation()
+        : StimulusIndex(INDEX_NONE), IntensityInDb(0.0f), OnsetFrame(0), OnsetCycles(0), FramesRequested(0), FramesShown(0), ShownSeconds(0.0f), bInterrupted(false), ResponseCycles(0), ReactionTimeSeconds(-1.0f), bCatchTrial(false), bFixationLost(false), bAnticipatory(false), GazeErrorInDeg(-1.0f), bSeen(false), bOutcomeKnown(false), bJournaled(false) {}
+};
@@ -2,6 +2,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "EThresholdStrategy.h"
 #include "UObject/NoExportTypes.h"
 #include "FTestSettings.generated.h"
 
@@ -31,11 +32,14 @@ struct PERIMAPXR_API FTestSettings
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Test Settings")
     float MaxHorizontalAngle; // Max horizontal angle for stimuli distribution
 
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Test Settings")
+    EThresholdStrategy ThresholdStrategy; // Engine that picks intensities and decides when each location is complete
+
     FTestSettings()
-        : StimuliRadius(0.0f), StimuliDiameter(0.0f), FixationPointDiameter(0.0f), DegreeStep(0.0f), NumStimuli(0), MaxVerticalAngle(0.0f), MaxHorizontalAngle(0.0f)
+        : StimuliRadius(0.0f), StimuliDiameter(0.0f), FixationPointDiameter(0.0f), DegreeStep(0.0f), NumStimuli(0), MaxVerticalAngle(0.0f), MaxHorizontalAngle(0.0f), ThresholdStrategy(EThresholdStrategy::Bayesian)
     {}
 
-    FTestSettings(float InStimuliRadius, float InStimuliDiameter, float InFixationPointDiameter, float InDegreeStep, int32 InNumStimuli, float InMaxVerticalAngle, float InMaxHorizontalAngle)
-        : StimuliRadius(InStimuliRadius), StimuliDiameter(InStimuliDiameter), FixationPointDiameter(InFixationPointDiameter), DegreeStep(InDegreeStep), NumStimuli(InNumStimuli), MaxVerticalAngle(InMaxVerticalAngle), MaxHorizontalAngle(InMaxHorizontalAngle)
+    FTestSettings(float InStimuliRadius, float InStimuliDiameter, float InFixationPointDiameter, float InDegreeStep, int32 InNumStimuli, float InMaxVerticalAngle, float InMaxHorizontalAngle, EThresholdStrategy InThresholdStrategy = EThresholdStrategy::Bayesian)
+        : StimuliRadius(InStimuliRadius), StimuliDiameter(InStimuliDiameter), FixationPointDiameter(InFixationPointDiameter), DegreeStep(InDegreeStep), NumStimuli(InNumStimuli), MaxVerticalAngle(InMaxVerticalAngle), MaxHorizontalAngle(InMaxHorizontalAngle), ThresholdStrategy(InThresholdStrategy)
     {}
 };
\ No newline at end of file
@@ -0,0 +1,142 @@
+// FThresholdPosteriorStore.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FPosteriorMoments.h"
+
+/**
+ * Dense, index-addressed storage for the per-location threshold posteriors.
+ * Every location's posterior lives in one contiguous block with a fixed stride, so a trial
+ * touches a handful of cache lines and never hashes a location key. Per-location bookkeeping
+ * is kept as parallel arrays indexed by the same location index.
+ *
+ * Posteriors are stored unnormalized in the log domain. Each update is a single SIMD pass that
+ * adds a log-likelihood row and tracks the row maximum, so the posterior can never underflow.
+ * Whenever a row changes, one fused pass normalizes it around that running max and caches its
+ * mean, variance, mode, entropy and log normalizer; every query in between is a plain read.
+ *
+ * Every row holds NumLevels levels, but each location has its own level origin and step. A location
+ * starts on the grid given to Initialize and can be re-binned onto a finer window (see Rebin), so
+ * the cost of an update stays the same whatever the resolution.
+ */
+class PERIMAPXR_API FThresholdPosteriorStore
+{
+public:
+    // Number of floats each posterior row is padded to, one SIMD register wide
+    static constexpr int32 RowAlignment = 4;
+
+    // Bin width every posterior entropy is measured on, whatever the location's own grid (in decibels)
+    static constexpr float EntropyStepInDb = 1.0f;
+
+    FThresholdPosteriorStore();
+
+    // Lays out the threshold grid and allocates a uniform prior for each location
+    void Initialize(int32 InNumLocations, float InMinThresholdInDb, float InMaxThresholdInDb, float InThresholdStepSizeInDb);
+
+    // Releases every location while keeping the threshold grid
+    void Reset();
+
+    // Appends a new location with a uniform prior and returns its index
+    int32 AddLocation();
+
+    // Resets a single location to the uniform prior on the initial grid and clears its bookkeeping
+    void ResetLocation(int32 LocationIndex);
+
+    // Replaces a location's posterior with the given prior (NumLevels probabilities on its own levels, need not be normalized)
+    void SetPrior(int32 LocationIndex, const float* Probabilities);
+
+    // Resamples a location's posterior onto NumLevels levels starting at NewOriginInDb, NewStepInDb apart
+    void Rebin(int32 LocationIndex, float NewOriginInDb, float NewStepInDb);
+
+    // Adds a 16-byte aligned, stride-sized log-likelihood row to a location's log posterior
+    void ApplyLogLikelihood(int32 LocationIndex, const float* LogLikelihood);
+
+    // Cached mean, variance, mode and entropy of a location's posterior
+    const FPosteriorMoments& GetMoments(int32 LocationIndex) const { return Moments[LocationIndex]; }
+
+    // Mean of a location's posterior (in decibels)
+    float GetMean(int32 LocationIndex) const { return Moments[LocationIndex].MeanInDb; }
+
+    // Standard deviation of a location's posterior (in decibels)
+    float GetStandardDeviation(int32 LocationIndex) const { return Moments[LocationIndex].StandardDeviationInDb; }
+
+    // Log of the normalizing constant of a location's posterior, relative to its stored log values
+    float GetLogNormalizer(int32 LocationIndex) const { return LogNormalizers[LocationIndex]; }
+
+    // Writes a location's normalized posterior probabilities into OutProbabilities (NumLevels floats)
+    void GetPosterior(int32 LocationIndex, float* OutProbabilities) const;
+
+    bool IsValidIndex(int32 LocationIndex) const { return LocationIndex >= 0 && LocationIndex < NumLocations; }
+    int32 GetNumLocations() const { return NumLocations; }
+    int32 GetNumLevels() const { return NumLevels; }
+    int32 GetStride() const { return Stride; }
+    float GetMinThresholdInDb() const { return MinThresholdInDb; }
+    float GetThresholdStepSizeInDb() const { return ThresholdStepSizeInDb; }
+
+    // Levels of the initial grid in decibels, padded to the row stride; only valid for locations that were never re-binned
+    const float* GetThresholdLevelsInDb() const { return ThresholdLevelsInDb.GetData(); }
+
+    // First level of a location's own grid (in decibels)
+    float GetLevelOriginInDb(int32 LocationIndex) const { return LevelOrigins[LocationIndex]; }
+
+    // Spacing of a location's own grid (in decibels)
+    float GetLevelStepInDb(int32 LocationIndex) const { return LevelSteps[LocationIndex]; }
+
+    // Added to the Shannon entropy over a location's own levels to give it on EntropyStepInDb bins (in nats)
+    float GetEntropyOffset(int32 LocationIndex) const { return FMath::Loge(LevelSteps[LocationIndex] / EntropyStepInDb); }
+
+    // A level of a location's own grid (in decibels)
+    float GetLevelInDb(int32 LocationIndex, int32 Level) const { return LevelOrigins[LocationIndex] + Level * LevelSteps[LocationIndex]; }
+
+    // Whether a location has been moved off the initial grid
+    bool IsRebinned(int32 LocationIndex) const { return LevelSteps[LocationIndex] != ThresholdStepSizeInDb || LevelOrigins[LocationIndex] != MinThresholdInDb; }
+
+    // Start of a location's unnormalized log posterior row
+    float* GetLogPosterior(int32 LocationIndex) { return LogPosteriors.GetData() + LocationIndex * Stride; }
+    const float* GetLogPosterior(int32 LocationIndex) const { return LogPosteriors.GetData() + LocationIndex * Stride; }
+
+    // Largest value in a location's log posterior row
+    float GetRunningMax(int32 LocationIndex) const { return RunningMax[LocationIndex]; }
+
+    // Keeps track of consistent responses per location
+    TArray<int32> ConsistentResponsesCount;
+
+    // Number of responses applied per location
+    TArray<int32> TrialCounts;
+
+    // Stores whether estimation is complete per location
+    TArray<bool> bEstimationComplete;
+
+private:
+    // Writes the uniform prior into a location's row; padding lanes hold a large negative log value
+    void SetUniformPrior(int32 LocationIndex);
+
+    // Recomputes a location's cached moments and log normalizer in one pass over its row
+    void UpdateMoments(int32 LocationIndex);
+
+    int32 NumLocations;
+    int32 NumLevels;
+    int32 Stride;
+    float MinThresholdInDb;
+    float ThresholdStepSizeInDb;
+
+    // Threshold levels in decibels, shared by every location
+    TArray<float> ThresholdLevelsInDb;
+
+    // All log posteriors, NumLocations rows of Stride floats each
+    TArray<float, TAlignedHeapAllocator<16>> LogPosteriors;
+
+    // Maximum of each log posterior row, used as the log-sum-exp pivot and to rebase the next update
+    TArray<float> RunningMax;
+
+    // First level and level spacing of each row (in decibels)
+    TArray<float> LevelOrigins;
+    TArray<float> LevelSteps;
+
+    // Moments of each posterior, refreshed by every write to its row
+    TArray<FPosteriorMoments> Moments;
+
+    // Log-sum-exp of each log posterior row, refreshed alongside its moments
+    TArray<float> LogNormalizers;
+};
@@ -0,0 +1,141 @@
+// FTrialJournal.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include <atomic>
+
+class FRunnableThread;
+class FEvent;
+class IFileHandle;
+
+/**
+ * One presentation as written to the journal. Fixed size, so a journal cut short by a crash is
+ * still a whole number of records up to its last sync.
+ */
+struct FTrialJournalRecord
+{
+    // Position of the record in the journal, counted from 0
+    int32 Sequence;
+
+    // Stimulus index, or INDEX_NONE for a false-positive catch trial, which shows nothing
+    int32 StimulusIndex;
+
+    float IntensityInDb;
+
+    // Time from onset to the first press (in seconds), or a negative value without one
+    float ReactionTimeSeconds;
+
+    // Largest angle between the gaze and the fixation point over the flash (in degrees), or a negative value without a valid sample
+    float GazeErrorInDeg;
+
+    // Time the stimulus stayed on screen (in seconds)
+    float ShownSeconds;
+
+    // FPlatformTime::Cycles64() at onset and at the press (0 without one)
+    int64 OnsetCycles;
+    int64 ResponseCycles;
+
+    // GFrameCounter at onset
+    int64 OnsetFrame;
+
+    int32 FramesRequested;
+    int32 FramesShown;
+
+    uint8 bSeen;
+    uint8 bLeftEye;
+    uint8 bCatchTrial;
+    uint8 bFixationLost;
+    uint8 bInterrupted;
+    uint8 bAnticipatory;
+    uint8 Padding[2];
+};
+
+/**
+ * Header at the start of a journal file, written once when the file is created.
+ */
+struct FTrialJournalFileHeader
+{
+    uint32 Magic;
+    uint32 Version;
+    uint32 RecordSize;
+    uint32 Reserved;
+
+    // Converts the records' cycle counts to seconds
+    double SecondsPerCycle;
+
+    // Wall-clock time (FDateTime ticks, UTC) and FPlatformTime::Cycles64() when the journal was opened
+    int64 StartDateTimeTicks;
+    int64 StartCycles;
+};
+
+/**
+ * Append-only binary journal of every presentation, so a test survives a crash up to its last few
+ * trials. The game thread's Append is a memcpy into a ring of records allocated up front and an
+ * atomic store; a writer thread wakes every SyncIntervalSeconds (or on Close), writes whatever has
+ * been queued straight from the ring and syncs the file once per batch. If the writer falls a whole
+ * ring behind, new records are dropped and counted rather than blocking the game thread.
+ *
+ * Single producer: only the game thread calls Open, Append and Close.
+ *
+ * File layout (little endian): FTrialJournalFileHeader, then FTrialJournalRecord records until the
+ * end of the file; scripts/trace/decode_trial_journal.py turns it into CSV.
+ */
+class PERIMAPXR_API FTrialJournal : public FRunnable
+{
+public:
+    // "PMXJ" read as a little-endian uint32
+    static constexpr uint32 FileMagic = 0x4A584D50;
+    static constexpr uint32 FileVersion = 1;
+
+    // Records the ring holds between two writer passes
+    static constexpr int32 Capacity = 4096;
+
+    FTrialJournal();
+    virtual ~FTrialJournal();
+
+    // Opens a journal file, appending if it already exists, and starts the writer thread on it; false if a journal is
+    // already open or the file cannot be opened
+    bool Open(const FString& InFilePath, float InSyncIntervalSeconds);
+
+    // Queues a copy of a record, stamped with its sequence number; false if the ring is full and the record was dropped
+    bool Append(const FTrialJournalRecord& Record);
+
+    // Writes and syncs everything queued, then stops the writer thread
+    void Close();
+
+    bool IsOpen() const { return Thread != nullptr; }
+    const FString& GetFilePath() const { return FilePath; }
+
+    // Records dropped because the ring was full
+    int64 GetNumDropped() const { return NumDropped; }
+
+    // FRunnable: the writer loop, and the request to leave it
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    // Writes the records queued since the last pass and syncs the file; writer thread only
+    void WritePending();
+
+    // Capacity records; slot i % Capacity holds record i
+    TArray<FTrialJournalRecord> Ring;
+
+    // Records appended (game thread) and written (writer thread) since Open
+    std::atomic<uint64> NumAppended;
+    std::atomic<uint64> NumWritten;
+
+    std::atomic<bool> bStopRequested;
+    int64 NumDropped;
+
+    FString FilePath;
+    float SyncIntervalSeconds;
+
+    // Opened by Open, written only by the writer thread until Close has stopped it
+    TUniquePtr<IFileHandle> FileHandle;
+
+    // Wakes the writer before its interval is up
+    FEvent* WakeEvent;
+    FRunnableThread* Thread;
+};
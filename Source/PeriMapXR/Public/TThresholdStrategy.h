@@ -0,0 +1,324 @@
+// TThresholdStrategy.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EThresholdStrategy.h"
+#include "EStoppingRule.h"
+#include "EStimulusSelectionPolicy.h"
+#include "FThresholdPosteriorStore.h"
+#include "FPsychometricLikelihoodTable.h"
+#include "FExpectedEntropySelector.h"
+
+/**
+ * Per-location state of the staircase engines. Unused by the purely Bayesian engines.
+ */
+struct FStaircaseState
+{
+    // Intensity of the next presentation once the staircase has started (in decibels)
+    float NextIntensityInDb;
+
+    // Current step of the staircase (in decibels)
+    float StepSizeInDb;
+
+    // Highest (dimmest) intensity seen so far (in decibels), or -MAX_flt if nothing has been seen
+    float HighestSeenIntensityInDb;
+
+    // Number of response reversals so far
+    int32 NumReversals;
+
+    // Response to the last presentation: 1 seen, 0 not seen, INDEX_NONE before the first
+    int8 LastResponse;
+
+    // Presentations missed at the screening intensity
+    uint8 NumScreeningMisses;
+
+    FStaircaseState()
+        : NextIntensityInDb(0.0f), StepSizeInDb(0.0f), HighestSeenIntensityInDb(-MAX_flt), NumReversals(0), LastResponse(INDEX_NONE), NumScreeningMisses(0) {}
+};
+
+/**
+ * What an engine reads for one location: the posterior, the likelihood table covering the location's
+ * grid and the estimator settings. Engines never write to the posterior; the estimator updates it for
+ * every engine, so the trace, the live moments and the spatial priors work the same way whichever
+ * engine is running.
+ */
+struct FThresholdStrategyContext
+{
+    const FThresholdPosteriorStore& PosteriorStore;
+    const FPsychometricLikelihoodTable& LikelihoodTable;
+    EStimulusSelectionPolicy SelectionPolicy;
+
+    // Posterior standard deviation at which the Bayesian engine stops (in decibels)
+    float StoppingCriterionInDb;
+
+    // Whether the location's posterior is on its final resolution (always true without the adaptive grid)
+    bool bOnFinalGrid;
+
+    float MinThresholdInDb;
+    float MaxThresholdInDb;
+
+    // Age-expected suprathreshold intensity the screening engine presents at this location: brighter, so lower in decibels, than the expected threshold
+    float ScreeningIntensityInDb;
+
+    // Whether the screening engine thresholds a location once its defect is confirmed
+    bool bThresholdScreeningDefects;
+};
+
+/**
+ * Threshold strategy engines, one specialisation per EThresholdStrategy. Each provides:
+ *
+ *   SelectIntensityInDb(Context, State, LocationIndex)            next intensity to present
+ *   ApplyResponse(Context, State, LocationIndex, Intensity, bSeen)  advances the engine after the posterior
+ *                                                                  update; the engine's own rule that ends the
+ *                                                                  location, or EStoppingRule::None
+ *   GetThresholdInDb(Context, State, LocationIndex)               current threshold estimate
+ *
+ * Every function is static and inline. UThresholdEstimator switches on the strategy once per call and
+ * instantiates its update and selection paths for the chosen engine, so a trial carries no virtual
+ * dispatch and each engine's constants fold into its path.
+ *
+ * Intensities follow the display (see FPsychometricParameters): a higher intensity in decibels is a
+ * dimmer stimulus, so a seen response moves a staircase up and a missed one moves it down.
+ */
+template <EThresholdStrategy Strategy>
+struct TThresholdStrategy;
+
+/**
+ * Shared 4-2 style staircase: starts at the posterior mean (seeded from neighbours when spatial priors
+ * are on), steps by InitialStepInDb until the first reversal and by FinalStepInDb after it. A staircase
+ * also ends when the response would push it past either end of the range.
+ */
+template <int32 InitialStepInDb, int32 FinalStepInDb, int32 MaxReversals>
+struct TStaircaseEngine
+{
+    // Start of a staircase, rounded to a whole step of the initial grid
+    static float GetStartIntensityInDb(const FThresholdStrategyContext& Context, int32 LocationIndex)
+    {
+        return FMath::Clamp(FMath::RoundToFloat(Context.PosteriorStore.GetMean(LocationIndex)), Context.MinThresholdInDb, Context.MaxThresholdInDb);
+    }
+
+    static float SelectIntensityInDb(const FThresholdStrategyContext& Context, const FStaircaseState& State, int32 LocationIndex)
+    {
+        return State.LastResponse == INDEX_NONE ? GetStartIntensityInDb(Context, LocationIndex) : State.NextIntensityInDb;
+    }
+
+    static EStoppingRule ApplyResponse(const FThresholdStrategyContext& Context, FStaircaseState& State, int32 LocationIndex, float StimulusIntensityInDb, bool bSeen)
+    {
+        const int8 Response = bSeen ? 1 : 0;
+        if (State.LastResponse == INDEX_NONE)
+        {
+            State.StepSizeInDb = (float)InitialStepInDb;
+        }
+        else if (Response != State.LastResponse)
+        {
+            State.NumReversals++;
+            State.StepSizeInDb = (float)FinalStepInDb;
+        }
+        State.LastResponse = Response;
+
+        if (bSeen)
+        {
+            State.HighestSeenIntensityInDb = FMath::Max(State.HighestSeenIntensityInDb, StimulusIntensityInDb);
+        }
+
+        // Seen at the dim end of the range or missed at the bright end: the staircase cannot go any further
+        const bool bAtBound = bSeen ? StimulusIntensityInDb >= Context.MaxThresholdInDb : StimulusIntensityInDb <= Context.MinThresholdInDb;
+        if (bAtBound || State.NumReversals >= MaxReversals)
+        {
+            return EStoppingRule::StaircaseReversals;
+        }
+
+        State.NextIntensityInDb = FMath::Clamp(StimulusIntensityInDb + (bSeen ? State.StepSizeInDb : -State.StepSizeInDb), Context.MinThresholdInDb, Context.MaxThresholdInDb);
+        return EStoppingRule::None;
+    }
+
+    // Dimmest intensity seen; the bottom of the range if nothing was seen
+    static float GetStaircaseThresholdInDb(const FThresholdStrategyContext& Context, const FStaircaseState& State, int32 LocationIndex)
+    {
+        if (State.LastResponse == INDEX_NONE)
+        {
+            return Context.PosteriorStore.GetMean(LocationIndex);
+        }
+        return State.HighestSeenIntensityInDb != -MAX_flt ? State.HighestSeenIntensityInDb : Context.MinThresholdInDb;
+    }
+};
+
+/**
+ * The original engine: selection by SelectionPolicy (minimum expected entropy or posterior mean),
+ * stopping once the posterior standard deviation reaches StoppingCriterionInDb.
+ */
+template <>
+struct TThresholdStrategy<EThresholdStrategy::Bayesian>
+{
+    static float SelectIntensityInDb(const FThresholdStrategyContext& Context, const FStaircaseState& State, int32 LocationIndex)
+    {
+        const FThresholdPosteriorStore& Store = Context.PosteriorStore;
+        if (Context.SelectionPolicy == EStimulusSelectionPolicy::MinimumExpectedEntropy && Context.LikelihoodTable.IsBuilt())
+        {
+            return FExpectedEntropySelector::SelectIntensityInDb(Store, Context.LikelihoodTable, LocationIndex);
+        }
+
+        // Posterior mean, kept within the location's grid
+        return FMath::Clamp(Store.GetMean(LocationIndex), Store.GetLevelInDb(LocationIndex, 0), Store.GetLevelInDb(LocationIndex, Store.GetNumLevels() - 1));
+    }
+
+    static EStoppingRule ApplyResponse(const FThresholdStrategyContext& Context, FStaircaseState& State, int32 LocationIndex, float StimulusIntensityInDb, bool bSeen)
+    {
+        const bool bNarrow = Context.bOnFinalGrid && Context.PosteriorStore.GetStandardDeviation(LocationIndex) <= Context.StoppingCriterionInDb;
+        return bNarrow ? EStoppingRule::StandardDeviation : EStoppingRule::None;
+    }
+
+    static float GetThresholdInDb(const FThresholdStrategyContext& Context, const FStaircaseState& State, int32 LocationIndex)
+    {
+        return Context.PosteriorStore.GetMean(LocationIndex);
+    }
+};
+
+/**
+ * ZEST: always presents at the posterior mean and stops at a looser posterior standard deviation
+ * than the Bayesian engine, trading some precision for fewer presentations.
+ */
+template <>
+struct TThresholdStrategy<EThresholdStrategy::Zest>
+{
+    // Posterior standard deviation at which a location is complete (in decibels)
+    static constexpr float StoppingDeviationInDb = 1.5f;
+
+    static float SelectIntensityInDb(const FThresholdStrategyContext& Context, const FStaircaseState& State, int32 LocationIndex)
+    {
+        const FThresholdPosteriorStore& Store = Context.PosteriorStore;
+        return FMath::Clamp(Store.GetMean(LocationIndex), Store.GetLevelInDb(LocationIndex, 0), Store.GetLevelInDb(LocationIndex, Store.GetNumLevels() - 1));
+    }
+
+    static EStoppingRule ApplyResponse(const FThresholdStrategyContext& Context, FStaircaseState& State, int32 LocationIndex, float StimulusIntensityInDb, bool bSeen)
+    {
+        const bool bNarrow = Context.bOnFinalGrid && Context.PosteriorStore.GetStandardDeviation(LocationIndex) <= StoppingDeviationInDb;
+        return bNarrow ? EStoppingRule::StandardDeviation : EStoppingRule::None;
+    }
+
+    static float GetThresholdInDb(const FThresholdStrategyContext& Context, const FStaircaseState& State, int32 LocationIndex)
+    {
+        return Context.PosteriorStore.GetMean(LocationIndex);
+    }
+};
+
+/**
+ * Full threshold: a 4-2 dB staircase that ends on the second reversal and reports the dimmest
+ * intensity seen. The posterior is only used for the starting intensity.
+ */
+template <>
+struct TThresholdStrategy<EThresholdStrategy::FullThreshold42> : TStaircaseEngine<4, 2, 2>
+{
+    static float GetThresholdInDb(const FThresholdStrategyContext& Context, const FStaircaseState& State, int32 LocationIndex)
+    {
+        return GetStaircaseThresholdInDb(Context, State, LocationIndex);
+    }
+};
+
+/**
+ * SITA-like fast mode: a single 4 dB staircase that ends on the first reversal, or earlier once the
+ * posterior is narrow enough. The threshold is the posterior mean, so the prior and every response
+ * contribute to it rather than only the last seen intensity.
+ */
+template <>
+struct TThresholdStrategy<EThresholdStrategy::SitaFast> : TStaircaseEngine<4, 4, 1>
+{
+    // Posterior standard deviation at which a location is complete before its reversal (in decibels)
+    static constexpr float StoppingDeviationInDb = 2.0f;
+
+    static EStoppingRule ApplyResponse(const FThresholdStrategyContext& Context, FStaircaseState& State, int32 LocationIndex, float StimulusIntensityInDb, bool bSeen)
+    {
+        const EStoppingRule StaircaseRule = TStaircaseEngine<4, 4, 1>::ApplyResponse(Context, State, LocationIndex, StimulusIntensityInDb, bSeen);
+        if (StaircaseRule != EStoppingRule::None)
+        {
+            return StaircaseRule;
+        }
+        const bool bNarrow = Context.bOnFinalGrid && Context.PosteriorStore.GetStandardDeviation(LocationIndex) <= StoppingDeviationInDb;
+        return bNarrow ? EStoppingRule::StandardDeviation : EStoppingRule::None;
+    }
+
+    static float GetThresholdInDb(const FThresholdStrategyContext& Context, const FStaircaseState& State, int32 LocationIndex)
+    {
+        return Context.PosteriorStore.GetMean(LocationIndex);
+    }
+};
+
+/**
+ * Suprathreshold screening: presents every location once at its age-expected suprathreshold intensity
+ * and re-tests only the misses. A location passes on its first seen response and is a defect once it
+ * has been missed twice; a confirmed defect is then optionally thresholded by a 4 dB staircase
+ * brightening from the screening intensity. The threshold reported is the dimmest intensity seen, a
+ * lower bound for a passed location, or the bottom of the range for a defect that was not thresholded.
+ */
+template <>
+struct TThresholdStrategy<EThresholdStrategy::SuprathresholdScreening>
+{
+    // Misses at the screening intensity that confirm a defect
+    static constexpr uint8 MissesForDefect = 2;
+
+    // Step of the staircase that thresholds a confirmed defect (in decibels)
+    static constexpr int32 DefectStepInDb = 4;
+
+    using FDefectStaircase = TStaircaseEngine<DefectStepInDb, DefectStepInDb, 1>;
+
+    static float SelectIntensityInDb(const FThresholdStrategyContext& Context, const FStaircaseState& State, int32 LocationIndex)
+    {
+        return State.NumScreeningMisses < MissesForDefect ? Context.ScreeningIntensityInDb : State.NextIntensityInDb;
+    }
+
+    static EStoppingRule ApplyResponse(const FThresholdStrategyContext& Context, FStaircaseState& State, int32 LocationIndex, float StimulusIntensityInDb, bool bSeen)
+    {
+        // Thresholding a confirmed defect: the location stays a defect whatever the staircase finds
+        if (State.NumScreeningMisses >= MissesForDefect)
+        {
+            return FDefectStaircase::ApplyResponse(Context, State, LocationIndex, StimulusIntensityInDb, bSeen) == EStoppingRule::None ? EStoppingRule::None : EStoppingRule::ScreeningDefect;
+        }
+
+        State.LastResponse = bSeen ? 1 : 0;
+        if (bSeen)
+        {
+            State.HighestSeenIntensityInDb = FMath::Max(State.HighestSeenIntensityInDb, StimulusIntensityInDb);
+            return EStoppingRule::ScreeningPassed;
+        }
+
+        // A first miss leaves the location pending, so the scheduler re-tests it later from another quadrant
+        if (++State.NumScreeningMisses < MissesForDefect)
+        {
+            return EStoppingRule::None;
+        }
+        if (!Context.bThresholdScreeningDefects || StimulusIntensityInDb <= Context.MinThresholdInDb)
+        {
+            return EStoppingRule::ScreeningDefect;
+        }
+
+        // The staircase picks up from the second miss, brightening until the first reversal
+        State.StepSizeInDb = (float)DefectStepInDb;
+        State.NextIntensityInDb = FMath::Clamp(StimulusIntensityInDb - State.StepSizeInDb, Context.MinThresholdInDb, Context.MaxThresholdInDb);
+        return EStoppingRule::None;
+    }
+
+    static float GetThresholdInDb(const FThresholdStrategyContext& Context, const FStaircaseState& State, int32 LocationIndex)
+    {
+        return FDefectStaircase::GetStaircaseThresholdInDb(Context, State, LocationIndex);
+    }
+};
+
+// Calls Function with a default-constructed engine for Strategy; the engine's type selects the instantiation
+template <typename FunctionType>
+FORCEINLINE decltype(auto) VisitThresholdStrategy(EThresholdStrategy Strategy, FunctionType&& Function)
+{
+    switch (Strategy)
+    {
+    case EThresholdStrategy::FullThreshold42:
+        return Function(TThresholdStrategy<EThresholdStrategy::FullThreshold42>());
+    case EThresholdStrategy::Zest:
+        return Function(TThresholdStrategy<EThresholdStrategy::Zest>());
+    case EThresholdStrategy::SitaFast:
+        return Function(TThresholdStrategy<EThresholdStrategy::SitaFast>());
+    case EThresholdStrategy::SuprathresholdScreening:
+        return Function(TThresholdStrategy<EThresholdStrategy::SuprathresholdScreening>());
+    default:
+        return Function(TThresholdStrategy<EThresholdStrategy::Bayesian>());
+    }
+}
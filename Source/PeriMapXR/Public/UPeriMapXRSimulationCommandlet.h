@@ -0,0 +1,49 @@
+// UPeriMapXRSimulationCommandlet.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "UPeriMapXRSimulationCommandlet.generated.h"
+
+class UThresholdEstimator;
+
+/**
+ * Headless Monte Carlo simulator for threshold strategies. Drives UThresholdEstimator with
+ * synthetic observers (known true thresholds, configurable slope, false-positive and
+ * false-negative rates) across every core and reports trials per eye, the error distribution
+ * and wall-clock throughput. Needs no HMD or renderer:
+ *
+ *   UnrealEditor-Cmd PeriMapXR.uproject -run=PeriMapXRSimulation -nullrhi -unattended
+ *       [-Eyes=1000] [-Test=24-2|24-2C|30-2|10-2|Custom] [-Grid=Path.csv] [-SkipBlindSpot] [-Slope=3] [-FP=0.03] [-FN=0.03] [-DefectRate=0.25]
+ *       [-Seed=1] [-Strategy=Bayesian|FullThreshold|ZEST|SITAFast|Screening] [-Policy=Entropy|Mean] [-NoSpatialPriors] [-AdaptiveGrid] [-MatchModel] [-MaxTrialsPerEye=10000]
+ *       [-EntropyStopping] [-MaxPresentations=40] [-EyeBudget=0] [-NoInformationScheduling]
+ *       [-SeenSeconds=1.2] [-MissedSeconds=1.2] [-Age=50] [-ThresholdDefects]
+ *
+ * SeenSeconds and MissedSeconds are the test time a seen or missed trial takes, for the reported test
+ * time, the information-rate schedule and EyeBudget, the per-eye time budget in seconds.
+ *
+ * Age and ThresholdDefects apply to -Strategy=Screening: the patient age behind the screening
+ * intensities, and whether confirmed defects are thresholded. A screening run also checks that the
+ * eyes drawn with a defect come out with a ScreeningDefect location, and returns 1 if too few do.
+ *
+ * Grids come from FStimulusGridLibrary, laid out for the right eye; -Test=Custom reads -Grid.
+ *
+ * Slope, FP and FN accept comma-separated lists; every combination is simulated as its own configuration.
+ */
+UCLASS()
+class PERIMAPXR_API UPeriMapXRSimulationCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UPeriMapXRSimulationCommandlet();
+
+    // Runs the simulation described by the command line and logs a report per configuration
+    virtual int32 Main(const FString& Params) override;
+
+private:
+    // One estimator per worker, created on the game thread and reused for every eye that worker simulates
+    UPROPERTY()
+    TArray<UThresholdEstimator*> Estimators;
+};
@@ -0,0 +1,103 @@
+// UStimulusFieldComponent.h
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "FLogManager.h"
+#include "UStimulusFieldComponent.generated.h"
+
+class UMaterialInterface;
+class UMaterialInstanceDynamic;
+class UStaticMeshComponent;
+
+/**
+ * Every stimulus of a test as one instance of a single instanced mesh, drawn in one call. Brightness
+ * and visibility are per-instance custom data, so flashing a stimulus writes two floats instead of
+ * touching an actor, and the component stops drawing altogether while no stimulus is visible.
+ *
+ * The material (M_StimuliInstanced) reads PerInstanceCustomData[BrightnessDataIndex] as the
+ * brightness that M_Stimuli takes from its "Brightness" parameter, and masks the instance out while
+ * PerInstanceCustomData[VisibilityDataIndex] is 0.
+ *
+ * Until that material is in the project, the field draws each stimulus the way AStimuli does: its own
+ * mesh component under the field, with a dynamic instance of M_Stimuli whose "Brightness" parameter is
+ * set per flash. The interface is the same either way, and the components are reused across eyes.
+ */
+UCLASS(ClassGroup = (PeriMapXR), meta = (BlueprintSpawnableComponent))
+class PERIMAPXR_API UStimulusFieldComponent : public UInstancedStaticMeshComponent
+{
+    GENERATED_BODY()
+
+public:
+    // Sets up the sphere mesh and the instanced stimulus material
+    UStimulusFieldComponent();
+
+    // Custom data layout of each instance
+    static constexpr int32 BrightnessDataIndex = 0;
+    static constexpr int32 VisibilityDataIndex = 1;
+    static constexpr int32 NumStimulusDataFloats = 2;
+
+    // Sets the field to one hidden, dark stimulus per location (relative to this component), each DesiredDiameter across.
+    // Existing instances are moved and reset in place when the count matches, so a new eye or a restart allocates nothing
+    void InitializeField(const TArray<FVector>& RelativeLocations, float DesiredDiameter);
+
+    // Removes every stimulus
+    void ClearField();
+
+    // Sets the brightness of a stimulus from its intensity in decibels, as AStimuli::SetBrightnessFromDb does
+    void SetBrightnessFromDb(int32 StimulusIndex, float dBValue);
+
+    // Shows or hides a stimulus
+    void SetStimulusVisibility(int32 StimulusIndex, bool bVisible);
+
+    // Hides every stimulus
+    void HideAllStimuli();
+
+    // Number of stimuli in the field
+    int32 GetNumStimuli() const { return VisibleStimuli.Num(); }
+
+    // Whether the stimuli are drawn as instances (M_StimuliInstanced found) rather than one mesh component each
+    bool IsInstanced() const { return bUseInstancing; }
+
+    // Max output of the stimulus in nits
+    UPROPERTY(EditDefaultsOnly, Category = "Stimulus Settings")
+    float MaxLuminanceNits;  // 60 nits for Pico 4
+
+    // Max brightness for Unreal Engine material (0-1)
+    UPROPERTY(EditDefaultsOnly, Category = "Stimulus Settings")
+    float MaxBrightness;
+
+    // Settings for message toggling
+    bool bEnableConsoleMessages;
+    bool bEnableOnScreenMessages;
+    bool bEnableSaveToLog;
+
+private:
+    // Sets up one mesh component per location for the per-stimulus path, reusing the existing ones
+    void InitializeStimulusMeshes(const TArray<FVector>& RelativeLocations, const FVector& Scale);
+
+    // Whether M_StimuliInstanced was found; false draws every stimulus with its own mesh component
+    bool bUseInstancing;
+
+    // M_Stimuli, for the per-stimulus path
+    UPROPERTY()
+    UMaterialInterface* StimulusMaterial;
+
+    // Per-stimulus path: one mesh component and dynamic material per stimulus, indexed like the instances
+    UPROPERTY(Transient)
+    TArray<UStaticMeshComponent*> StimulusMeshes;
+
+    UPROPERTY(Transient)
+    TArray<UMaterialInstanceDynamic*> StimulusMaterials;
+
+    // Visibility of each stimulus, mirroring its custom data
+    TBitArray<> VisibleStimuli;
+
+    // Number of stimuli currently visible; the component is hidden while this is 0
+    int32 NumVisibleStimuli;
+
+    // Instance of FLogManager to call in this class, ensures initiation of GEngine
+    FLogManager LogManager;
+    FString LogMessage;
+};
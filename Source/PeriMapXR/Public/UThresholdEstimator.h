@@ -7,12 +7,47 @@
 #include "FTestResults.h"
 #include "FTestSettings.h"
 #include "ETestType.h"
+#include "EStimulusSelectionPolicy.h"
+#include "EStoppingRule.h"
+#include "FThresholdPosteriorStore.h"
+#include "FPsychometricLikelihoodTable.h"
+#include "FLocationAdjacency.h"
+#include "FLocationScheduler.h"
+#include "FPosteriorTrace.h"
+#include "TThresholdStrategy.h"
 #include "UThresholdEstimator.generated.h"
 
 /**
  * UThresholdEstimator class encapsulates all threshold estimation logic,
  * including managing per-location estimations, recording results, and
  * calculating final thresholds and sensitivities.
+ *
+ * Locations are addressed by integer stimulus index. The FVector overloads are a thin
+ * Blueprint shim that maps a location to its index, registering it on first use.
+ *
+ * With spatial priors enabled, a few primary seed locations (one per quadrant) are tested first.
+ * Whenever a location completes, every untested location within NeighbourRadiusInDeg gets a prior
+ * built from the posteriors of its completed neighbours, and the test grows outward from there.
+ *
+ * With the adaptive grid enabled, every location starts on a coarse grid spanning the whole range.
+ * Once its posterior narrows, it is re-binned onto a fine window around the mode with the same number
+ * of levels, and the window follows the mode if it drifts towards an edge. Updates cost the same at
+ * either resolution; a location only completes once it is on the fine grid.
+ *
+ * The threshold strategy (FTestSettings::ThresholdStrategy) decides which intensity is presented, when
+ * a location is complete and what its threshold is; see TThresholdStrategy. Every strategy updates the
+ * posterior, so the trace, the moments and the spatial priors are available whichever one is running.
+ *
+ * Besides the strategy's own rule, a location also completes on posterior entropy or on the
+ * presentation cap, and every remaining location completes once the eye's time budget runs out.
+ * While the budget is tight the remaining presentations go to the locations where the next one is
+ * expected to tell the most. The rule that ended each location is kept (see GetStoppingRuleAtIndex).
+ *
+ * With information-rate scheduling, the locations under test (the primary seeds, then the growing
+ * frontier, or every pending location without spatial priors) sit in an FLocationScheduler keyed by
+ * the expected information gain of their next presentation per expected second of test time, and the
+ * next location comes from a different quadrant than the last one. If only the last quadrant has
+ * locations under test, the best waiting location from another quadrant is brought forward.
  */
 UCLASS(Blueprintable, BlueprintType)
 class PERIMAPXR_API UThresholdEstimator : public UObject
@@ -28,27 +63,96 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
     void Initialize(const FTestSettings& TestSettings, ETestType TestType, bool bIsLeftEye);
 
-    // Updates the estimator with a user's response at a location
+    // Registers the stimulus locations in presentation order; each location's index is its position in the array
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    void RegisterLocations(const TArray<FVector>& Locations);
+
+    // Gets the stimulus index for a location, or INDEX_NONE if it has not been registered
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    int32 GetLocationIndex(const FVector& Location) const;
+
+    // Updates the estimator with a user's response at a location, registering it on its first response. Not while a test is running on the task graph
     UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
     void UpdateWithResponse(const FVector& Location, float StimulusIntensity, bool bSeen);
 
-    // Gets the next stimulus intensity for a location (in decibels)
+    // Updates the estimator with a user's response at a stimulus index
     UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
-    float GetNextStimulusIntensityInDb(const FVector& Location);
+    void UpdateWithResponseAtIndex(int32 LocationIndex, float StimulusIntensity, bool bSeen);
 
-    // Gets the next luminance for a location (in nits)
+    // Gets the stimulus index to present after PreviousIndex, or INDEX_NONE once every location is complete
     UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
-    float GetNextLuminanceForLocation(const FVector& Location);
+    int32 GetNextLocationIndex(int32 PreviousIndex) const;
 
-    // Checks if threshold estimation is complete for a location
+    // Checks if a stimulus index is one of the primary seed locations
     UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
-    bool IsThresholdEstimationComplete(const FVector& Location);
+    bool IsPrimarySeedAtIndex(int32 LocationIndex) const;
 
-    // Gets the estimated threshold for a location (in decibels)
+    // Gets the number of responses applied across every location of the current eye
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    int32 GetTotalPresentations() const;
+
+    // Gets the next stimulus intensity for a location (in decibels); the middle of the range for an unregistered location
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    float GetNextStimulusIntensityInDb(const FVector& Location) const;
+
+    // Gets the next stimulus intensity for a stimulus index (in decibels)
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    float GetNextStimulusIntensityInDbAtIndex(int32 LocationIndex) const;
+
+    // Gets the next luminance for a location (in nits); 0 for an unregistered location
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    float GetNextLuminanceForLocation(const FVector& Location) const;
+
+    // Gets the next luminance for a stimulus index (in nits)
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    float GetNextLuminanceAtIndex(int32 LocationIndex) const;
+
+    // Checks if threshold estimation is complete for a location; true for an unregistered location
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    bool IsThresholdEstimationComplete(const FVector& Location) const;
+
+    // Checks if threshold estimation is complete for a stimulus index
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    bool IsThresholdEstimationCompleteAtIndex(int32 LocationIndex) const;
+
+    // Gets the threshold a location completed with (in decibels), or 0 while it is still being tested
     UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
     float GetThresholdEstimateInDb(const FVector& Location);
 
-    // Calculates final thresholds and sensitivities after the test is complete
+    // Gets the current threshold estimate of the active strategy for a stimulus index (in decibels)
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    float GetThresholdEstimateInDbAtIndex(int32 LocationIndex) const;
+
+    // Gets the rule that ended a location, or None while it is still being tested
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    EStoppingRule GetStoppingRule(const FVector& Location) const;
+
+    // Gets the rule that ended a stimulus index, or None while it is still being tested
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    EStoppingRule GetStoppingRuleAtIndex(int32 LocationIndex) const;
+
+    // Gets the test time spent on the current eye (in seconds), as counted against EyeTimeBudgetInSeconds
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    float GetEyeElapsedSeconds() const;
+
+    // Checks whether the remaining time budget no longer covers the presentations the pending locations are expected to need
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    bool IsEyeTimeBudgetTight() const;
+
+    // Gets the cached posterior mean, variance, mode and entropy for a location. Not while a test is running on the
+    // task graph; a live operator display reads ATestStimuli::GetLivePosteriorMoments instead
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    FPosteriorMoments GetPosteriorMoments(const FVector& Location) const;
+
+    // Gets the cached posterior mean, variance, mode and entropy for a stimulus index
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    FPosteriorMoments GetPosteriorMomentsAtIndex(int32 LocationIndex) const;
+
+    // Gets the strategy chosen by the test settings passed to Initialize
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    EThresholdStrategy GetThresholdStrategy() const { return ThresholdStrategy; }
+
+    // Collects the thresholds of the current eye's completed locations into the map GetFinalThresholdsInDb returns
     UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
     void CalculateFinalThresholds();
     
@@ -67,57 +171,201 @@ public:
     // Records a stimulus result
     void RecordStimulusResult(const FVector& Location, bool bSeen, float ThresholdLevel);
 
+    // Moves the stimulus indices completed since the last call into OutIndices, for the owner to publish
+    void TakeCompletedLocationIndices(TArray<int32>& OutIndices);
+
+    // Set by FAsyncThresholdEstimator while its task chain owns the estimator; the game-thread accessors check it
+    void SetOwnedByTaskGraph(bool bOwned) { bOwnedByTaskGraph = bOwned; }
+
     // Checks if retesting can be skipped at a location
     UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
     bool ShouldSkipRetest(const FVector& Location);
 
+    // Checks if retesting can be skipped at a stimulus index
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    bool ShouldSkipRetestAtIndex(int32 LocationIndex) const;
+
+    // Writes the binary posterior trace to FilePath on a background thread; false if nothing has been recorded
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation|Debug")
+    bool DumpPosteriorTrace(const FString& FilePath) const;
+
+    // Sets the psychometric function parameters and rebuilds the likelihood tables for them
+    UFUNCTION(BlueprintCallable, Category = "Threshold Estimation")
+    void SetPsychometricParameters(float InSlope, float InGuessRate, float InLapseRate);
+
+    // Parameters for the psychometric function, shared by every location
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Psychometric")
+    float Slope;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Psychometric")
+    float GuessRate;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Psychometric")
+    float LapseRate;
+
+    // Width of the presented-intensity bins in the likelihood tables (in decibels)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Psychometric")
+    float IntensityBinSizeInDb;
+
+    // How the next stimulus intensity is chosen from the posterior; the posterior mean unless set otherwise
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation")
+    EStimulusSelectionPolicy SelectionPolicy;
+
+    // Seeds untested locations from completed neighbours and tests primary seed points first; off by default
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Spatial Prior")
+    bool bUseSpatialPriors;
+
+    // Angular radius within which completed locations inform a neighbour's prior (in degrees)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Spatial Prior")
+    float NeighbourRadiusInDeg;
+
+    // Share of the prior taken from the neighbours; the rest stays uniform so a local defect can still be found
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Spatial Prior", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+    float NeighbourPriorWeight;
+
+    // Extra spread added to the neighbours' posteriors to allow for real differences between locations (in decibels)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Spatial Prior")
+    float NeighbourPriorSpreadInDb;
+
+    // Horizontal and vertical eccentricity of the primary seed point in each quadrant (in degrees)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Spatial Prior")
+    float PrimarySeedAngleInDeg;
+
+    // Starts every location on a coarse grid and re-bins it onto a fine window once its posterior narrows
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Adaptive Grid")
+    bool bUseAdaptiveGrid;
+
+    // Level spacing of the initial grid when the adaptive grid is enabled (in decibels)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Adaptive Grid")
+    float CoarseThresholdStepSizeInDb;
+
+    // Level spacing of the refined window (in decibels); the window holds as many levels as the coarse grid
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Adaptive Grid")
+    float FineThresholdStepSizeInDb;
+
+    // Coarse posterior standard deviation at which a location is re-binned onto the fine window (in decibels)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Adaptive Grid")
+    float GridRefinementDeviationInDb;
+
+    // Posterior standard deviation at which the Bayesian strategy completes a location (in decibels)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Stopping")
+    float StoppingCriterionInDb;
+
+    // Also completes a location once its posterior entropy reaches StoppingEntropyInNats
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Stopping")
+    bool bUseEntropyStopping;
+
+    // Posterior entropy on 1 dB bins at which a location completes (in nats); a Gaussian with a 1 dB deviation has 1.42
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Stopping")
+    float StoppingEntropyInNats;
+
+    // Presentations after which a location completes with its current estimate; 0 for no cap
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Stopping", meta = (ClampMin = "0"))
+    int32 MaxPresentationsPerLocation;
+
+    // Test time after which every remaining location of the eye completes (in seconds); 0 for no budget. Each response
+    // counts SeenPresentationSeconds or MissedPresentationSeconds, so pauses, the frame rate and time dilation do not. Set before RegisterLocations
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Stopping", meta = (ClampMin = "0.0"))
+    float EyeTimeBudgetInSeconds;
+
+    // Presents the location with the most expected information per second next, never from the same quadrant twice in a row;
+    // off by default, which keeps the registered order
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Scheduling")
+    bool bScheduleByInformationRate;
+
+    // Expected test time taken by a presentation that is seen (in seconds), including the gap before the next one
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Scheduling", meta = (ClampMin = "0.01"))
+    float SeenPresentationSeconds;
+
+    // Expected test time taken by a presentation that is missed (in seconds), including the gap before the next one
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Scheduling", meta = (ClampMin = "0.01"))
+    float MissedPresentationSeconds;
+
+    // Age of the patient, for the age-expected screening intensities (in years). Set before RegisterLocations
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Screening", meta = (ClampMin = "0.0"))
+    float PatientAgeInYears;
+
+    // How much brighter than the age-expected threshold the screening strategy presents (in decibels)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Screening", meta = (ClampMin = "0.0"))
+    float ScreeningOffsetInDb;
+
+    // Expected threshold at fixation of a normal eye at the reference age (in decibels)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Screening")
+    float NormalThresholdAtFixationInDb;
+
+    // Fall of the expected threshold per degree of eccentricity (in decibels)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Screening")
+    float NormalThresholdEccentricitySlopeInDb;
+
+    // Fall of the expected threshold per year of age past NormalReferenceAgeInYears (in decibels)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Screening")
+    float NormalThresholdAgeSlopeInDb;
+
+    // Age up to which the expected threshold does not change (in years)
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Screening")
+    float NormalReferenceAgeInYears;
+
+    // Thresholds each location the screening strategy confirms as a defect
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Screening")
+    bool bThresholdScreeningDefects;
+
+    // Records every update into the binary posterior trace, dumped alongside the results; off by default
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Debug")
+    bool bEnablePosteriorTrace;
+
+    // Number of updates the trace holds before overwriting the oldest; applied on the next Initialize
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Threshold Estimation|Debug")
+    int32 PosteriorTraceCapacity;
+
 private:
-    // Inner class for per-location threshold estimation
-    class LocationEstimator
-    {
-    public:
-        LocationEstimator(UThresholdEstimator* InParentEstimator);
-        ~LocationEstimator();
+    // Adds the log-likelihood of the response to the posterior at a stimulus index
+    void UpdateProbabilityDistribution(int32 LocationIndex, float StimulusIntensity, bool bSeen);
+
+    // Selects the next stimulus intensity to present at a stimulus index (in dB)
+    float SelectNextStimulusIntensityInDb(int32 LocationIndex) const;
 
-        void Initialize();
+    // What the strategy engines read for a stimulus index
+    FThresholdStrategyContext MakeStrategyContext(int32 LocationIndex) const;
 
-        void UpdateProbabilityDistribution(float StimulusIntensity, bool bSeen);
+    // Marks a stimulus index complete with the strategy's threshold estimate and the rule that ended it
+    void CompleteLocation(int32 LocationIndex, EStoppingRule Rule);
 
-        float SelectNextStimulusIntensityInDb();
-        float SelectNextLuminance();  // Converts dB to luminance in nits
+    // Pending stimulus index whose next presentation has the highest expected information gain
+    int32 GetMostInformativeLocationIndex() const;
 
-        bool IsThresholdEstimationComplete(float StoppingCriterion);
+    // Recomputes the cached information gain of a stimulus index's next presentation and its place in the schedule;
+    // only kept while a time budget or information-rate scheduling is on
+    void RefreshInformationGain(int32 LocationIndex);
 
-        float GetThresholdEstimateInDb();
+    // Whether a stimulus index belongs in the schedule: pending, and a primary seed or on the frontier when spatial priors are on
+    bool IsSchedulable(int32 LocationIndex) const;
 
-        // Keeps track of consistent responses
-        int32 ConsistentResponsesCount;
+    // Asserts that the game thread is not reading or changing the estimator while the task chain owns it
+    void CheckGameThreadAccess() const;
 
-        // Stores whether estimation is complete
-        bool bEstimationComplete;
+    // Rebuilds the likelihood tables if the psychometric parameters or threshold grid have changed
+    void EnsureLikelihoodTables();
 
-    private:
-        // Pointer to the outer UThresholdEstimator class
-        UThresholdEstimator* ParentEstimator;
+    // Likelihood table covering a stimulus index's current grid
+    const FPsychometricLikelihoodTable& GetLikelihoodTableForLocation(int32 LocationIndex) const;
 
-        TArray<float> PossibleThresholdLevelsInDb;  // Threshold levels in decibels
-        TArray<float> ProbabilityDistribution;
+    // Re-bins a stimulus index onto the fine window once it has narrowed, or re-centres the window on a drifting mode
+    void UpdateAdaptiveGrid(int32 LocationIndex);
 
-        void NormalizeProbabilityDistribution();
+    // Origin of the fine window centred on a level (in decibels), aligned so the fine table rows stay SIMD-aligned
+    float GetFineWindowOriginInDb(float CenterInDb) const;
 
-        float PsychometricFunction(float StimulusIntensity, float ThresholdLevel);  
+    // Rebuilds the neighbour table and primary seeds for the registered locations
+    void BuildAdjacency();
 
-        // Parameters for the psychometric function
-        float Slope;
-        float GuessRate;
-        float LapseRate;
+    // Propagates a completed location to its neighbours, seeding the ones that have not been tested yet
+    void OnLocationComplete(int32 LocationIndex);
 
-        // Stopping criterion for standard deviation
-        float StoppingCriterion;
+    // Replaces an untested location's prior with one built from its completed neighbours
+    void SeedPriorFromNeighbours(int32 LocationIndex);
 
-        // Helper to convert dB to luminance (nits)
-        float ConvertDbToLuminance(float dBValue);
-    };
+    // Helper to convert dB to luminance (nits)
+    static float ConvertDbToLuminance(float dBValue);
 
     // Maps to store results for both eyes separately
     TMap<FVector, float> LeftEyeThresholds;
@@ -135,8 +383,77 @@ private:
     TMap<FVector, float>& GetCurrentThresholdMap();
     TMap<FVector, float>& GetCurrentSensitivityMap();
 
-    // Smart pointer for memory management
-    TMap<FVector, TUniquePtr<LocationEstimator>> LocationEstimators;
+    // Dense per-location posteriors, addressed by stimulus index
+    FThresholdPosteriorStore PosteriorStore;
+
+    // Shim from Blueprint-facing locations to stimulus indices
+    TMap<FVector, int32> LocationIndices;
+
+    // Location of each stimulus index
+    TArray<FVector> IndexedLocations;
+
+    // Seen / not-seen likelihood rows shared by every location
+    FPsychometricLikelihoodTable LikelihoodTable;
+
+    // Likelihood rows over the whole range at the fine step; re-binned locations read a window of each row
+    FPsychometricLikelihoodTable FineLikelihoodTable;
+
+    // Neighbours of each stimulus index, built once per grid
+    FLocationAdjacency Adjacency;
+
+    // Set when a location is registered through the shim after the neighbour table was built
+    bool bAdjacencyDirty;
+
+    // Whether each stimulus index is a primary seed location
+    TArray<bool> bPrimarySeeds;
+
+    // Number of completed neighbours per stimulus index
+    TArray<int32> CompletedNeighbourCounts;
+
+    // Age-expected suprathreshold intensity of each stimulus index (in decibels), laid out with the neighbour table
+    TArray<float> ScreeningIntensitiesInDb;
+
+    // Strategy chosen by the current test settings
+    EThresholdStrategy ThresholdStrategy;
+
+    // Staircase progress per stimulus index, used by the staircase strategies
+    TArray<FStaircaseState> StaircaseStates;
+
+    // Rule that ended each stimulus index, None while it is pending
+    TArray<EStoppingRule> StoppingRules;
+
+    // Stimulus indices completed since TakeCompletedLocationIndices was last called
+    TArray<int32> RecentlyCompletedIndices;
+
+    // Whether FAsyncThresholdEstimator's task chain currently owns the estimator
+    bool bOwnedByTaskGraph;
+
+    // Expected information gain of each stimulus index's next presentation (in nats), refreshed whenever its posterior changes
+    TArray<float> InformationGains;
+
+    // Locations under test, keyed by information gain per second
+    FLocationScheduler Scheduler;
+
+    // Pending locations not yet under test, keyed the same way; drawn on only to avoid repeating a quadrant
+    FLocationScheduler WaitingScheduler;
+
+    // Every pending location keyed by information gain alone, for spending a tight time budget
+    FLocationScheduler GainScheduler;
+
+    // Responses applied to the current eye, the share of them spent on completed locations, and the completed locations;
+    // kept as they change so the time budget never rescans the locations
+    int32 TotalPresentations;
+    int32 CompletedPresentations;
+    int32 NumCompletedLocations;
+
+    // Primary seed locations not yet complete; the frontier opens once this reaches zero
+    int32 NumPendingPrimarySeeds;
+
+    // Test time of the responses applied since the last Initialize, counted against the eye's time budget (in seconds)
+    float EyeElapsedSeconds;
+
+    // Ring buffer of (location, trial, intensity, response, posterior) records
+    FPosteriorTrace PosteriorTrace;
 
     // Final thresholds and sensitivities for each location
     TMap<FVector, float> FinalThresholdsInDb;
@@ -145,20 +462,16 @@ private:
     // Test results
     TArray<FTestResults> TestResultsArray;
 
-    // Consistency map for retest skipping
-    TMap<FVector, int32> ConsistencyMap;
-
     // Threshold estimation parameters
     float MinThresholdInDb;
     float MaxThresholdInDb;
     float StepSize;
     float ThresholdStepSizeInDb;
-    float StoppingCriterionInDb;
 
     // Is left eye being tested
     bool bIsLeftEye;
 
     // Helper functions
-    LocationEstimator* GetOrCreateLocationEstimator(const FVector& Location);
+    int32 GetOrAddLocationIndex(const FVector& Location);
     void CleanupEstimators();
 };
\ No newline at end of file
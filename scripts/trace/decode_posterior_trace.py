@@ -0,0 +1,89 @@
+import argparse
+import csv
+import math
+import struct
+from pathlib import Path
+
+# Layouts mirror FPosteriorTraceFileHeader and FPosteriorTraceRecordHeader in FPosteriorTrace.h
+FILE_MAGIC = 0x54584D50
+FILE_HEADER = struct.Struct("<IIiiffq")
+
+# Version 1 records sit on the file header's grid; version 2 records carry their own level origin and step
+RECORD_HEADERS = {1: struct.Struct("<iifBB2x"), 2: struct.Struct("<iifBB2xff")}
+
+
+def normalize(log_posterior):
+    """Turns unnormalized log-posterior values into probabilities (log-sum-exp around the max)."""
+    peak = max(log_posterior)
+    weights = [math.exp(value - peak) for value in log_posterior]
+    total = sum(weights)
+    return [weight / total for weight in weights]
+
+
+def decode(trace_path: Path, csv_path: Path):
+    data = trace_path.read_bytes()
+    magic, version, num_levels, num_records, min_db, step_db, num_dropped = FILE_HEADER.unpack_from(data, 0)
+    if magic != FILE_MAGIC:
+        raise ValueError(f"{trace_path} is not a posterior trace file!")
+    if version not in RECORD_HEADERS:
+        raise ValueError(f"Unsupported posterior trace version {version}!")
+
+    record_header = RECORD_HEADERS[version]
+    posterior = struct.Struct(f"<{num_levels}f")
+    record_size = record_header.size + posterior.size
+
+    with csv_path.open("w", newline="") as csv_file:
+        writer = csv.writer(csv_file)
+        writer.writerow(
+            ["Record", "Eye", "LocationIndex", "Trial", "IntensityDb", "Seen", "MeanDb", "SdDb", "LevelOriginDb", "LevelStepDb"]
+            + [f"P{i}" for i in range(num_levels)]
+        )
+
+        offset = FILE_HEADER.size
+        for record in range(num_records):
+            location_index, trial, intensity, seen, left_eye, *grid = record_header.unpack_from(data, offset)
+            origin_db, level_step_db = grid if grid else (min_db, step_db)
+            probabilities = normalize(posterior.unpack_from(data, offset + record_header.size))
+            offset += record_size
+
+            levels = [origin_db + i * level_step_db for i in range(num_levels)]
+            mean = sum(p * level for p, level in zip(probabilities, levels))
+            variance = sum(p * (level - mean) ** 2 for p, level in zip(probabilities, levels))
+            writer.writerow(
+                [record, "Left" if left_eye else "Right", location_index, trial, f"{intensity:.3f}", seen, f"{mean:.3f}", f"{math.sqrt(variance):.3f}", f"{origin_db:g}", f"{level_step_db:g}"]
+                + [f"{p:.6g}" for p in probabilities]
+            )
+
+    print(f"Decoded {num_records} records ({num_dropped} overwritten before the dump) to {csv_path}")
+
+
+def main():
+    """
+    How to run the script:
+        python decode_posterior_trace.py \
+            --trace-path /path/to/PosteriorTrace.bin \
+            --csv-path /path/to/PosteriorTrace.csv
+    """
+    parser = argparse.ArgumentParser("Decode a PeriMapXR posterior trace into CSV.")
+    parser.add_argument(
+        "--trace-path", type=Path, required=True, help="Path to the binary trace file."
+    )
+    parser.add_argument(
+        "--csv-path",
+        type=Path,
+        default=None,
+        help="Path to csv file. If not provided, the csv is written next to the trace file.",
+    )
+    args = parser.parse_args()
+
+    if not args.trace_path.exists():
+        raise ValueError(f"{args.trace_path} does not exist!")
+
+    if args.csv_path is None:
+        args.csv_path = args.trace_path.with_suffix(".csv")
+
+    decode(args.trace_path, args.csv_path)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,78 @@
+import argparse
+import csv
+import struct
+from pathlib import Path
+
+# Layouts mirror FTrialJournalFileHeader and FTrialJournalRecord in FTrialJournal.h
+FILE_MAGIC = 0x4A584D50
+FILE_VERSION = 1
+FILE_HEADER = struct.Struct("<IIIIdqq")
+RECORD = struct.Struct("<iiffffqqqiiBBBBBB2x")
+
+
+def decode(journal_path: Path, csv_path: Path):
+    data = journal_path.read_bytes()
+    magic, version, record_size, _, seconds_per_cycle, start_ticks, start_cycles = FILE_HEADER.unpack_from(data, 0)
+    if magic != FILE_MAGIC:
+        raise ValueError(f"{journal_path} is not a trial journal file!")
+    if version != FILE_VERSION or record_size != RECORD.size:
+        raise ValueError(f"Unsupported trial journal version {version} (record size {record_size})!")
+
+    # A journal cut short by a crash may end in a partial record, which is skipped
+    num_records = (len(data) - FILE_HEADER.size) // RECORD.size
+
+    with csv_path.open("w", newline="") as csv_file:
+        writer = csv.writer(csv_file)
+        writer.writerow(
+            ["Sequence", "Eye", "LocationIndex", "IntensityDb", "Seen", "CatchTrial", "FixationLost", "Interrupted", "Anticipatory",
+             "ReactionTimeS", "GazeErrorDeg", "OnsetS", "ResponseS", "OnsetFrame", "FramesRequested", "FramesShown", "ShownS"]
+        )
+
+        for record in range(num_records):
+            (sequence, location_index, intensity, reaction_time, gaze_error, shown_seconds, onset_cycles, response_cycles,
+             onset_frame, frames_requested, frames_shown, seen, left_eye, catch_trial, fixation_lost, interrupted, anticipatory
+             ) = RECORD.unpack_from(data, FILE_HEADER.size + record * RECORD.size)
+
+            # Times are seconds since the journal was opened
+            onset = (onset_cycles - start_cycles) * seconds_per_cycle if onset_cycles else ""
+            response = (response_cycles - start_cycles) * seconds_per_cycle if response_cycles else ""
+            writer.writerow(
+                [sequence, "Left" if left_eye else "Right", location_index, f"{intensity:.3f}", seen, catch_trial, fixation_lost, interrupted, anticipatory,
+                 f"{reaction_time:.4f}" if reaction_time >= 0 else "", f"{gaze_error:.2f}" if gaze_error >= 0 else "",
+                 f"{onset:.4f}" if onset != "" else "", f"{response:.4f}" if response != "" else "",
+                 onset_frame, frames_requested, frames_shown, f"{shown_seconds:.4f}"]
+            )
+
+    print(f"Decoded {num_records} records to {csv_path}")
+
+
+def main():
+    """
+    How to run the script:
+        python decode_trial_journal.py \
+            --journal-path /path/to/TrialJournal.bin \
+            --csv-path /path/to/TrialJournal.csv
+    """
+    parser = argparse.ArgumentParser("Decode a PeriMapXR trial journal into CSV.")
+    parser.add_argument(
+        "--journal-path", type=Path, required=True, help="Path to the binary journal file."
+    )
+    parser.add_argument(
+        "--csv-path",
+        type=Path,
+        default=None,
+        help="Path to csv file. If not provided, the csv is written next to the journal file.",
+    )
+    args = parser.parse_args()
+
+    if not args.journal_path.exists():
+        raise ValueError(f"{args.journal_path} does not exist!")
+
+    if args.csv_path is None:
+        args.csv_path = args.journal_path.with_suffix(".csv")
+
+    decode(args.journal_path, args.csv_path)
+
+
+if __name__ == "__main__":
+    main()